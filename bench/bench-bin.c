@@ -0,0 +1,65 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "bench.h"
+
+/* a restart: get from a file on disk to one record of the document, through
+ * the text (parsed fully or lazily) or a snapshot */
+int main(int argc, char **argv) {
+    size_t records = argc > 1 ? strtoul(argv[1], 0, 10) : 20000;
+    size_t rounds = argc > 2 ? strtoul(argv[2], 0, 10) : 20;
+    So text = SO;
+    bench_document(&text, records);
+    Json_Auto_Value json = {0};
+    if(json_auto_parse(text, &json)) ABORT("parse");
+
+    char text_path[] = "/tmp/rljson-bench-text-XXXXXX";
+    char bin_path[] = "/tmp/rljson-bench-bin-XXXXXX";
+    int fd = mkstemp(text_path);
+    if(fd < 0 || write(fd, so_it(text, 0), so_len(text)) != (ssize_t)so_len(text)) ABORT("failed writing the text");
+    close(fd);
+    fd = mkstemp(bin_path);
+    if(fd < 0) ABORT("failed creating the snapshot");
+    close(fd);
+    if(json_auto_save_bin(&json, so_l(bin_path))) ABORT("failed writing the snapshot");
+    size_t middle = records / 2;
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+
+    printf("%zu records, %zu bytes of text, first access to record %zu\n", records, so_len(text), middle);
+    BENCH("text / read + parse", so_len(text), rounds, {
+        So content = SO;
+        Json_Auto_Value tmp = {0};
+        if(so_file_read(so_l(text_path), &content)) ABORT("read");
+        if(json_auto_parse(content, &tmp)) ABORT("parse");
+        if(!json_auto_get(json_auto_at(&tmp, middle), so("nested"))) ABORT("access");
+        json_auto_free(&tmp);
+        so_free(&content);
+    });
+    BENCH("text / read + parse lazy", so_len(text), rounds, {
+        So content = SO;
+        Json_Auto_Value tmp = {0};
+        if(so_file_read(so_l(text_path), &content)) ABORT("read");
+        if(json_auto_parse_lazy(content, &tmp, &settings)) ABORT("parse");
+        if(!json_auto_get(json_auto_at(&tmp, middle), so("nested"))) ABORT("access");
+        json_auto_free(&tmp);
+        so_free(&content);
+    });
+    BENCH("bin / load", so_len(text), rounds, {
+        Json_Auto_Bin bin;
+        if(json_auto_load_bin(so_l(bin_path), &bin)) ABORT("load");
+        if(!json_auto_get(json_auto_at(&bin.root, middle), so("nested"))) ABORT("access");
+        json_auto_bin_free(&bin);
+    });
+    BENCH("bin / load + check all", so_len(text), rounds, {
+        Json_Auto_Bin bin;
+        if(json_auto_load_bin(so_l(bin_path), &bin)) ABORT("load");
+        if(json_auto_bin_check(so_ll(bin.map, bin.size))) ABORT("check");
+        if(!json_auto_get(json_auto_at(&bin.root, middle), so("nested"))) ABORT("access");
+        json_auto_bin_free(&bin);
+    });
+
+    unlink(text_path);
+    unlink(bin_path);
+    json_auto_free(&json);
+    so_free(&text);
+    return 0;
+}
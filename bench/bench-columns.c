@@ -0,0 +1,73 @@
+#include "bench.h"
+
+static Json_Column_Spec spec[] = {
+    { {0}, JSON_COLUMN_SIZE },
+    { {0}, JSON_COLUMN_DOUBLE },
+    { {0}, JSON_COLUMN_STRING },
+    { {0}, JSON_COLUMN_BOOL },
+};
+
+static void bench_records(So *out, size_t records) {
+    so_push(out, '[');
+    for(size_t i = 0; i < records; ++i) {
+        so_fmt(out, "%s{\"ts\":%zu,\"v\":%.4f,\"tag\":\"sensor %zu\",\"ok\":%s,\"meta\":{\"unit\":\"C\"}}",
+                i ? "," : "", 1700000000 + i, (double)(i % 1000) / 7.0, i % 16, i % 3 ? "true" : "false");
+    }
+    so_push(out, ']');
+}
+
+/* what the columns replace: a tree, then columns out of it */
+static void bench_tree(So text, Json_Columns *columns) {
+    Json_Auto_Value json = {0};
+    if(json_auto_parse(text, &json)) ABORT("parse");
+    for(size_t i = 0; i < json_auto_len(&json); ++i) {
+        Json_Auto_Value *record = json_auto_at(&json, i);
+        Json_Auto_Value *ts = json_auto_get(record, so("ts"));
+        Json_Auto_Value *v = json_auto_get(record, so("v"));
+        Json_Auto_Value *tag = json_auto_get(record, so("tag"));
+        Json_Auto_Value *ok = json_auto_get(record, so("ok"));
+        array_push(columns->columns[0].sizes, ts ? ts->z : 0);
+        array_push(columns->columns[1].doubles, v ? v->f : 0);
+        array_push(columns->columns[2].strings, tag ? tag->so : SO);
+        array_push(columns->columns[3].bools, ok ? ok->b : false);
+    }
+    columns->rows = json_auto_len(&json);
+    json_auto_free(&json);
+}
+
+int main(int argc, char **argv) {
+    size_t records = argc > 1 ? strtoul(argv[1], 0, 10) : 100000;
+    size_t rounds = argc > 2 ? strtoul(argv[2], 0, 10) : 10;
+    So text = SO;
+    Json_Columns columns, tree;
+    spec[0].key = so("ts");
+    spec[1].key = so("v");
+    spec[2].key = so("tag");
+    spec[3].key = so("ok");
+    bench_records(&text, records);
+    json_columns_init(&columns, spec, 4);
+    json_columns_init(&tree, spec, 4);
+
+    printf("%zu records, %zu bytes of text\n", records, so_len(text));
+    BENCH("tree, then columns", so_len(text), rounds, {
+        json_columns_free(&tree);
+        json_columns_init(&tree, spec, 4);
+        bench_tree(text, &tree);
+    });
+    BENCH("columns", so_len(text), rounds, {
+        json_columns_clear(&columns);
+        if(json_columns_parse(&columns, text, 0)) ABORT("parse");
+    });
+
+    if(columns.rows != tree.rows) ABORT("row counts differ");
+    for(size_t i = 0; i < columns.rows; ++i) {
+        if(columns.columns[0].sizes[i] != tree.columns[0].sizes[i]
+                || columns.columns[1].doubles[i] != tree.columns[1].doubles[i]
+                || so_cmp(columns.columns[2].strings[i], tree.columns[2].strings[i])
+                || columns.columns[3].bools[i] != tree.columns[3].bools[i]) ABORT("columns differ in row %zu", i);
+    }
+    json_columns_free(&columns);
+    json_columns_free(&tree);
+    so_free(&text);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "bench.h"
+
+static void *bench_count(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    (void)key;
+    if(val) ++**(size_t **)user;
+    return bench_count;
+}
+
+int main(int argc, char **argv) {
+    size_t records = argc > 1 ? strtoul(argv[1], 0, 10) : 20000;
+    size_t rounds = argc > 2 ? strtoul(argv[2], 0, 10) : 10;
+    So text = SO;
+    bench_document(&text, records);
+
+    Json_Auto_Value json = {0};
+    if(json_auto_parse(text, &json)) ABORT("invalid document");
+    Json_Parser parser;
+    json_parser_init(&parser, 0);
+    size_t count = 0;
+
+    printf("%zu records, %zu bytes of text\n", records, so_len(text));
+    BENCH("text / parse", so_len(text), rounds, {
+        Json_Auto_Value tmp = {0};
+        if(json_auto_parse(text, &tmp)) ABORT("parse");
+        json_auto_free(&tmp);
+    });
+    BENCH("text / fmt", so_len(text), rounds, {
+        So out = SO;
+        json_auto_fmt(&out, json, &(Json_Auto_Fmt){0});
+        so_free(&out);
+    });
+    BENCH("text / callback", so_len(text), rounds, {
+        json_parser_reset(&parser);
+        if(json_parser_parse(&parser, text, bench_count, &count)) ABORT("parse");
+    });
+
+    const char *names[] = { "cbor", "msgpack" };
+    for(Json_Pack_List format = JSON_PACK_CBOR; format <= JSON_PACK_MSGPACK; ++format) {
+        So pack = SO;
+        json_auto_fmt_pack(&pack, &json, format);
+        char label[64];
+        printf("%s: %zu bytes\n", names[format], so_len(pack));
+        snprintf(label, sizeof(label), "%s / decode", names[format]);
+        BENCH(label, so_len(pack), rounds, {
+            Json_Auto_Value tmp = {0};
+            if(json_auto_from_pack(pack, &tmp, format)) ABORT("decode");
+            json_auto_free(&tmp);
+        });
+        snprintf(label, sizeof(label), "%s / encode", names[format]);
+        BENCH(label, so_len(pack), rounds, {
+            So out = SO;
+            json_auto_fmt_pack(&out, &json, format);
+            so_free(&out);
+        });
+        snprintf(label, sizeof(label), "%s / callback", names[format]);
+        BENCH(label, so_len(pack), rounds, {
+            json_parser_reset(&parser);
+            if(json_parser_parse_pack(&parser, pack, format, bench_count, &count)) ABORT("parse");
+        });
+        so_free(&pack);
+    }
+
+    /* what the callbacks get made up for: integers written out, long strings
+     * passed on as they are */
+    const char *extra[] = { "integers", "long strings" };
+    for(size_t k = 0; k < 2; ++k) {
+        So doc = SO, pack = SO;
+        Json_Auto_Value tmp = {0};
+        so_push(&doc, '[');
+        for(size_t i = 0; i < records * 4; ++i) {
+            if(i) so_push(&doc, ',');
+            if(!k) so_fmt(&doc, "%zu,-%zu", i * 7919, i * 104729);
+            else so_fmt(&doc, "\"record %zu, nothing to escape in here at all but it is a little longer\"", i);
+        }
+        so_push(&doc, ']');
+        if(json_auto_parse(doc, &tmp)) ABORT("invalid document");
+        json_auto_fmt_pack(&pack, &tmp, JSON_PACK_CBOR);
+        char label[64];
+        snprintf(label, sizeof(label), "cbor / callback, %s", extra[k]);
+        BENCH(label, so_len(pack), rounds, {
+            json_parser_reset(&parser);
+            if(json_parser_parse_pack(&parser, pack, JSON_PACK_CBOR, bench_count, &count)) ABORT("parse");
+        });
+        json_auto_free(&tmp);
+        so_free(&pack);
+        so_free(&doc);
+    }
+
+    json_parser_free(&parser);
+    json_auto_free(&json);
+    so_free(&text);
+    return count ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#include "bench.h"
+
+/* rows of doubles like embeddings, then a series of integers */
+static void bench_vectors(So *out, size_t rows, size_t dims) {
+    so_extend(out, so("{\"vectors\":["));
+    for(size_t i = 0; i < rows; ++i) {
+        if(i) so_push(out, ',');
+        so_push(out, '[');
+        for(size_t j = 0; j < dims; ++j) {
+            so_fmt(out, "%s%.6f", j ? "," : "", ((double)((i * 7919 + j * 104729) % 20001) - 10000.0) / 10007.0);
+        }
+        so_push(out, ']');
+    }
+    so_extend(out, so("],\"series\":["));
+    for(size_t i = 0; i < rows * dims; ++i) so_fmt(out, "%s%zu", i ? "," : "", 1700000000 + i * 15);
+    so_extend(out, so("]}"));
+}
+
+/* bytes held by the arrays of a tree, by what they hold */
+static size_t bench_bytes(Json_Auto_Value *v) {
+    size_t bytes = 0;
+    switch(v->id) {
+        case JSON_AUTO_VALUE_SIZES: return array_cap(v->sizes) * sizeof(*v->sizes);
+        case JSON_AUTO_VALUE_DOUBLES: return array_cap(v->doubles) * sizeof(*v->doubles);
+        case JSON_AUTO_VALUE_ARRAY: {
+            bytes = array_cap(v->arr) * sizeof(*v->arr);
+            for(size_t i = 0; i < array_len(v->arr); ++i) bytes += bench_bytes(array_it(v->arr, i));
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            bytes = array_cap(v->dict) * sizeof(*v->dict);
+            for(size_t i = 0; i < array_len(v->dict); ++i) bytes += bench_bytes(&array_it(v->dict, i)->val);
+        } break;
+        default: break;
+    }
+    return bytes;
+}
+
+static void bench_unpack(Json_Auto_Value *v) {
+    json_auto_materialize(v);
+    for(size_t i = 0; i < json_auto_len(v); ++i) bench_unpack(json_auto_at(v, i));
+}
+
+int main(int argc, char **argv) {
+    size_t rows = argc > 1 ? strtoul(argv[1], 0, 10) : 2000;
+    size_t dims = argc > 2 ? strtoul(argv[2], 0, 10) : 256;
+    size_t rounds = argc > 3 ? strtoul(argv[3], 0, 10) : 10;
+    So text = SO, out = SO;
+    Json_Auto_Fmt compact = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.pack = true;
+    bench_vectors(&text, rows, dims);
+
+    printf("%zu rows of %zu numbers and a series, %zu bytes of text\n", rows, dims, so_len(text));
+    BENCH("parse", so_len(text), rounds, {
+        Json_Auto_Value json = {0};
+        if(json_auto_parse(text, &json)) ABORT("parse");
+        json_auto_free(&json);
+    });
+    BENCH("parse packed", so_len(text), rounds, {
+        Json_Auto_Value json = {0};
+        if(json_auto_parse_ext(text, &json, &settings)) ABORT("parse");
+        json_auto_free(&json);
+    });
+
+    Json_Auto_Value json = {0};
+    if(json_auto_parse_ext(text, &json, &settings)) ABORT("parse");
+    json_auto_fmt(&out, json, &compact);
+    size_t out_len = so_len(out);
+    BENCH("fmt", out_len, rounds, {
+        so_clear(&out);
+        json_auto_fmt(&out, json, &compact);
+    });
+    size_t packed = bench_bytes(&json);
+    bench_unpack(&json);
+    BENCH("fmt unpacked", out_len, rounds, {
+        so_clear(&out);
+        json_auto_fmt(&out, json, &compact);
+    });
+    size_t unpacked = bench_bytes(&json);
+    printf("%-28s %9zu kB packed, %zu kB unpacked (%.1fx)\n", "memory", packed / 1000, unpacked / 1000, (double)unpacked / (double)packed);
+
+    json_auto_free(&json);
+    so_free(&text);
+    so_free(&out);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "bench.h"
+
+/* the same consumer twice: count scalars, sum up every "score" */
+typedef struct Bench_Sum {
+    size_t values;
+    double score;
+} Bench_Sum;
+
+static void *bench_callback(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    Bench_Sum *sum = *(Bench_Sum **)user;
+    if(!val) return bench_callback;
+    ++sum->values;
+    if(val->id == JSON_NUMBER && key.id == JSON_OBJECT && !so_cmp(key.s, so("score"))) {
+        double d = 0;
+        if(!so_as_double(val->s, &d)) sum->score += d;
+    }
+    return bench_callback;
+}
+
+static void bench_reader(So text, Bench_Sum *sum) {
+    Json_Reader reader;
+    Json_Reader_Event event;
+    bool score = false;
+    json_reader_init(&reader, text, 0);
+    while(!json_reader_next(&reader, &event) && event.id != JSON_READER_END) {
+        if(event.id == JSON_READER_KEY) {
+            score = !so_cmp(event.val.s, so("score"));
+        } else if(event.id == JSON_READER_VALUE) {
+            ++sum->values;
+            double d = 0;
+            if(score && event.val.id == JSON_NUMBER && !so_as_double(event.val.s, &d)) sum->score += d;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    size_t records = argc > 1 ? strtoul(argv[1], 0, 10) : 20000;
+    size_t rounds = argc > 2 ? strtoul(argv[2], 0, 10) : 10;
+    So text = SO;
+    bench_document(&text, records);
+    Bench_Sum sum_callback = {0}, sum_reader = {0};
+
+    printf("%zu records, %zu bytes of text\n", records, so_len(text));
+    BENCH("callback", so_len(text), rounds, {
+        if(json_parse(text, bench_callback, &sum_callback)) ABORT("parse");
+    });
+    BENCH("reader", so_len(text), rounds, {
+        bench_reader(text, &sum_reader);
+    });
+    BENCH("valid only", so_len(text), rounds, {
+        if(json_parse_valid(text)) ABORT("parse");
+    });
+
+    so_free(&text);
+    if(sum_callback.values != sum_reader.values || sum_callback.score != sum_reader.score) ABORT("callback and reader disagree");
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "bench.h"
+#include "../rljson/rljson-patch.h"
+
+/* modified copies of one large document: parsed again, cloned, or shared,
+ * and diffed against the original */
+int main(int argc, char **argv) {
+    size_t records = argc > 1 ? strtoul(argv[1], 0, 10) : 20000;
+    size_t rounds = argc > 2 ? strtoul(argv[2], 0, 10) : 20;
+    So text = SO, ops = SO;
+    bench_document(&text, records);
+    so_fmt(&ops, "[{\"op\":\"replace\",\"path\":\"/%zu/nested/y\",\"value\":1}]", records / 2);
+    Json_Auto_Value patch = {0}, base = {0};
+    if(json_auto_parse(ops, &patch)) ABORT("patch");
+    if(json_auto_parse(text, &base)) ABORT("parse");
+
+    printf("%zu records, %zu bytes of text, one replace per copy\n", records, so_len(text));
+    BENCH("parse + patch", so_len(text), rounds, {
+        Json_Auto_Value copy = {0};
+        if(json_auto_parse(text, &copy)) ABORT("parse");
+        if(json_auto_patch(&copy, &patch)) ABORT("patch");
+        json_auto_free(&copy);
+    });
+    BENCH("clone + patch", so_len(text), rounds, {
+        Json_Auto_Value copy = json_auto_clone(&base);
+        if(json_auto_patch(&copy, &patch)) ABORT("patch");
+        json_auto_free(&copy);
+    });
+    /* two versions kept side by side: the first diff hashes both, later ones
+     * only what got patched since */
+    size_t many = rounds * 100;
+    Json_Auto_Value a = json_auto_clone(&base), b = json_auto_clone(&base);
+    BENCH("patch + diff", so_len(text), many, {
+        Json_Auto_Value diff = {0};
+        if(json_auto_patch(&b, &patch)) ABORT("patch");
+        json_auto_diff(&a, &b, &diff);
+        if(json_auto_len(&diff) != 1) ABORT("diff");
+        json_auto_free(&diff);
+    });
+    BENCH("patch + diff (confirmed)", so_len(text), rounds, {
+        Json_Auto_Value diff = {0};
+        if(json_auto_patch(&b, &patch)) ABORT("patch");
+        json_auto_diff_ext(&a, &b, &diff, true);
+        if(json_auto_len(&diff) != 1) ABORT("diff");
+        json_auto_free(&diff);
+    });
+    json_auto_free(&a);
+    json_auto_free(&b);
+    double t0 = bench_now();
+    json_auto_share(&base);
+    printf("%-28s %9.3f ms\n", "share (once)", (bench_now() - t0) * 1e3);
+    BENCH("ref + patch", so_len(text), many, {
+        Json_Auto_Value copy = json_auto_ref(&base);
+        if(json_auto_patch(&copy, &patch)) ABORT("patch");
+        json_auto_free(&copy);
+    });
+
+    json_auto_free(&base);
+    json_auto_free(&patch);
+    so_free(&text);
+    so_free(&ops);
+    return 0;
+}
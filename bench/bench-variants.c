@@ -0,0 +1,58 @@
+#include "bench.h"
+
+static void *bench_callback(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    if(val) ++**(size_t **)user;
+    return bench_callback;
+}
+
+/* the generic scanners on a cursor, every setting read at runtime; the way
+ * json_parser_parse went before it picked a variant */
+static void bench_generic(Json_Parser *parser, So text, Json_Parse_Callback callback, void *user) {
+    Json_Parse_Value v = {0};
+    Json_Parse parse = {
+        .head = text,
+        .user = user,
+        .callback = callback,
+        .settings = parser->settings,
+        .parser = parser,
+    };
+    parser->nodes = 0;
+    json_parse_ws(&parse);
+    if(!json_parse_value(&parse, &v) || parse.head.len) ABORT("parse");
+}
+
+static void bench_variants(So text, size_t rounds, const char *label, Json_Parse_Settings *settings, bool callback) {
+    size_t values_generic = 0, values = 0;
+    char generic[64], variant[64];
+    snprintf(generic, sizeof(generic), "%s, generic", label);
+    snprintf(variant, sizeof(variant), "%s, variant", label);
+    Json_Parser parser;
+    json_parser_init(&parser, settings);
+    BENCH(generic, so_len(text), rounds, {
+        bench_generic(&parser, text, callback ? bench_callback : 0, &values_generic);
+    });
+    BENCH(variant, so_len(text), rounds, {
+        if(json_parser_parse(&parser, text, callback ? bench_callback : 0, &values)) ABORT("parse");
+    });
+    json_parser_free(&parser);
+    if(values != values_generic) ABORT("generic and variant disagree");
+}
+
+int main(int argc, char **argv) {
+    size_t records = argc > 1 ? strtoul(argv[1], 0, 10) : 20000;
+    size_t rounds = argc > 2 ? strtoul(argv[2], 0, 10) : 10;
+    So text = SO;
+    bench_document(&text, records);
+
+    printf("%zu records, %zu bytes of text\n", records, so_len(text));
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    bench_variants(text, rounds, "no callback", &settings, false);
+    bench_variants(text, rounds, "callback", &settings, true);
+    settings.strict = true;
+    bench_variants(text, rounds, "strict", &settings, true);
+    settings.limits = (Json_Parse_Limits){ .nodes = 1 << 30, .width = 1 << 20, .string = 1 << 16 };
+    bench_variants(text, rounds, "strict, limits", &settings, true);
+
+    so_free(&text);
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef RLJSON_BENCH_H
+
+#include "../rljson.h"
+
+#include <time.h>
+
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* records with a bit of everything, a few strings need escaping */
+static inline void bench_document(So *out, size_t records) {
+    so_extend(out, so("["));
+    for(size_t i = 0; i < records; ++i) {
+        if(i) so_extend(out, so(","));
+        so_fmt(out, "{\"id\":%zu,\"name\":\"record %zu\",\"score\":%.3f,\"active\":%s,"
+                "\"tags\":[\"a\",\"b\\\"c\",\"d\"],\"nested\":{\"x\":-%zu,\"y\":null}}",
+                i, i, (double)i / 7.0, i % 2 ? "true" : "false", i);
+    }
+    so_extend(out, so("]"));
+}
+
+#define BENCH(label, bytes, rounds, code)    do { \
+        double t0 = bench_now(); \
+        for(size_t r = 0; r < rounds; ++r) { code; } \
+        double dt = (bench_now() - t0) / rounds; \
+        printf("%-28s %9.3f ms %9.1f MB/s\n", label, dt * 1e3, (double)(bytes) / dt / 1e6); \
+    } while(0)
+
+#define RLJSON_BENCH_H
+#endif // RLJSON_BENCH_H
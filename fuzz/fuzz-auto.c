@@ -0,0 +1,47 @@
+#include "fuzz.h"
+
+/* eager, in-situ and lazy auto parsing agree on the decision and the tree,
+ * which a shared reference and a clone of it still hold */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    uint8_t options = fuzz_options(&data, &size);
+    So input = so_ll((const char *)data, size);
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.strict = options & 1;
+    Json_Auto_Value json = {0}, json_insitu = {0}, json_lazy = {0};
+    So insitu = SO;
+    so_extend(&insitu, input);
+
+    uint64_t t0 = fuzz_ns();
+    int result = json_auto_parse_ext(input, &json, &settings);
+    fuzz_time_check("json_auto_parse_ext", t0, size);
+
+    t0 = fuzz_ns();
+    int result_insitu = json_auto_parse_insitu(insitu, &json_insitu, &settings);
+    fuzz_time_check("json_auto_parse_insitu", t0, size);
+
+    t0 = fuzz_ns();
+    int result_lazy = json_auto_parse_lazy(input, &json_lazy, &settings);
+    fuzz_time_check("json_auto_parse_lazy", t0, size);
+
+    if(!result != !result_insitu || !result != !result_lazy) {
+        ABORT("auto parsing disagrees: %i, in-situ %i, lazy %i", result, result_insitu, result_lazy);
+    }
+    if(!result) {
+        t0 = fuzz_ns();
+        if(!json_auto_eq(&json, &json_insitu)) ABORT("in-situ tree differs");
+        if(!json_auto_eq(&json, &json_lazy)) ABORT("lazy tree differs");
+        fuzz_time_check("json_auto_eq", t0, size);
+
+        Json_Auto_Value ref = json_auto_ref(&json_lazy);
+        Json_Auto_Value clone = json_auto_clone(&ref);
+        if(!json_auto_eq(&json, &ref) || json_auto_hash(&json) != json_auto_hash(&ref)) ABORT("shared tree differs");
+        if(!json_auto_eq(&clone, &json_lazy)) ABORT("clone differs");
+        json_auto_free(&ref);
+        json_auto_free(&clone);
+    }
+    json_auto_free(&json);
+    json_auto_free(&json_insitu);
+    json_auto_free(&json_lazy);
+    so_free(&insitu);
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "fuzz.h"
+
+/* inputs known to hurt parsers, each built at two sizes: when the larger one
+ * takes a lot more than proportionally longer, something went superlinear.
+ * work that is superlinear in a bounded quantity (like depth, capped by
+ * JSON_DEPTH_MAX) scales fine, so there is an upper bound per byte as well.
+ * timings are the best of a few runs, the limits are generous */
+
+#define COMPLEXITY_SCALE        8
+#define COMPLEXITY_SLACK        3
+#define COMPLEXITY_RUNS         3
+#define COMPLEXITY_NS_PER_BYTE  2000
+
+typedef void (*Complexity_Build)(So *out, size_t n);
+typedef void (*Complexity_Run)(So input);
+
+static void build_nesting(So *out, size_t n) {
+    /* deep documents right below JSON_DEPTH_MAX, n / 4 kB of them */
+    size_t depth = JSON_DEPTH_MAX - 2;
+    so_push(out, '[');
+    for(size_t i = 0; i < n / 4096 + 1; ++i) {
+        if(i) so_push(out, ',');
+        for(size_t j = 0; j < depth; ++j) so_extend(out, j % 2 ? so("[") : so("{\"k\":"));
+        for(size_t j = depth; j > 0; --j) so_push(out, (j - 1) % 2 ? ']' : '}');
+    }
+    so_push(out, ']');
+}
+
+static void build_escapes(So *out, size_t n) {
+    so_extend(out, so("[\""));
+    for(size_t i = 0; i < n / 12; ++i) so_extend(out, so("\\n\\u00e9\\ud83d\\ude00"));
+    so_extend(out, so("\"]"));
+}
+
+static void build_keys(So *out, size_t n) {
+    so_push(out, '{');
+    for(size_t i = 0; i < n / 16; ++i) so_fmt(out, "%s\"key%zu\":%zu", i ? "," : "", i, i);
+    so_push(out, '}');
+}
+
+static void build_whitespace(So *out, size_t n) {
+    so_push(out, '[');
+    for(size_t i = 0; i < n; ++i) so_push(out, i % 2 ? '\n' : ' ');
+    so_push(out, ']');
+}
+
+static void build_digits(So *out, size_t n) {
+    so_push(out, '[');
+    for(size_t i = 0; i < n / 80; ++i) {
+        so_extend(out, i ? so(",") : so(""));
+        for(size_t j = 0; j < 79; ++j) so_push(out, '1' + (char)(j % 9));
+    }
+    so_push(out, ']');
+}
+
+static void build_invalid_depth(So *out, size_t n) {
+    build_nesting(out, n);
+    so_push(out, 'x');
+}
+
+static void run_parse(So input) {
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    Json_Parse_Error error = {0};
+    settings.error = &error;
+    if(json_parse_ext(input, 0, 0, &settings)) return;
+}
+
+static void run_valid(So input) {
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    if(json_valid(input, &settings)) return;
+}
+
+static void run_auto(So input) {
+    Json_Auto_Value json = {0};
+    So out = SO;
+    if(!json_auto_parse(input, &json)) json_auto_fmt(&out, json, &(Json_Auto_Fmt){0});
+    json_auto_free(&json);
+    so_free(&out);
+}
+
+static void run_fix(So input) {
+    So fix = SO;
+    so_extend(&fix, input);
+    json_fix_so(fix, &fix);
+    so_free(&fix);
+}
+
+/* materializes every level */
+static void run_lazy(So input) {
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    Json_Auto_Value json = {0};
+    if(!json_auto_parse_lazy(input, &json, &settings)) (void)json_auto_hash(&json);
+    json_auto_free(&json);
+}
+
+static double complexity_time(Complexity_Run run, So input) {
+    uint64_t best = UINT64_MAX;
+    for(size_t i = 0; i < COMPLEXITY_RUNS; ++i) {
+        uint64_t t0 = fuzz_ns();
+        run(input);
+        uint64_t dt = fuzz_ns() - t0;
+        if(dt < best) best = dt;
+    }
+    return (double)best;
+}
+
+static int complexity_check(const char *name, Complexity_Build build, const char *run_name, Complexity_Run run, size_t n) {
+    So small = SO, large = SO;
+    build(&small, n);
+    build(&large, n * COMPLEXITY_SCALE);
+    double t_small = complexity_time(run, small);
+    double t_large = complexity_time(run, large);
+    double ratio = t_large / (t_small > 1e4 ? t_small : 1e4);
+    double allowed = (double)so_len(large) / (double)so_len(small) * COMPLEXITY_SLACK;
+    int status = ratio > allowed || t_large > (double)so_len(large) * COMPLEXITY_NS_PER_BYTE ? -1 : 0;
+    if(status) {
+        printff(F("SUPERLINEAR", FG_RD_B) " %s / %s: %zu bytes %.3f ms, %zu bytes %.3f ms",
+                name, run_name, so_len(small), t_small * 1e-6, so_len(large), t_large * 1e-6);
+    }
+    so_free(&small);
+    so_free(&large);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    size_t n = argc > 1 ? strtoul(argv[1], 0, 10) : 1 << 16;
+    struct { const char *name; Complexity_Build build; } inputs[] = {
+        { "nesting", build_nesting },
+        { "escapes", build_escapes },
+        { "keys", build_keys },
+        { "whitespace", build_whitespace },
+        { "digits", build_digits },
+        { "invalid depth", build_invalid_depth },
+    };
+    struct { const char *name; Complexity_Run run; } runs[] = {
+        { "json_parse_ext", run_parse },
+        { "json_valid", run_valid },
+        { "json_auto_parse, fmt", run_auto },
+        { "json_fix_so", run_fix },
+        { "json_auto_parse_lazy", run_lazy },
+    };
+    int status = 0;
+    size_t count = 0;
+    for(size_t i = 0; i < sizeof(inputs) / sizeof(*inputs); ++i) {
+        for(size_t j = 0; j < sizeof(runs) / sizeof(*runs); ++j, ++count) {
+            if(complexity_check(inputs[i].name, inputs[i].build, runs[j].name, runs[j].run, n)) status = 1;
+        }
+    }
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu inputs scale linearly", count);
+    }
+    return status;
+}
@@ -0,0 +1,18 @@
+#include "fuzz.h"
+
+/* json_fix_so on any bytes, escaped or not: never grows the string and leaves
+ * text without backslashes alone */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    So input = so_ll((const char *)data, size);
+    So fix = SO;
+    so_extend(&fix, input);
+
+    uint64_t t0 = fuzz_ns();
+    json_fix_so(fix, &fix);
+    fuzz_time_check("json_fix_so", t0, size);
+
+    if(so_len(fix) > size) ABORT("json_fix_so grew %zu bytes to %zu", size, so_len(fix));
+    if(!memchr(data, '\\', size) && so_cmp(fix, input)) ABORT("json_fix_so changed text without escapes");
+    so_free(&fix);
+    return 0;
+}
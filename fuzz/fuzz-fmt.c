@@ -0,0 +1,45 @@
+#include "fuzz.h"
+
+/* whatever parses formats to text that parses again, and formatting that is a
+ * fixed point. numbers are printed with "%f", so the first round may round
+ * them; the second must not change anything. a lazy tree formats the same as
+ * the parsed one */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    uint8_t options = fuzz_options(&data, &size);
+    So input = so_ll((const char *)data, size);
+    Json_Auto_Fmt fmt = {
+        .pretty = options & 1,
+        .spaces = (options >> 1) & 7,
+        .tabs = (options >> 4) & 1,
+    };
+    Json_Auto_Value json = {0}, lazy = {0}, again = {0}, third = {0};
+    So out = SO, out_again = SO;
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    if(json_auto_parse(input, &json)) goto clean;
+
+    uint64_t t0 = fuzz_ns();
+    json_auto_fmt(&out, json, &fmt);
+    fuzz_time_check("json_auto_fmt", t0, size);
+
+    if(json_auto_parse_lazy(input, &lazy, &settings)) ABORT("valid json does not parse lazily");
+    json_auto_fmt(&out_again, lazy, &fmt);
+    if(so_cmp(out, out_again)) ABORT("lazy tree formats differently:\n%.*s\n%.*s", SO_F(out), SO_F(out_again));
+    so_clear(&out_again);
+
+    if(json_auto_parse(out, &again)) ABORT("formatted json does not parse: %.*s", SO_F(out));
+    json_auto_fmt(&out_again, again, &fmt);
+    if(json_auto_parse(out_again, &third)) ABORT("formatted json does not parse: %.*s", SO_F(out_again));
+    so_clear(&out);
+    json_auto_fmt(&out, third, &fmt);
+    if(so_cmp(out, out_again)) ABORT("formatting is no fixed point:\n%.*s\n%.*s", SO_F(out_again), SO_F(out));
+    if(!json_auto_eq(&again, &third)) ABORT("tree changed after a round trip");
+
+clean:
+    json_auto_free(&json);
+    json_auto_free(&lazy);
+    json_auto_free(&again);
+    json_auto_free(&third);
+    so_free(&out);
+    so_free(&out_again);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include "fuzz.h"
+
+#include <stdio.h>
+
+/* without libFuzzer: run every file given, or stdin (AFL) when there is none */
+static void fuzz_run(FILE *file) {
+    So input = SO;
+    char buf[65536];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), file))) so_extend(&input, so_ll(buf, n));
+    LLVMFuzzerTestOneInput((const uint8_t *)so_it0(input), so_len(input));
+    so_free(&input);
+}
+
+int main(int argc, char **argv) {
+    if(argc <= 1) {
+        fuzz_run(stdin);
+        return 0;
+    }
+    for(int i = 1; i < argc; ++i) {
+        FILE *file = fopen(argv[i], "rb");
+        if(!file) ABORT("failed opening file: '%s'", argv[i]);
+        fuzz_run(file);
+        fclose(file);
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "fuzz.h"
+
+typedef struct Fuzz_Parse {
+    So scratch;
+    size_t values;
+    bool surrogates; /* rejected, so nothing may be left to replace */
+} Fuzz_Parse;
+
+/* decode every key and string, like a user of the callbacks would */
+static void *fuzz_parse_callback(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    Fuzz_Parse *fuzz = *(Fuzz_Parse **)user;
+    ++fuzz->values;
+    if(key.id == JSON_OBJECT || key.id == JSON_STRING) {
+        so_clear(&fuzz->scratch);
+        so_extend(&fuzz->scratch, key.s);
+        if(json_fix_so(fuzz->scratch, &fuzz->scratch) && fuzz->surrogates) ABORT("unpaired surrogate passed");
+    }
+    if(val && val->id == JSON_STRING) {
+        so_clear(&fuzz->scratch);
+        so_extend(&fuzz->scratch, val->s);
+        if(json_fix_so(fuzz->scratch, &fuzz->scratch) && fuzz->surrogates) ABORT("unpaired surrogate passed");
+    }
+    return fuzz_parse_callback;
+}
+
+/* json_parse_ext with callbacks, json_valid and the reader have to come to
+ * the same decision, the first two also to the same error. the reader does
+ * not check for duplicate keys, nor the width limit */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    uint8_t options = fuzz_options(&data, &size);
+    So input = so_ll((const char *)data, size);
+    Json_Parse_Error error = {0}, error_valid = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.strict = options & 1;
+    settings.duplicates = options & 2 ? JSON_DUPLICATES_REJECT : JSON_DUPLICATES_ALLOW;
+    if(options & 4) settings.limits = (Json_Parse_Limits){ .bytes = 512, .nodes = 24, .width = 4, .string = 8 };
+    settings.reject_surrogates = options & 8;
+    settings.error = &error;
+    Fuzz_Parse fuzz = { .surrogates = settings.reject_surrogates };
+
+    uint64_t t0 = fuzz_ns();
+    int result = json_parse_ext(input, fuzz_parse_callback, &fuzz, &settings);
+    fuzz_time_check("json_parse_ext", t0, size);
+
+    settings.error = &error_valid;
+    t0 = fuzz_ns();
+    int result_valid = json_valid(input, &settings);
+    fuzz_time_check("json_valid", t0, size);
+
+    /* the pull reader too, through all of its events */
+    Json_Reader reader;
+    Json_Reader_Event event;
+    settings.error = 0;
+    json_reader_init(&reader, input, &settings);
+    t0 = fuzz_ns();
+    int result_reader = 0;
+    while(!(result_reader = json_reader_next(&reader, &event)) && event.id != JSON_READER_END) {}
+    fuzz_time_check("json_reader_next", t0, size);
+
+    if(!result != !result_valid) ABORT("json_parse_ext and json_valid disagree: %i, %i", result, result_valid);
+    if(!settings.duplicates && !settings.limits.width && !result != !result_reader) ABORT("json_parse_ext and json_reader_next disagree: %i, %i", result, result_reader);
+    if(result && (error.code != error_valid.code || error.offset != error_valid.offset || error.offset > size)) {
+        ABORT("errors differ: %s at %zu, %s at %zu", json_parse_error_str(error.code), error.offset,
+                json_parse_error_str(error_valid.code), error_valid.offset);
+    }
+    so_free(&fuzz.scratch);
+    return 0;
+}
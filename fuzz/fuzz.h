@@ -0,0 +1,48 @@
+#ifndef RLJSON_FUZZ_H
+
+#include "../rljson.h"
+
+#include <stdint.h>
+#include <time.h>
+
+/* shared by the fuzz targets, which build as libFuzzer targets or, with
+ * fuzz-main.c, as plain programs for AFL and for replaying inputs.
+ *
+ * every target also times its work: more than FUZZ_NS_PER_BYTE per input
+ * byte (on top of FUZZ_NS_BASE) aborts, so inputs that take superlinear time
+ * show up as crashes. the defaults leave room for sanitizers. */
+
+#ifndef FUZZ_NS_PER_BYTE
+#define FUZZ_NS_PER_BYTE    20000
+#endif
+
+#ifndef FUZZ_NS_BASE
+#define FUZZ_NS_BASE        50000000
+#endif
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static inline uint64_t fuzz_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static inline void fuzz_time_check(const char *what, uint64_t t0, size_t size) {
+    uint64_t dt = fuzz_ns() - t0;
+    if(dt > FUZZ_NS_BASE + (uint64_t)FUZZ_NS_PER_BYTE * size) {
+        ABORT("%s took %.3f ms for %zu bytes", what, (double)dt * 1e-6, size);
+    }
+}
+
+/* the first byte picks options, the rest is the input */
+static inline uint8_t fuzz_options(const uint8_t **data, size_t *size) {
+    if(!*size) return 0;
+    uint8_t options = **data;
+    ++*data;
+    --*size;
+    return options;
+}
+
+#define RLJSON_FUZZ_H
+#endif // RLJSON_FUZZ_H
@@ -1,7 +1,13 @@
 #ifndef RLJSON_H
 
 #include "rljson/rljson-core.h"
+#include "rljson/rljson-valid.h"
+#include "rljson/rljson-reader.h"
+#include "rljson/rljson-columns.h"
 #include "rljson/rljson-auto.h"
+#include "rljson/rljson-bin.h"
+#include "rljson/rljson-patch.h"
+#include "rljson/rljson-pack.h"
 
 #define RLJSON_H
 #endif // RLJSON_H
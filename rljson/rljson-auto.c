@@ -1,4 +1,10 @@
+#include <float.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
 #include "rljson-auto.h"
+#include "rljson-bin.h"
 
 void *json_auto_parse_string(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
     Json_Auto_Value *autoval = *(Json_Auto_Value **)user;
@@ -20,55 +26,176 @@ void *json_auto_parse_null(void **user, Json_Parse_Value key, Json_Parse_Value *
     return 0;
 }
 
-void *json_auto_parse_number(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
-    Json_Auto_Value *autoval = *(Json_Auto_Value **)user;
+static const double json_auto_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* number text the core has already checked. plain integers and numbers with
+ * up to 19 digits that fit a double exactly, scaled by at most 10^22, are
+ * converted right here: one correctly rounded multiplication or division, the
+ * same as strtod. everything else goes through rlso */
+void json_auto_number(So s, Json_Auto_Value *out) {
+    const char *p = s.str, *end = s.str + s.len;
+    bool negative = p < end && *p == '-';
+    p += negative;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exp10 = 0;
+    for(; p < end && (unsigned char)(*p - '0') < 10; ++p, ++digits) mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+    if(p == end && !negative && digits <= 19) {
+        out->z = mantissa;
+        out->id = JSON_AUTO_VALUE_SIZE;
+        return;
+    }
+    if(p < end && *p == '.') {
+        for(++p; p < end && (unsigned char)(*p - '0') < 10; ++p, ++digits, --exp10) mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+    }
+    if(p < end && (*p | 0x20) == 'e') {
+        ++p;
+        bool exp_negative = p < end && *p == '-';
+        if(p < end && (*p == '-' || *p == '+')) ++p;
+        int e = 0;
+        for(; p < end && (unsigned char)(*p - '0') < 10; ++p) if(e < 10000) e = e * 10 + (*p - '0');
+        exp10 += exp_negative ? -e : e;
+    }
+    if(digits <= 19 && mantissa <= (1ull << 53) && exp10 >= -22 && exp10 <= 22) {
+        double d = (double)mantissa;
+        d = exp10 < 0 ? d / json_auto_pow10[-exp10] : d * json_auto_pow10[exp10];
+        out->f = negative ? -d : d;
+        out->id = JSON_AUTO_VALUE_DOUBLE;
+        return;
+    }
     double d = 0;
     size_t z = 0;
-    if(!so_as_size(key.s, &z, 0)) {
-        autoval->z = z;
-        autoval->id = JSON_AUTO_VALUE_SIZE;
-    } else if(!so_as_double(key.s, &d)) {
-        autoval->f = d;
-        autoval->id = JSON_AUTO_VALUE_DOUBLE;
+    if(!so_as_size(s, &z, 0)) {
+        out->z = z;
+        out->id = JSON_AUTO_VALUE_SIZE;
+    } else if(!so_as_double(s, &d) && isfinite(d)) {
+        out->f = d;
+        out->id = JSON_AUTO_VALUE_DOUBLE;
     } else {
-        autoval->so = key.s;
-        autoval->id = JSON_AUTO_VALUE_STRING;
+        out->so = s;
+        out->id = JSON_AUTO_VALUE_STRING;
     }
+}
+
+void *json_auto_parse_number(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    Json_Auto_Value *autoval = *(Json_Auto_Value **)user;
+    json_auto_number(key.s, autoval);
     return 0;
 }
 
 void *json_auto_parse_value(void **user, Json_Parse_Value key, Json_Parse_Value *val);
+void *json_auto_parse_value_insitu(void **user, Json_Parse_Value key, Json_Parse_Value *val);
+void *json_auto_parse_value_packed(void **user, Json_Parse_Value key, Json_Parse_Value *val);
+void *json_auto_parse_value_insitu_packed(void **user, Json_Parse_Value key, Json_Parse_Value *val);
 
-void *json_auto_parse_array(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+/* set the kind up front, so empty objects and arrays don't end up as null */
+void json_auto_parse_enter(Json_Auto_Value *autoval, Json_Parse_Value key) {
+    autoval->id = key.child == JSON_ARRAY ? JSON_AUTO_VALUE_ARRAY : JSON_AUTO_VALUE_OBJECT;
+}
+
+/* the root gets no enter callback */
+void json_auto_parse_root(So input, Json_Auto_Value *out) {
+    Json_Parse q = { .head = input };
+    json_parse_ws(&q);
+    if(json_parse_ch(&q, '[')) out->id = JSON_AUTO_VALUE_ARRAY;
+    else if(json_parse_ch(&q, '{')) out->id = JSON_AUTO_VALUE_OBJECT;
+}
+
+/* append to a packed array, or start one in an empty array; false if the
+ * number is of the other kind or the array already holds something else */
+bool json_auto_pack(Json_Auto_Value *autoval, Json_Auto_Value number) {
+    bool empty = autoval->id == JSON_AUTO_VALUE_ARRAY && !autoval->arr;
+    if(number.id == JSON_AUTO_VALUE_SIZE && (empty || autoval->id == JSON_AUTO_VALUE_SIZES)) {
+        autoval->id = JSON_AUTO_VALUE_SIZES;
+        array_push(autoval->sizes, number.z);
+        return true;
+    }
+    if(number.id == JSON_AUTO_VALUE_DOUBLE && (empty || autoval->id == JSON_AUTO_VALUE_DOUBLES)) {
+        autoval->id = JSON_AUTO_VALUE_DOUBLES;
+        array_push(autoval->doubles, number.f);
+        return true;
+    }
+    return false;
+}
+
+/* a regular array again, with the elements it had before packing */
+void json_auto_unpack(Json_Auto_Value *autojson) {
+    if(autojson->id != JSON_AUTO_VALUE_SIZES && autojson->id != JSON_AUTO_VALUE_DOUBLES) return;
+    bool sizes = autojson->id == JSON_AUTO_VALUE_SIZES;
+    size_t len = sizes ? array_len(autojson->sizes) : array_len(autojson->doubles);
+    Json_Auto_Value result = { .id = JSON_AUTO_VALUE_ARRAY, .flags = autojson->flags };
+    result.hash = autojson->hash;
+    array_resize(result.arr, len);
+    for(size_t i = 0; i < len; ++i) {
+        Json_Auto_Value *sub = array_it(result.arr, i);
+        if(sizes) *sub = (Json_Auto_Value){ .z = array_at(autojson->sizes, i), .id = JSON_AUTO_VALUE_SIZE };
+        else *sub = (Json_Auto_Value){ .f = array_at(autojson->doubles, i), .id = JSON_AUTO_VALUE_DOUBLE };
+    }
+    if(sizes) array_free(autojson->sizes);
+    else array_free(autojson->doubles);
+    *autojson = result;
+}
+
+void *json_auto_parse_array_ext(void **user, Json_Parse_Value key, Json_Parse_Value *val, Json_Parse_Callback next, bool pack) {
     Json_Auto_Value *autoval = *(Json_Auto_Value **)user;
+    if(val && val->id == JSON_NUMBER) {
+        Json_Auto_Value number = {0};
+        json_auto_number(val->s, &number);
+        if(pack && json_auto_pack(autoval, number)) return 0;
+        json_auto_unpack(autoval);
+        autoval->id = JSON_AUTO_VALUE_ARRAY;
+        array_push(autoval->arr, number);
+        return 0;
+    }
+    json_auto_unpack(autoval);
     autoval->id = JSON_AUTO_VALUE_ARRAY;
     array_push(autoval->arr, (Json_Auto_Value){0});
     Json_Auto_Value *subuser = array_itL(autoval->arr);
     if(val) {
-        return json_auto_parse_value((void **)&subuser, *val, 0);
+        return next((void **)&subuser, *val, 0);
     } else {
+        json_auto_parse_enter(subuser, key);
         *user = subuser;
-        return json_auto_parse_value;
+        return next;
     }
 }
 
-void *json_auto_parse_object(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+void *json_auto_parse_object_ext(void **user, Json_Parse_Value key, Json_Parse_Value *val, Json_Parse_Callback next, unsigned char key_flags) {
     Json_Auto_Value *autoval = *(Json_Auto_Value **)user;
     autoval->id = JSON_AUTO_VALUE_OBJECT;
-    array_push(autoval->dict, (Json_Auto_Key_Value){0});
-    Json_Auto_Key_Value *subkv = array_itL(autoval->dict);
-    subkv->key = key.s;
+    Json_Auto_Key_Value *subkv = 0;
+    if(key.duplicate) {
+        /* JSON_DUPLICATES_LAST: the last value, where the key came first */
+        subkv = array_it(autoval->dict, key.duplicate - 1);
+        key_flags = subkv->val.flags & (JSON_AUTO_FLAG_KEY_OWNED | JSON_AUTO_FLAG_KEY_DECODED);
+        json_auto_free(&subkv->val);
+    } else {
+        array_push(autoval->dict, (Json_Auto_Key_Value){ .key = key.s });
+        subkv = array_itL(autoval->dict);
+    }
+    subkv->val.flags = key_flags;
     Json_Auto_Value *subuser = &subkv->val;
     if(val) {
-        return json_auto_parse_value((void **)&subuser, *val, 0);
+        return next((void **)&subuser, *val, 0);
     } else {
+        json_auto_parse_enter(subuser, key);
         *user = subuser;
-        return json_auto_parse_value;
+        return next;
     }
 }
 
+void *json_auto_parse_array(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    return json_auto_parse_array_ext(user, key, val, json_auto_parse_value, false);
+}
+
+void *json_auto_parse_object(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    return json_auto_parse_object_ext(user, key, val, json_auto_parse_value, 0);
+}
+
 void *json_auto_parse_value(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
-    Json_Auto_Value *autoval = *(Json_Auto_Value **)user;
     switch(key.id) {
         case JSON_NUMBER: json_auto_parse_number(user, key, val); break;
         case JSON_STRING: json_auto_parse_string(user, key, val); break;
@@ -81,14 +208,786 @@ void *json_auto_parse_value(void **user, Json_Parse_Value key, Json_Parse_Value
     return 0;
 }
 
+/* every string and key reaches exactly one callback, after the core is done
+ * reading it, so it can be decoded right there in the input buffer */
+void *json_auto_parse_value_insitu(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    switch(key.id) {
+        case JSON_STRING: {
+            Json_Auto_Value *autoval = *(Json_Auto_Value **)user;
+            json_fix_so(key.s, &key.s);
+            json_auto_parse_string(user, key, val);
+            autoval->flags |= JSON_AUTO_FLAG_DECODED;
+        } break;
+        case JSON_ARRAY: return json_auto_parse_array_ext(user, key, val, json_auto_parse_value_insitu, false);
+        case JSON_OBJECT: {
+            json_fix_so(key.s, &key.s);
+            return json_auto_parse_object_ext(user, key, val, json_auto_parse_value_insitu, JSON_AUTO_FLAG_KEY_DECODED);
+        }
+        default: return json_auto_parse_value(user, key, val);
+    }
+    return 0;
+}
+
+/* the same two, with .pack */
+void *json_auto_parse_value_packed(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    switch(key.id) {
+        case JSON_ARRAY: return json_auto_parse_array_ext(user, key, val, json_auto_parse_value_packed, true);
+        case JSON_OBJECT: return json_auto_parse_object_ext(user, key, val, json_auto_parse_value_packed, 0);
+        default: return json_auto_parse_value(user, key, val);
+    }
+}
+
+void *json_auto_parse_value_insitu_packed(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    switch(key.id) {
+        case JSON_ARRAY: return json_auto_parse_array_ext(user, key, val, json_auto_parse_value_insitu_packed, true);
+        case JSON_OBJECT: {
+            json_fix_so(key.s, &key.s);
+            return json_auto_parse_object_ext(user, key, val, json_auto_parse_value_insitu_packed, JSON_AUTO_FLAG_KEY_DECODED);
+        }
+        default: return json_auto_parse_value_insitu(user, key, val);
+    }
+}
+
+/* the memory limit turned into a limit on values, whichever is tighter */
+size_t json_auto_limit_nodes(Json_Parse_Limits limits) {
+    if(!limits.memory) return limits.nodes;
+    size_t nodes = limits.memory / JSON_AUTO_NODE_BYTES;
+    if(!nodes) nodes = 1; /* the root is the caller's */
+    return limits.nodes && limits.nodes <= nodes ? limits.nodes : nodes;
+}
+
+static Json_Parse_Settings json_auto_limits(Json_Parse_Settings *settings) {
+    Json_Parse_Settings result = *settings;
+    result.limits.nodes = json_auto_limit_nodes(settings->limits);
+    return result;
+}
+
+/* the values ran out because of the memory limit */
+static int json_auto_limits_error(Json_Parse_Settings *settings, int result) {
+    Json_Parse_Error *error = settings->error;
+    if(!result || !error || error->code != JSON_ERROR_LIMIT_NODES) return result;
+    if(json_auto_limit_nodes(settings->limits) != settings->limits.nodes) error->code = JSON_ERROR_LIMIT_MEMORY;
+    return result;
+}
+
 ErrDecl json_auto_parse(So input, Json_Auto_Value *out) {
     ASSERT_ARG(out);
+    json_auto_parse_root(input, out);
     return json_parse(input, json_auto_parse_value, out);
 }
 
 ErrDecl json_auto_parse_ext(So input, Json_Auto_Value *out, Json_Parse_Settings *settings) {
     ASSERT_ARG(out);
-    return json_parse_ext(input, json_auto_parse_value, out, settings);
+    ASSERT_ARG(settings);
+    Json_Parse_Settings limited = json_auto_limits(settings);
+    json_auto_parse_root(input, out);
+    Json_Parse_Callback callback = settings->pack ? json_auto_parse_value_packed : json_auto_parse_value;
+    return json_auto_limits_error(settings, json_parse_ext(input, callback, out, &limited));
+}
+
+ErrDecl json_auto_parse_parser(Json_Parser *parser, So input, Json_Auto_Value *out) {
+    ASSERT_ARG(parser);
+    ASSERT_ARG(out);
+    Json_Parse_Settings settings = parser->settings;
+    parser->settings = json_auto_limits(&settings);
+    json_auto_parse_root(input, out);
+    int result = json_parser_parse(parser, input, settings.pack ? json_auto_parse_value_packed : json_auto_parse_value, out);
+    parser->settings = settings;
+    return json_auto_limits_error(&settings, result);
+}
+
+ErrDecl json_auto_parse_insitu(So input, Json_Auto_Value *out, Json_Parse_Settings *settings) {
+    ASSERT_ARG(out);
+    ASSERT_ARG(settings);
+    Json_Parse_Settings limited = json_auto_limits(settings);
+    json_auto_parse_root(input, out);
+    Json_Parse_Callback callback = settings->pack ? json_auto_parse_value_insitu_packed : json_auto_parse_value_insitu;
+    return json_auto_limits_error(settings, json_parse_ext(input, callback, out, &limited));
+}
+
+/* parse the value at the head of an already validated cursor, objects and
+ * arrays are only skipped over and kept as their raw text. every level skips
+ * over all of its children again, so subtrees nesting deeper than
+ * JSON_AUTO_LAZY_DEPTH_MAX get parsed right away instead */
+bool json_auto_lazy_value(Json_Parse *q, Json_Auto_Value *out) {
+    json_parse_ws(q);
+    if(!q->head.len) return false;
+    switch(*q->head.str) {
+        case '{':
+        case '[': {
+            size_t nesting = 0;
+            if(!json_parse_skip(q, &out->so, &nesting)) return false;
+            out->id = JSON_AUTO_VALUE_LAZY;
+            if(nesting > JSON_AUTO_LAZY_DEPTH_MAX) {
+                So span = out->so;
+                out->so = SO;
+                json_auto_parse_root(span, out);
+                if(json_parse(span, json_auto_parse_value, out)) return false;
+            }
+            json_parse_ws(q);
+        } break;
+        default: {
+            Json_Parse_Value v = {0};
+            if(!json_parse_value(q, &v)) return false;
+            void *user = out;
+            json_auto_parse_value(&user, v, 0);
+        } break;
+    }
+    return true;
+}
+
+ErrDecl json_auto_parse_lazy(So input, Json_Auto_Value *out, Json_Parse_Settings *settings) {
+    ASSERT_ARG(out);
+    ASSERT_ARG(settings);
+    /* lazy levels keep every member, dropping some takes a full parse */
+    if(settings->duplicates == JSON_DUPLICATES_FIRST || settings->duplicates == JSON_DUPLICATES_LAST) {
+        return json_auto_parse_ext(input, out, settings);
+    }
+    Json_Parse_Settings limited = json_auto_limits(settings);
+    int result = json_auto_limits_error(settings, json_parse_valid_ext(input, &limited));
+    if(result) return result;
+    Json_Parse q = { .head = input };
+    if(!json_auto_lazy_value(&q, out)) return -1;
+    return 0;
+}
+
+/* a frozen object or array, see json_auto_share */
+typedef struct Json_Auto_Shared {
+    atomic_size_t refs;
+    Json_Auto_Value val; /* never carries key flags, those belong to the slot */
+} Json_Auto_Shared;
+
+#define JSON_AUTO_FLAGS_KEY     (JSON_AUTO_FLAG_KEY_OWNED | JSON_AUTO_FLAG_KEY_DECODED)
+
+void json_auto_shared_release(Json_Auto_Shared *shared) {
+    if(atomic_fetch_sub_explicit(&shared->refs, 1, memory_order_acq_rel) != 1) return;
+    json_auto_free(&shared->val);
+    free(shared);
+}
+
+/* a private copy of one level of a frozen value: children that are shared get
+ * another reference, strings are only copied where the source owns them */
+Json_Auto_Value json_auto_shared_copy(Json_Auto_Value *src) {
+    Json_Auto_Value result = *src;
+    switch(src->id) {
+        case JSON_AUTO_VALUE_SHARED: {
+            atomic_fetch_add_explicit(&src->shared->refs, 1, memory_order_relaxed);
+        } break;
+        case JSON_AUTO_VALUE_STRING: {
+            if(!(src->flags & JSON_AUTO_FLAG_OWNED)) break;
+            result.so = SO;
+            so_extend(&result.so, src->so);
+        } break;
+        case JSON_AUTO_VALUE_ARRAY: {
+            result.arr = 0;
+            array_resize(result.arr, array_len(src->arr));
+            for(size_t i = 0; i < array_len(src->arr); ++i) {
+                array_at(result.arr, i) = json_auto_shared_copy(array_it(src->arr, i));
+            }
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            result.dict = 0;
+            array_resize(result.dict, array_len(src->dict));
+            for(size_t i = 0; i < array_len(src->dict); ++i) {
+                Json_Auto_Key_Value *kv = array_it(src->dict, i);
+                Json_Auto_Key_Value *copy = array_it(result.dict, i);
+                copy->key = kv->key;
+                if(kv->val.flags & JSON_AUTO_FLAG_KEY_OWNED) {
+                    copy->key = SO;
+                    so_extend(&copy->key, kv->key);
+                }
+                copy->val = json_auto_shared_copy(&kv->val);
+            }
+        } break;
+        case JSON_AUTO_VALUE_SIZES: {
+            result.sizes = 0;
+            array_resize(result.sizes, array_len(src->sizes));
+            memcpy(array_it(result.sizes, 0), array_it(src->sizes, 0), array_len(src->sizes) * sizeof(*src->sizes));
+        } break;
+        case JSON_AUTO_VALUE_DOUBLES: {
+            result.doubles = 0;
+            array_resize(result.doubles, array_len(src->doubles));
+            memcpy(array_it(result.doubles, 0), array_it(src->doubles, 0), array_len(src->doubles) * sizeof(*src->doubles));
+        } break;
+        default: break;
+    }
+    return result;
+}
+
+/* copy on write: the last reference takes the value over, any other gets a
+ * copy of this one level */
+void json_auto_unshare(Json_Auto_Value *autojson) {
+    if(autojson->id != JSON_AUTO_VALUE_SHARED) return;
+    Json_Auto_Shared *shared = autojson->shared;
+    unsigned char key_flags = autojson->flags & JSON_AUTO_FLAGS_KEY;
+    Json_Auto_Value result;
+    if(atomic_load_explicit(&shared->refs, memory_order_acquire) == 1) {
+        result = shared->val;
+        free(shared);
+    } else {
+        result = json_auto_shared_copy(&shared->val);
+        json_auto_shared_release(shared);
+    }
+    result.flags |= key_flags;
+    *autojson = result;
+}
+
+void json_auto_share(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    if(autojson->id == JSON_AUTO_VALUE_LAZY) json_auto_materialize(autojson);
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_ARRAY: {
+            for(size_t i = 0; i < array_len(autojson->arr); ++i) json_auto_share(array_it(autojson->arr, i));
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            for(size_t i = 0; i < array_len(autojson->dict); ++i) json_auto_share(&array_it(autojson->dict, i)->val);
+        } break;
+        case JSON_AUTO_VALUE_SIZES:
+        case JSON_AUTO_VALUE_DOUBLES: break;
+        default: return;
+    }
+    /* nothing writes to a frozen value, not even the hash cache: fill it now */
+    (void)json_auto_hash(autojson);
+    Json_Auto_Shared *shared = malloc(sizeof(*shared));
+    if(!shared) ABORT("failed allocating a shared value");
+    atomic_init(&shared->refs, 1);
+    shared->val = *autojson;
+    shared->val.flags &= ~JSON_AUTO_FLAGS_KEY;
+    *autojson = (Json_Auto_Value){ .shared = shared, .id = JSON_AUTO_VALUE_SHARED, .flags = autojson->flags & JSON_AUTO_FLAGS_KEY };
+}
+
+Json_Auto_Value json_auto_ref(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    json_auto_share(autojson);
+    if(autojson->id != JSON_AUTO_VALUE_SHARED) return json_auto_clone(autojson);
+    atomic_fetch_add_explicit(&autojson->shared->refs, 1, memory_order_relaxed);
+    return (Json_Auto_Value){ .shared = autojson->shared, .id = JSON_AUTO_VALUE_SHARED };
+}
+
+Json_Auto_Value *json_auto_borrow(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    if(autojson->id == JSON_AUTO_VALUE_SHARED) return &autojson->shared->val;
+    if(autojson->id == JSON_AUTO_VALUE_LAZY) return json_auto_materialize(autojson);
+    return autojson;
+}
+
+Json_Auto_Value json_auto_clone(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    Json_Auto_Value *src = json_auto_borrow(autojson);
+    Json_Auto_Value result = *src;
+    result.flags &= JSON_AUTO_FLAG_DECODED | JSON_AUTO_FLAG_HASHED;
+    switch(src->id) {
+        case JSON_AUTO_VALUE_STRING: {
+            result.so = SO;
+            so_extend(&result.so, src->so);
+            result.flags |= JSON_AUTO_FLAG_OWNED;
+        } break;
+        case JSON_AUTO_VALUE_ARRAY: {
+            result.arr = 0;
+            array_resize(result.arr, array_len(src->arr));
+            for(size_t i = 0; i < array_len(src->arr); ++i) {
+                array_at(result.arr, i) = json_auto_clone(array_it(src->arr, i));
+            }
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            result.dict = 0;
+            array_resize(result.dict, array_len(src->dict));
+            for(size_t i = 0; i < array_len(src->dict); ++i) {
+                Json_Auto_Key_Value *kv = array_it(src->dict, i);
+                Json_Auto_Key_Value *copy = array_it(result.dict, i);
+                copy->key = SO;
+                so_extend(&copy->key, kv->key);
+                copy->val = json_auto_clone(&kv->val);
+                copy->val.flags |= JSON_AUTO_FLAG_KEY_OWNED | (kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED);
+            }
+        } break;
+        case JSON_AUTO_VALUE_SIZES:
+        case JSON_AUTO_VALUE_DOUBLES: {
+            result = json_auto_shared_copy(src);
+            result.flags = 0;
+        } break;
+        default: break;
+    }
+    return result;
+}
+
+Json_Auto_Value json_auto_move(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    Json_Auto_Value result = *autojson;
+    result.flags &= ~JSON_AUTO_FLAGS_KEY;
+    *autojson = (Json_Auto_Value){ .id = JSON_AUTO_VALUE_NULL, .flags = autojson->flags & JSON_AUTO_FLAGS_KEY };
+    return result;
+}
+
+Json_Auto_Value *json_auto_materialize(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    json_auto_unshare(autojson);
+    json_auto_unpack(autojson);
+    /* may get edited from here on, and the parents can't tell */
+    autojson->flags &= ~JSON_AUTO_FLAG_HASHED;
+    if(autojson->id != JSON_AUTO_VALUE_LAZY) return autojson;
+    if(autojson->flags & JSON_AUTO_FLAG_BINARY) {
+        if(json_auto_bin_materialize(autojson)) {
+            /* corrupt snapshot, see rljson-bin.h */
+            *autojson = (Json_Auto_Value){ .flags = autojson->flags & (JSON_AUTO_FLAG_KEY_OWNED | JSON_AUTO_FLAG_KEY_DECODED) };
+        }
+        return autojson;
+    }
+    Json_Parse q = { .head = autojson->so };
+    Json_Auto_Value result = { .flags = autojson->flags };
+    bool object = json_parse_ch(&q, '{');
+    if(!object && !json_parse_ch(&q, '[')) goto invalid;
+    result.id = object ? JSON_AUTO_VALUE_OBJECT : JSON_AUTO_VALUE_ARRAY;
+    json_parse_ws(&q);
+    if(!json_parse_ch(&q, object ? '}' : ']')) {
+        do {
+            Json_Auto_Value *sub = 0;
+            if(object) {
+                So key = SO;
+                json_parse_ws(&q);
+                if(!json_parse_string(&q, &key)) goto invalid;
+                json_parse_ws(&q);
+                if(!json_parse_ch(&q, ':')) goto invalid;
+                array_push(result.dict, (Json_Auto_Key_Value){ .key = key });
+                sub = &array_itL(result.dict)->val;
+            } else {
+                array_push(result.arr, (Json_Auto_Value){0});
+                sub = array_itL(result.arr);
+            }
+            if(!json_auto_lazy_value(&q, sub)) goto invalid;
+        } while(json_parse_ch(&q, ','));
+    }
+    *autojson = result;
+    return autojson;
+invalid:
+    ABORT("lazy value is not valid json: '%.*s'", SO_F(autojson->so));
+}
+
+bool json_auto_packed(Json_Auto_Value *autojson) {
+    return autojson->id == JSON_AUTO_VALUE_SIZES || autojson->id == JSON_AUTO_VALUE_DOUBLES;
+}
+
+size_t *json_auto_sizes(Json_Auto_Value *autojson, size_t *len) {
+    ASSERT_ARG(autojson);
+    autojson = json_auto_borrow(autojson);
+    if(autojson->id != JSON_AUTO_VALUE_SIZES) return 0;
+    if(len) *len = array_len(autojson->sizes);
+    return autojson->sizes;
+}
+
+double *json_auto_doubles(Json_Auto_Value *autojson, size_t *len) {
+    ASSERT_ARG(autojson);
+    autojson = json_auto_borrow(autojson);
+    if(autojson->id != JSON_AUTO_VALUE_DOUBLES) return 0;
+    if(len) *len = array_len(autojson->doubles);
+    return autojson->doubles;
+}
+
+/* element i of a packed array, as a value of its own */
+static Json_Auto_Value json_auto_packed_at(Json_Auto_Value *autojson, size_t i) {
+    if(autojson->id == JSON_AUTO_VALUE_SIZES) return (Json_Auto_Value){ .z = array_at(autojson->sizes, i), .id = JSON_AUTO_VALUE_SIZE };
+    return (Json_Auto_Value){ .f = array_at(autojson->doubles, i), .id = JSON_AUTO_VALUE_DOUBLE };
+}
+
+size_t json_auto_len(Json_Auto_Value *autojson) {
+    if(autojson->id == JSON_AUTO_VALUE_LAZY && autojson->flags & JSON_AUTO_FLAG_BINARY) return json_auto_bin_len(autojson);
+    autojson = json_auto_borrow(autojson);
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_SIZES: return array_len(autojson->sizes);
+        case JSON_AUTO_VALUE_DOUBLES: return array_len(autojson->doubles);
+        case JSON_AUTO_VALUE_ARRAY: return array_len(autojson->arr);
+        case JSON_AUTO_VALUE_OBJECT: return array_len(autojson->dict);
+        default: return 0;
+    }
+}
+
+Json_Auto_Value *json_auto_element(Json_Auto_Value *autojson, size_t index, Json_Auto_Value *tmp) {
+    ASSERT_ARG(autojson);
+    ASSERT_ARG(tmp);
+    autojson = json_auto_borrow(autojson);
+    if(index >= json_auto_len(autojson)) return 0;
+    if(json_auto_packed(autojson)) {
+        *tmp = json_auto_packed_at(autojson, index);
+        return tmp;
+    }
+    return autojson->id == JSON_AUTO_VALUE_ARRAY ? array_it(autojson->arr, index) : 0;
+}
+
+Json_Auto_Value *json_auto_at(Json_Auto_Value *autojson, size_t index) {
+    autojson = json_auto_borrow(autojson);
+    if(index >= json_auto_len(autojson)) return 0;
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_ARRAY: return array_it(autojson->arr, index);
+        case JSON_AUTO_VALUE_OBJECT: return &array_it(autojson->dict, index)->val;
+        /* a packed array has no element values to point at */
+        default: return 0;
+    }
+}
+
+So json_auto_key(Json_Auto_Value *autojson, size_t index) {
+    autojson = json_auto_borrow(autojson);
+    if(index >= json_auto_len(autojson)) return SO;
+    if(autojson->id != JSON_AUTO_VALUE_OBJECT) return SO;
+    return array_at(autojson->dict, index).key;
+}
+
+Json_Auto_Value *json_auto_get(Json_Auto_Value *autojson, So key) {
+    Json_Auto_Key_Value *kv = json_auto_dict_find(autojson, key);
+    return kv ? &kv->val : 0;
+}
+
+ErrDecl json_auto_arr_insert(Json_Auto_Value *autojson, size_t index, Json_Auto_Value val) {
+    ASSERT_ARG(autojson);
+    json_auto_materialize(autojson);
+    if(autojson->id != JSON_AUTO_VALUE_ARRAY) return -1;
+    size_t len = array_len(autojson->arr);
+    if(index > len) return -1;
+    array_push(autojson->arr, val);
+    Json_Auto_Value *base = array_it(autojson->arr, 0);
+    if(index < len) {
+        memmove(base + index + 1, base + index, (len - index) * sizeof(*base));
+        base[index] = val;
+    }
+    return 0;
+}
+
+ErrDecl json_auto_arr_remove(Json_Auto_Value *autojson, size_t index, Json_Auto_Value *out) {
+    ASSERT_ARG(autojson);
+    json_auto_materialize(autojson);
+    if(autojson->id != JSON_AUTO_VALUE_ARRAY) return -1;
+    size_t len = array_len(autojson->arr);
+    if(index >= len) return -1;
+    Json_Auto_Value *base = array_it(autojson->arr, 0);
+    Json_Auto_Value removed = base[index];
+    memmove(base + index, base + index + 1, (len - index - 1) * sizeof(*base));
+    array_pop(autojson->arr);
+    if(out) *out = removed;
+    else json_auto_free(&removed);
+    return 0;
+}
+
+ErrDecl json_auto_arr_replace(Json_Auto_Value *autojson, size_t index, Json_Auto_Value val) {
+    ASSERT_ARG(autojson);
+    json_auto_materialize(autojson);
+    if(index >= json_auto_len(autojson)) return -1;
+    if(autojson->id != JSON_AUTO_VALUE_ARRAY) return -1;
+    Json_Auto_Value *sub = array_it(autojson->arr, index);
+    json_auto_free(sub);
+    *sub = val;
+    return 0;
+}
+
+Json_Auto_Key_Value *json_auto_dict_find_ext(Json_Auto_Value *autojson, So key, bool decoded) {
+    ASSERT_ARG(autojson);
+    autojson = json_auto_borrow(autojson);
+    if(autojson->id != JSON_AUTO_VALUE_OBJECT) return 0;
+    for(size_t i = 0; i < array_len(autojson->dict); ++i) {
+        Json_Auto_Key_Value *kv = array_it(autojson->dict, i);
+        if(!json_auto_so_cmp(kv->key, kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED, key, decoded)) return kv;
+    }
+    return 0;
+}
+
+Json_Auto_Key_Value *json_auto_dict_find(Json_Auto_Value *autojson, So key) {
+    return json_auto_dict_find_ext(autojson, key, true);
+}
+
+ErrDecl json_auto_dict_set(Json_Auto_Value *autojson, So key, Json_Auto_Value val) {
+    ASSERT_ARG(autojson);
+    json_auto_materialize(autojson);
+    if(autojson->id != JSON_AUTO_VALUE_OBJECT) return -1;
+    unsigned char key_flags = JSON_AUTO_FLAG_KEY_OWNED | JSON_AUTO_FLAG_KEY_DECODED;
+    Json_Auto_Key_Value *kv = json_auto_dict_find_ext(autojson, key, val.flags & JSON_AUTO_FLAG_KEY_DECODED);
+    if(kv) {
+        /* keep the existing key */
+        if(val.flags & JSON_AUTO_FLAG_KEY_OWNED) so_free(&key);
+        val.flags = (val.flags & ~key_flags) | (kv->val.flags & key_flags);
+        json_auto_free(&kv->val);
+        kv->val = val;
+    } else {
+        array_push(autojson->dict, ((Json_Auto_Key_Value){ .key = key, .val = val }));
+    }
+    return 0;
+}
+
+ErrDecl json_auto_dict_remove(Json_Auto_Value *autojson, So key, Json_Auto_Value *out) {
+    ASSERT_ARG(autojson);
+    json_auto_materialize(autojson);
+    Json_Auto_Key_Value *kv = json_auto_dict_find(autojson, key);
+    if(!kv) return -1;
+    Json_Auto_Key_Value *base = array_it(autojson->dict, 0);
+    size_t index = kv - base;
+    size_t len = array_len(autojson->dict);
+    Json_Auto_Key_Value removed = *kv;
+    memmove(base + index, base + index + 1, (len - index - 1) * sizeof(*base));
+    array_pop(autojson->dict);
+    if(removed.val.flags & JSON_AUTO_FLAG_KEY_OWNED) so_free(&removed.key);
+    removed.val.flags &= ~(JSON_AUTO_FLAG_KEY_OWNED | JSON_AUTO_FLAG_KEY_DECODED);
+    if(out) *out = removed.val;
+    else json_auto_free(&removed.val);
+    return 0;
+}
+
+/* next piece of decoded text; decoded strings are one piece */
+bool json_auto_so_next(So *s, bool decoded, char buf[4], So *piece) {
+    if(!decoded) return json_fix_next(s, buf, piece);
+    if(!s->len) return false;
+    *piece = *s;
+    *s = SO;
+    return true;
+}
+
+int json_auto_so_cmp(So a, bool a_decoded, So b, bool b_decoded) {
+    /* without escapes raw and decoded look the same */
+    if(!a_decoded && (!a.len || !memchr(a.str, '\\', a.len))) a_decoded = true;
+    if(!b_decoded && (!b.len || !memchr(b.str, '\\', b.len))) b_decoded = true;
+    if(a_decoded == b_decoded && a.len == b.len && (!a.len || !memcmp(a.str, b.str, a.len))) return 0;
+    /* byte by byte through the decoded text of both, without decoding into memory */
+    char buf_a[4], buf_b[4];
+    So piece_a = SO, piece_b = SO;
+    for(;;) {
+        while(!piece_a.len && json_auto_so_next(&a, a_decoded, buf_a, &piece_a)) {}
+        while(!piece_b.len && json_auto_so_next(&b, b_decoded, buf_b, &piece_b)) {}
+        if(!piece_a.len || !piece_b.len) return (int)!!piece_a.len - (int)!!piece_b.len;
+        size_t n = piece_a.len < piece_b.len ? piece_a.len : piece_b.len;
+        int result = memcmp(piece_a.str, piece_b.str, n);
+        if(result) return result;
+        so_shift(&piece_a, n);
+        so_shift(&piece_b, n);
+    }
+}
+
+bool json_auto_eq(Json_Auto_Value *a, Json_Auto_Value *b) {
+    ASSERT_ARG(a);
+    ASSERT_ARG(b);
+    a = json_auto_borrow(a);
+    b = json_auto_borrow(b);
+    if(json_auto_packed(a) || json_auto_packed(b)) {
+        /* without unpacking */
+        if(a->id == b->id && a->id == JSON_AUTO_VALUE_SIZES) {
+            size_t len = array_len(a->sizes);
+            return len == array_len(b->sizes) && (!len || !memcmp(a->sizes, b->sizes, len * sizeof(*a->sizes)));
+        }
+        bool a_array = a->id == JSON_AUTO_VALUE_ARRAY || json_auto_packed(a);
+        bool b_array = b->id == JSON_AUTO_VALUE_ARRAY || json_auto_packed(b);
+        if(!a_array || !b_array || json_auto_len(a) != json_auto_len(b)) return false;
+        for(size_t i = 0; i < json_auto_len(a); ++i) {
+            Json_Auto_Value tmp_a, tmp_b;
+            if(!json_auto_eq(json_auto_element(a, i, &tmp_a), json_auto_element(b, i, &tmp_b))) return false;
+        }
+        return true;
+    }
+    /* the same frozen level, e.g. in two versions of one document */
+    if(a == b) return true;
+    if(a->id == JSON_AUTO_VALUE_SIZE && b->id == JSON_AUTO_VALUE_DOUBLE) return (double)a->z == b->f;
+    if(a->id == JSON_AUTO_VALUE_DOUBLE && b->id == JSON_AUTO_VALUE_SIZE) return a->f == (double)b->z;
+    if(a->id != b->id) return false;
+    switch(a->id) {
+        case JSON_AUTO_VALUE_NULL: return true;
+        case JSON_AUTO_VALUE_BOOL: return a->b == b->b;
+        case JSON_AUTO_VALUE_SIZE: return a->z == b->z;
+        case JSON_AUTO_VALUE_DOUBLE: return a->f == b->f;
+        case JSON_AUTO_VALUE_STRING: {
+            return !json_auto_so_cmp(a->so, a->flags & JSON_AUTO_FLAG_DECODED, b->so, b->flags & JSON_AUTO_FLAG_DECODED);
+        }
+        case JSON_AUTO_VALUE_ARRAY: {
+            if(array_len(a->arr) != array_len(b->arr)) return false;
+            for(size_t i = 0; i < array_len(a->arr); ++i) {
+                if(!json_auto_eq(array_it(a->arr, i), array_it(b->arr, i))) return false;
+            }
+            return true;
+        }
+        case JSON_AUTO_VALUE_OBJECT: {
+            if(array_len(a->dict) != array_len(b->dict)) return false;
+            for(size_t i = 0; i < array_len(a->dict); ++i) {
+                Json_Auto_Key_Value *kv = array_it(a->dict, i);
+                Json_Auto_Key_Value *other = 0;
+                for(size_t j = 0; j < array_len(b->dict); ++j) {
+                    Json_Auto_Key_Value *candidate = array_it(b->dict, (i + j) % array_len(b->dict));
+                    if(json_auto_so_cmp(kv->key, kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED, candidate->key, candidate->val.flags & JSON_AUTO_FLAG_KEY_DECODED)) continue;
+                    other = candidate;
+                    break;
+                }
+                if(!other || !json_auto_eq(&kv->val, &other->val)) return false;
+            }
+            return true;
+        }
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), a->id);
+    }
+}
+
+#define JSON_AUTO_HASH_SEED     0xcbf29ce484222325ULL
+#define JSON_AUTO_HASH_PRIME    0x9e3779b97f4a7c15ULL
+
+uint64_t json_auto_hash_word(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * JSON_AUTO_HASH_PRIME;
+    return hash ^ (hash >> 32);
+}
+
+/* eight bytes at a time, read as little endian so the result is portable */
+uint64_t json_auto_hash_bytes(uint64_t hash, const void *data, size_t len) {
+    const unsigned char *bytes = data;
+    size_t i = 0;
+    for(; i + 8 <= len; i += 8) {
+        uint64_t word = 0;
+        for(size_t j = 0; j < 8; ++j) word |= (uint64_t)bytes[i + j] << (8 * j);
+        hash = json_auto_hash_word(hash, word);
+    }
+    uint64_t tail = (uint64_t)(len & 0xFF) << 56;
+    for(size_t j = 0; i + j < len; ++j) tail |= (uint64_t)bytes[i + j] << (8 * j);
+    return json_auto_hash_word(hash, tail);
+}
+
+uint64_t json_auto_hash_mix(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+uint64_t json_auto_hash_so(So s, bool decoded) {
+    if(decoded || !s.len || !memchr(s.str, '\\', s.len)) {
+        return json_auto_hash_bytes(JSON_AUTO_HASH_SEED, s.str, s.len);
+    }
+    /* the decoded text as it comes out, into the same words json_auto_hash_bytes makes */
+    uint64_t hash = JSON_AUTO_HASH_SEED, word = 0;
+    size_t len = 0;
+    char buf[4];
+    So piece = SO;
+    while(json_fix_next(&s, buf, &piece)) {
+        for(size_t i = 0; i < piece.len; ++i, ++len) {
+            word |= (uint64_t)(unsigned char)piece.str[i] << (8 * (len & 7));
+            if((len & 7) == 7) {
+                hash = json_auto_hash_word(hash, word);
+                word = 0;
+            }
+        }
+    }
+    return json_auto_hash_word(hash, word | (uint64_t)(len & 0xFF) << 56);
+}
+
+/* numbers hash as the double they read as, which is what the canonical form
+ * writes: 2^53 + 1 and 2^53 hash the same, as json_auto_eq has 2^53 + 1 equal
+ * to 2^53 written as a double */
+uint64_t json_auto_hash_double(double f) {
+    if(f == 0) f = 0; /* -0 */
+    uint64_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return json_auto_hash_mix(json_auto_hash_mix(bits) ^ 5);
+}
+
+uint64_t json_auto_hash_size(size_t z) {
+    return json_auto_hash_double((double)z);
+}
+
+uint64_t json_auto_hash(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    autojson = json_auto_borrow(autojson);
+    if(autojson->flags & JSON_AUTO_FLAG_HASHED) return autojson->hash;
+    uint64_t result = 0;
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_NULL: result = json_auto_hash_mix(1); break;
+        case JSON_AUTO_VALUE_BOOL: result = json_auto_hash_mix(2 + autojson->b); break;
+        case JSON_AUTO_VALUE_SIZE: result = json_auto_hash_size(autojson->z); break;
+        case JSON_AUTO_VALUE_DOUBLE: result = json_auto_hash_double(autojson->f); break;
+        case JSON_AUTO_VALUE_STRING: {
+            result = json_auto_hash_mix(json_auto_hash_so(autojson->so, autojson->flags & JSON_AUTO_FLAG_DECODED) ^ 6);
+        } break;
+        case JSON_AUTO_VALUE_ARRAY: {
+            result = JSON_AUTO_HASH_SEED ^ 7;
+            for(size_t i = 0; i < array_len(autojson->arr); ++i) {
+                result = json_auto_hash_word(result, json_auto_hash(array_it(autojson->arr, i)));
+            }
+            result = json_auto_hash_mix(result);
+        } break;
+        /* same as the array they unpack into */
+        case JSON_AUTO_VALUE_SIZES: {
+            result = JSON_AUTO_HASH_SEED ^ 7;
+            for(size_t i = 0; i < array_len(autojson->sizes); ++i) {
+                result = json_auto_hash_word(result, json_auto_hash_size(array_at(autojson->sizes, i)));
+            }
+            result = json_auto_hash_mix(result);
+        } break;
+        case JSON_AUTO_VALUE_DOUBLES: {
+            result = JSON_AUTO_HASH_SEED ^ 7;
+            for(size_t i = 0; i < array_len(autojson->doubles); ++i) {
+                result = json_auto_hash_word(result, json_auto_hash_double(array_at(autojson->doubles, i)));
+            }
+            result = json_auto_hash_mix(result);
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            /* members are summed up, so their order doesn't matter */
+            result = 8;
+            for(size_t i = 0; i < array_len(autojson->dict); ++i) {
+                Json_Auto_Key_Value *kv = array_it(autojson->dict, i);
+                uint64_t key = json_auto_hash_so(kv->key, kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED);
+                result += json_auto_hash_mix(key ^ json_auto_hash_mix(json_auto_hash(&kv->val) + 9));
+            }
+            result = json_auto_hash_mix(result);
+        } break;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), autojson->id);
+    }
+    if(autojson->id == JSON_AUTO_VALUE_ARRAY || autojson->id == JSON_AUTO_VALUE_OBJECT ||
+       autojson->id == JSON_AUTO_VALUE_SIZES || autojson->id == JSON_AUTO_VALUE_DOUBLES) {
+        /* until the level gets edited, see json_auto_materialize */
+        autojson->hash = result;
+        autojson->flags |= JSON_AUTO_FLAG_HASHED;
+    }
+    return result;
+}
+
+void json_auto_unhash(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    /* frozen ones keep theirs */
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_ARRAY: {
+            for(size_t i = 0; i < array_len(autojson->arr); ++i) json_auto_unhash(array_it(autojson->arr, i));
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            for(size_t i = 0; i < array_len(autojson->dict); ++i) json_auto_unhash(&array_it(autojson->dict, i)->val);
+        } break;
+        case JSON_AUTO_VALUE_SIZES:
+        case JSON_AUTO_VALUE_DOUBLES: break;
+        default: return;
+    }
+    autojson->flags &= ~JSON_AUTO_FLAG_HASHED;
+}
+
+/* escape decoded strings again, raw ones are still valid json */
+void json_auto_fmt_so(So *out, So s, bool decoded) {
+    so_push(out, '"');
+    if(!decoded) {
+        so_extend(out, s);
+    } else {
+        size_t begin = 0;
+        for(size_t i = 0; i < s.len; ++i) {
+            unsigned char c = (unsigned char)s.str[i];
+            if(c >= ' ' && c != '"' && c != '\\') continue;
+            so_extend(out, so_ll(s.str + begin, i - begin));
+            begin = i + 1;
+            switch(c) {
+                case '"':  so_extend(out, so("\\\"")); break;
+                case '\\': so_extend(out, so("\\\\")); break;
+                case '\b': so_extend(out, so("\\b")); break;
+                case '\f': so_extend(out, so("\\f")); break;
+                case '\n': so_extend(out, so("\\n")); break;
+                case '\r': so_extend(out, so("\\r")); break;
+                case '\t': so_extend(out, so("\\t")); break;
+                default: so_fmt(out, "\\u%04x", c); break;
+            }
+        }
+        so_extend(out, so_ll(s.str + begin, s.len - begin));
+    }
+    so_push(out, '"');
+}
+
+void json_auto_print_so(So s, bool decoded) {
+    So out = SO;
+    json_auto_fmt_so(&out, s, decoded);
+    printf("%.*s", SO_F(out));
+    so_free(&out);
 }
 
 void json_auto_fmt_spacing(So *out, Json_Auto_Fmt *fmt, int nest) {
@@ -117,6 +1016,63 @@ void json_auto_print_spacing(Json_Auto_Fmt *fmt, int nest) {
     }
 }
 
+/* longest "%f" of a double: sign, 309 digits, point, 6 decimals */
+#define JSON_AUTO_NUMBER_MAX    320
+
+size_t json_auto_fmt_size(char *buf, size_t z) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + z % 10);
+        z /= 10;
+    } while(z);
+    for(size_t i = 0; i < n; ++i) buf[i] = digits[n - 1 - i];
+    return n;
+}
+
+/* packed arrays are written into a local buffer, which goes out in one piece
+ * whenever it fills up; same text as the array they unpack into */
+void json_auto_fmt_packed(So *out, Json_Auto_Value *autojson, Json_Auto_Fmt *fmt, int nest) {
+    char buf[4096];
+    size_t used = 0;
+    So sep = SO;
+    so_push(&sep, ',');
+    if(fmt->pretty) so_push(&sep, '\n');
+    json_auto_fmt_spacing(&sep, fmt, nest + 1);
+    so_push(out, '[');
+    if(fmt->pretty) so_push(out, '\n');
+    json_auto_fmt_spacing(out, fmt, nest + 1);
+    size_t len = json_auto_len(autojson);
+    for(size_t i = 0; i < len; ++i) {
+        if(i) {
+            if(used + so_len(sep) > sizeof(buf)) {
+                so_extend(out, so_ll(buf, used));
+                used = 0;
+            }
+            if(so_len(sep) > sizeof(buf)) {
+                so_extend(out, sep);
+            } else {
+                memcpy(buf + used, so_it0(sep), so_len(sep));
+                used += so_len(sep);
+            }
+        }
+        if(used + JSON_AUTO_NUMBER_MAX > sizeof(buf)) {
+            so_extend(out, so_ll(buf, used));
+            used = 0;
+        }
+        if(autojson->id == JSON_AUTO_VALUE_SIZES) {
+            used += json_auto_fmt_size(buf + used, array_at(autojson->sizes, i));
+        } else {
+            used += (size_t)snprintf(buf + used, sizeof(buf) - used, "%f", array_at(autojson->doubles, i));
+        }
+    }
+    so_extend(out, so_ll(buf, used));
+    so_free(&sep);
+    if(fmt->pretty) so_push(out, '\n');
+    json_auto_fmt_spacing(out, fmt, nest);
+    so_push(out, ']');
+}
+
 void json_auto_print_ext(Json_Auto_Value autojson, Json_Auto_Fmt *fmt, int nest) {
     switch(autojson.id) {
         case JSON_AUTO_VALUE_ARRAY: {
@@ -154,7 +1110,8 @@ void json_auto_print_ext(Json_Auto_Value autojson, Json_Auto_Fmt *fmt, int nest)
                     if(fmt->pretty) printf("\n");
                 }
                 json_auto_print_spacing(fmt, nest + 1);
-                printf("\"%.*s\":", SO_F(sub.key)); // TODO need to escape "
+                json_auto_print_so(sub.key, sub.val.flags & JSON_AUTO_FLAG_KEY_DECODED);
+                printf(":");
                 if(fmt->pretty) printf(" ");
                 json_auto_print_ext(sub.val, fmt, nest + 1);
             }
@@ -166,8 +1123,20 @@ void json_auto_print_ext(Json_Auto_Value autojson, Json_Auto_Fmt *fmt, int nest)
             printf("%zu", autojson.z);
         } break;
         case JSON_AUTO_VALUE_STRING: {
-            printf("\"%.*s\"", SO_F(autojson.so)); // TODO need to escape "
+            json_auto_print_so(autojson.so, autojson.flags & JSON_AUTO_FLAG_DECODED);
         } break;
+        case JSON_AUTO_VALUE_LAZY: {
+            json_auto_print_ext(*json_auto_materialize(&autojson), fmt, nest);
+            json_auto_free(&autojson);
+        } break;
+        case JSON_AUTO_VALUE_SIZES:
+        case JSON_AUTO_VALUE_DOUBLES: {
+            So out = SO;
+            json_auto_fmt_packed(&out, &autojson, fmt, nest);
+            printf("%.*s", SO_F(out));
+            so_free(&out);
+        } break;
+        case JSON_AUTO_VALUE_SHARED: json_auto_print_ext(autojson.shared->val, fmt, nest); break;
         default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), autojson.id);
     }
 }
@@ -209,7 +1178,8 @@ void json_auto_fmt_ext(So *out, Json_Auto_Value autojson, Json_Auto_Fmt *fmt, in
                     if(fmt->pretty) so_push(out, '\n');
                 }
                 json_auto_fmt_spacing(out, fmt, nest + 1);
-                so_fmt(out, "\"%.*s\":", SO_F(sub.key)); // TODO need to escape "
+                json_auto_fmt_so(out, sub.key, sub.val.flags & JSON_AUTO_FLAG_KEY_DECODED);
+                so_push(out, ':');
                 if(fmt->pretty) so_push(out, ' ');
                 json_auto_fmt_ext(out, sub.val, fmt, nest + 1);
             }
@@ -221,8 +1191,17 @@ void json_auto_fmt_ext(So *out, Json_Auto_Value autojson, Json_Auto_Fmt *fmt, in
             so_fmt(out, "%zu", autojson.z);
         } break;
         case JSON_AUTO_VALUE_STRING: {
-            so_fmt(out, "\"%.*s\"", SO_F(autojson.so)); // TODO need to escape "
+            json_auto_fmt_so(out, autojson.so, autojson.flags & JSON_AUTO_FLAG_DECODED);
+        } break;
+        case JSON_AUTO_VALUE_LAZY: {
+            /* through a temporary level, so the text gets formatted like any
+             * other (and snapshots have none); levels below stay lazy */
+            json_auto_fmt_ext(out, *json_auto_materialize(&autojson), fmt, nest);
+            json_auto_free(&autojson);
         } break;
+        case JSON_AUTO_VALUE_SIZES:
+        case JSON_AUTO_VALUE_DOUBLES: json_auto_fmt_packed(out, &autojson, fmt, nest); break;
+        case JSON_AUTO_VALUE_SHARED: json_auto_fmt_ext(out, autojson.shared->val, fmt, nest); break;
         default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), autojson.id);
     }
 }
@@ -251,8 +1230,165 @@ void json_auto_fmt(So *out, Json_Auto_Value autojson, Json_Auto_Fmt *fmt) {
     }
 }
 
+/* RFC 8785 numbers: the shortest digits that read back as the same double,
+ * laid out like ECMAScript's Number.prototype.toString */
+void json_auto_fmt_canonical_number(So *out, double f) {
+    if(f == 0) {
+        so_push(out, '0');
+        return;
+    }
+    if(f < 0) {
+        so_push(out, '-');
+        f = -f;
+    }
+    if(f < 9007199254740992.0 && f == (double)(uint64_t)f) {
+        so_fmt(out, "%" PRIu64, (uint64_t)f);
+        return;
+    }
+    /* rounded to 15 digits reads back if anything shorter does, except for
+     * subnormals, which carry fewer digits */
+    char buf[32];
+    for(int digits = f < DBL_MIN ? 1 : 15; digits <= 17; ++digits) {
+        snprintf(buf, sizeof(buf), "%.*e", digits - 1, f);
+        if(strtod(buf, 0) == f) break;
+    }
+    char digits[20];
+    int k = 0;
+    char *p = buf;
+    for(; *p != 'e'; ++p) {
+        if(*p != '.') digits[k++] = *p;
+    }
+    while(k > 1 && digits[k - 1] == '0') --k;
+    int n = atoi(p + 1) + 1;
+    if(k <= n && n <= 21) {
+        so_extend(out, so_ll(digits, k));
+        for(int i = k; i < n; ++i) so_push(out, '0');
+    } else if(0 < n && n <= 21) {
+        so_extend(out, so_ll(digits, n));
+        so_push(out, '.');
+        so_extend(out, so_ll(digits + n, k - n));
+    } else if(-6 < n && n <= 0) {
+        so_extend(out, so("0."));
+        for(int i = n; i < 0; ++i) so_push(out, '0');
+        so_extend(out, so_ll(digits, k));
+    } else {
+        so_push(out, digits[0]);
+        if(k > 1) {
+            so_push(out, '.');
+            so_extend(out, so_ll(digits + 1, k - 1));
+        }
+        so_fmt(out, "e%c%d", n - 1 < 0 ? '-' : '+', n - 1 < 0 ? 1 - n : n - 1);
+    }
+}
+
+uint32_t json_auto_utf8_point(So s) {
+    unsigned char c = (unsigned char)s.str[0];
+    size_t len = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+    if(len > s.len) return c;
+    uint32_t point = len == 1 ? c : c & (0x7F >> len);
+    for(size_t i = 1; i < len; ++i) point = (point << 6) | ((unsigned char)s.str[i] & 0x3F);
+    return point;
+}
+
+/* RFC 8785 sorts keys by their UTF-16 code units, which only differs from
+ * comparing UTF-8 bytes where U+E000..U+FFFF meets U+10000 and up */
+int json_auto_utf16_cmp(So a, So b) {
+    size_t n = a.len < b.len ? a.len : b.len;
+    size_t i = 0;
+    while(i < n && a.str[i] == b.str[i]) ++i;
+    if(i == n) return a.len < b.len ? -1 : a.len > b.len;
+    while(i && ((unsigned char)a.str[i] & 0xC0) == 0x80) --i;
+    uint32_t pa = json_auto_utf8_point(so_ll(a.str + i, a.len - i));
+    uint32_t pb = json_auto_utf8_point(so_ll(b.str + i, b.len - i));
+    uint32_t ua = pa >= 0x10000 ? 0xD800 + ((pa - 0x10000) >> 10) : pa;
+    uint32_t ub = pb >= 0x10000 ? 0xD800 + ((pb - 0x10000) >> 10) : pb;
+    if(ua != ub) return ua < ub ? -1 : 1;
+    return pa < pb ? -1 : pa > pb;
+}
+
+typedef struct Json_Auto_Canonical_Member {
+    So key; /* decoded */
+    So fix;
+    Json_Auto_Value *val;
+} Json_Auto_Canonical_Member;
+
+int json_auto_canonical_member_cmp(const void *a, const void *b) {
+    const Json_Auto_Canonical_Member *ma = a, *mb = b;
+    return json_auto_utf16_cmp(ma->key, mb->key);
+}
+
+/* decoded view of s, *fix holds the copy if one was needed */
+So json_auto_canonical_so(So s, bool decoded, So *fix) {
+    if(decoded || !s.len || !memchr(s.str, '\\', s.len)) return s;
+    so_extend(fix, s);
+    json_fix_so(*fix, &s);
+    return s;
+}
+
+void json_auto_fmt_canonical(So *out, Json_Auto_Value *autojson) {
+    ASSERT_ARG(out);
+    ASSERT_ARG(autojson);
+    autojson = json_auto_borrow(autojson);
+    if(json_auto_packed(autojson)) {
+        so_push(out, '[');
+        for(size_t i = 0; i < json_auto_len(autojson); ++i) {
+            if(i) so_push(out, ',');
+            Json_Auto_Value sub = json_auto_packed_at(autojson, i);
+            json_auto_fmt_canonical(out, &sub);
+        }
+        so_push(out, ']');
+        return;
+    }
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_NULL: so_extend(out, so("null")); break;
+        case JSON_AUTO_VALUE_BOOL: so_extend(out, autojson->b ? so("true") : so("false")); break;
+        case JSON_AUTO_VALUE_SIZE: {
+            if(autojson->z <= 9007199254740992ULL) so_fmt(out, "%zu", autojson->z);
+            else json_auto_fmt_canonical_number(out, (double)autojson->z);
+        } break;
+        case JSON_AUTO_VALUE_DOUBLE: json_auto_fmt_canonical_number(out, autojson->f); break;
+        case JSON_AUTO_VALUE_STRING: {
+            So fix = SO;
+            json_auto_fmt_so(out, json_auto_canonical_so(autojson->so, autojson->flags & JSON_AUTO_FLAG_DECODED, &fix), true);
+            so_free(&fix);
+        } break;
+        case JSON_AUTO_VALUE_ARRAY: {
+            so_push(out, '[');
+            for(size_t i = 0; i < array_len(autojson->arr); ++i) {
+                if(i) so_push(out, ',');
+                json_auto_fmt_canonical(out, array_it(autojson->arr, i));
+            }
+            so_push(out, ']');
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            size_t n = array_len(autojson->dict);
+            Json_Auto_Canonical_Member *members = 0;
+            for(size_t i = 0; i < n; ++i) {
+                Json_Auto_Key_Value *kv = array_it(autojson->dict, i);
+                Json_Auto_Canonical_Member member = { .val = &kv->val };
+                member.key = json_auto_canonical_so(kv->key, kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED, &member.fix);
+                array_push(members, member);
+            }
+            if(n) qsort(members, n, sizeof(*members), json_auto_canonical_member_cmp);
+            so_push(out, '{');
+            for(size_t i = 0; i < n; ++i) {
+                if(i) so_push(out, ',');
+                json_auto_fmt_so(out, array_it(members, i)->key, true);
+                so_push(out, ':');
+                json_auto_fmt_canonical(out, array_it(members, i)->val);
+                so_free(&array_it(members, i)->fix);
+            }
+            so_push(out, '}');
+            array_free(members);
+        } break;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), autojson->id);
+    }
+}
+
 void json_auto_free_kv(Json_Auto_Key_Value *autojson) {
-    so_free(&autojson->key);
+    if(autojson->val.flags & JSON_AUTO_FLAG_KEY_OWNED) {
+        so_free(&autojson->key);
+    }
     json_auto_free(&autojson->val);
 }
 
@@ -265,13 +1401,20 @@ void json_auto_free(Json_Auto_Value *autojson) {
         case JSON_AUTO_VALUE_OBJECT: {
             array_free_ext(autojson->dict, json_auto_free_kv);
         } break;
+        case JSON_AUTO_VALUE_SIZES: array_free(autojson->sizes); break;
+        case JSON_AUTO_VALUE_DOUBLES: array_free(autojson->doubles); break;
+        case JSON_AUTO_VALUE_SHARED: json_auto_shared_release(autojson->shared); break;
         case JSON_AUTO_VALUE_STRING: {
-            so_free(&autojson->so);
+            /* borrowed strings belong to the input */
+            if(autojson->flags & JSON_AUTO_FLAG_OWNED) {
+                so_free(&autojson->so);
+            }
         } break;
         /* never ever have to free anything */
         case JSON_AUTO_VALUE_DOUBLE:
         case JSON_AUTO_VALUE_BOOL:
         case JSON_AUTO_VALUE_NULL:
+        case JSON_AUTO_VALUE_LAZY:
         case JSON_AUTO_VALUE_SIZE: break;
         default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), autojson->id);
     }
@@ -2,6 +2,10 @@
 
 #include "rljson-core.h"
 
+#ifndef JSON_AUTO_LAZY_DEPTH_MAX
+#define JSON_AUTO_LAZY_DEPTH_MAX    64
+#endif
+
 typedef enum {
     JSON_AUTO_VALUE_NULL,
     JSON_AUTO_VALUE_BOOL,
@@ -10,18 +14,47 @@ typedef enum {
     JSON_AUTO_VALUE_STRING,
     JSON_AUTO_VALUE_OBJECT,
     JSON_AUTO_VALUE_ARRAY,
+    JSON_AUTO_VALUE_LAZY, /* not yet parsed object or array, .so is its raw text (or snapshot node) */
+    JSON_AUTO_VALUE_SIZES,   /* array of only JSON_AUTO_VALUE_SIZE, packed into .sizes */
+    JSON_AUTO_VALUE_DOUBLES, /* array of only JSON_AUTO_VALUE_DOUBLE, packed into .doubles */
+    JSON_AUTO_VALUE_SHARED,  /* reference to an immutable object or array, see json_auto_share */
 } Json_Auto_Value_List ;
 
+/* ownership of strings inside a tree.
+ *
+ * strings (.so and keys) are borrowed views into the parsed input by default:
+ * the input has to outlive the tree and json_auto_free() never touches them.
+ * only strings flagged as owned are freed by json_auto_free(). decoded strings
+ * have their escapes resolved (see json_auto_parse_insitu) and are escaped
+ * again when formatting. */
+typedef enum {
+    JSON_AUTO_FLAG_OWNED        = 1 << 0, /* .so is heap allocated, freed by json_auto_free */
+    JSON_AUTO_FLAG_DECODED      = 1 << 1, /* .so has no escapes left */
+    JSON_AUTO_FLAG_KEY_OWNED    = 1 << 2, /* same as above, but for the key of the Json_Auto_Key_Value this value is in */
+    JSON_AUTO_FLAG_KEY_DECODED  = 1 << 3,
+    JSON_AUTO_FLAG_BINARY       = 1 << 4, /* lazy value of a binary snapshot, see rljson-bin.h */
+    JSON_AUTO_FLAG_HASHED       = 1 << 5, /* object or array with a valid .hash, see json_auto_hash */
+} Json_Auto_Flag_List;
+
 typedef struct Json_Auto_Value {
     union {
         bool b;
         size_t z;
         double f;
         So so;
-        struct Json_Auto_Value *arr;
-        struct Json_Auto_Key_Value *dict;
+        struct {
+            union {
+                struct Json_Auto_Value *arr;
+                struct Json_Auto_Key_Value *dict;
+                size_t *sizes;
+                double *doubles;
+                struct Json_Auto_Shared *shared;
+            };
+            uint64_t hash; /* cached content hash, see json_auto_hash */
+        };
     };
     Json_Auto_Value_List id;
+    unsigned char flags;
 } Json_Auto_Value;
 
 typedef struct Json_Auto_Key_Value {
@@ -35,10 +68,132 @@ typedef struct Json_Auto_Fmt {
     int tabs;
 } Json_Auto_Fmt;
 
+/* Json_Parse_Limits.memory: the tree is made of arrays of values and of
+ * key-value pairs, so its size follows from the number of values. one value
+ * costs at most its slot twice over, as arrays grow by doubling, and once
+ * more for the array it may open itself. the memory limit becomes a limit
+ * on values, checked by the core while parsing, and reported as
+ * JSON_ERROR_LIMIT_MEMORY. strings are views into the input and not counted;
+ * lazy trees are held to what they may become once fully parsed */
+#ifndef JSON_AUTO_NODE_BYTES
+#define JSON_AUTO_NODE_BYTES    (3 * sizeof(Json_Auto_Key_Value))
+#endif
+size_t json_auto_limit_nodes(Json_Parse_Limits limits); /* .memory as a limit on values, or .nodes if tighter */
+
 ErrDecl json_auto_parse(So input, Json_Auto_Value *out);
 ErrDecl json_auto_parse_ext(So input, Json_Auto_Value *out, Json_Parse_Settings *settings);
+ErrDecl json_auto_parse_parser(Json_Parser *parser, So input, Json_Auto_Value *out);
+ErrDecl json_auto_parse_insitu(So input, Json_Auto_Value *out, Json_Parse_Settings *settings); /* decodes strings inside of input, which has to be writable */
+/* lazy parsing: the input is validated as a whole, but objects and arrays are
+ * only stored as their raw text (JSON_AUTO_VALUE_LAZY) until an accessor
+ * descends into them. then exactly that level is parsed and kept, nested
+ * objects and arrays again staying lazy, unless they nest deeper than
+ * JSON_AUTO_LAZY_DEPTH_MAX. the input has to outlive the tree. with
+ * JSON_DUPLICATES_FIRST or _LAST everything is parsed right away, as by
+ * json_auto_parse_ext.
+ * the validation pass reads all of the input before returning, so the time
+ * to the first access still grows with the document; what is saved is the
+ * tree of the levels never visited. formatting and printing parse the lazy
+ * levels they pass into temporary ones, which are dropped again, so the
+ * output follows Json_Auto_Fmt like that of any other tree. */
+ErrDecl json_auto_parse_lazy(So input, Json_Auto_Value *out, Json_Parse_Settings *settings);
+/* convert number text the way the parsers do: JSON_AUTO_VALUE_SIZE,
+ * JSON_AUTO_VALUE_DOUBLE, or JSON_AUTO_VALUE_STRING if out of range */
+void json_auto_number(So s, Json_Auto_Value *out);
+/* the callback behind json_auto_parse, for other event sources like
+ * json_parser_parse_pack; objects and arrays at the root need .id set up front */
+void *json_auto_parse_value(void **user, Json_Parse_Value key, Json_Parse_Value *val);
+
+/* packed arrays, opt-in with Json_Parse_Settings.pack: while parsing, arrays
+ * holding nothing but numbers of one kind are stored as plain size_t or double
+ * arrays instead of one Json_Auto_Value per element. length, comparing,
+ * hashing, diffing and formatting read them as they are; json_auto_at has no
+ * element to point at and returns 0, json_auto_element hands out a copy.
+ * editing, or json_auto_materialize, unpacks them into a regular
+ * JSON_AUTO_VALUE_ARRAY with the very same elements. lazy levels get parsed
+ * without the settings, so json_auto_parse_lazy doesn't pack. */
+size_t *json_auto_sizes(Json_Auto_Value *autojson, size_t *len); /* 0 if not JSON_AUTO_VALUE_SIZES */
+double *json_auto_doubles(Json_Auto_Value *autojson, size_t *len); /* 0 if not JSON_AUTO_VALUE_DOUBLES */
+/* array element, packed or not: packed ones are copied into *tmp. 0 if out of range or not an array */
+Json_Auto_Value *json_auto_element(Json_Auto_Value *autojson, size_t index, Json_Auto_Value *tmp);
+
+/* copies and ownership.
+ *
+ * json_auto_clone makes a deep copy that owns all of its strings: it depends
+ * on neither the input nor the source tree. json_auto_move takes a value out
+ * of a tree, leaving null behind (the key it is stored under stays).
+ *
+ * json_auto_share freezes a tree: every object and array in it becomes an
+ * immutable, reference counted JSON_AUTO_VALUE_SHARED (lazy values get parsed
+ * and all hashes computed first). json_auto_ref hands out another reference,
+ * so copies of a document cost one pointer. the mutation functions below copy
+ * on write: json_auto_materialize gives a shared level a private copy of
+ * itself, whose children stay shared. so a changed copy of a large document
+ * only copies the levels along the edited paths. references may be handed to
+ * other threads, reading them concurrently is fine; strings still borrowed
+ * from the input need the input to outlive every reference.
+ *
+ * json_auto_borrow is the read-only way in: lazy values get parsed, but shared
+ * ones are only looked through and packed arrays stay packed. what it returns
+ * must not be edited. */
+Json_Auto_Value json_auto_clone(Json_Auto_Value *autojson);
+Json_Auto_Value json_auto_move(Json_Auto_Value *autojson);
+void json_auto_share(Json_Auto_Value *autojson);
+Json_Auto_Value json_auto_ref(Json_Auto_Value *autojson); /* shares autojson first; scalars are just cloned */
+Json_Auto_Value *json_auto_borrow(Json_Auto_Value *autojson);
+
+/* accessors. they only read, through json_auto_borrow: what they return may
+ * sit inside a frozen level. to edit below the top of a tree, each level on
+ * the way down needs json_auto_materialize first, which parses, unpacks and
+ * unshares it and drops its cached hash, e.g.
+ * json_auto_get(json_auto_materialize(doc), key). the json_auto_pointer and
+ * patch functions do that along their paths. */
+Json_Auto_Value *json_auto_materialize(Json_Auto_Value *autojson);
+size_t json_auto_len(Json_Auto_Value *autojson);
+Json_Auto_Value *json_auto_at(Json_Auto_Value *autojson, size_t index); /* array element or object value */
+So json_auto_key(Json_Auto_Value *autojson, size_t index);
+Json_Auto_Value *json_auto_get(Json_Auto_Value *autojson, So key); /* key is decoded */
+
+/* in-place mutation. values handed in are moved into the tree, removed ones
+ * are moved out into *out (or freed, if out is 0). keys are stored as given,
+ * their ownership and decoding flags are taken from the value (..._KEY_...).
+ * objects are plain arrays of members without an index: finding a key
+ * (json_auto_get, _dict_find, _dict_set, _dict_remove and the patch paths)
+ * scans the level, O(width) per call. escaped keys are compared as they get
+ * decoded, without copying. many lookups in one wide object are better off
+ * with an index of their own, like json_auto_diff builds per level. */
+ErrDecl json_auto_arr_insert(Json_Auto_Value *autojson, size_t index, Json_Auto_Value val); /* index == len appends */
+ErrDecl json_auto_arr_remove(Json_Auto_Value *autojson, size_t index, Json_Auto_Value *out);
+ErrDecl json_auto_arr_replace(Json_Auto_Value *autojson, size_t index, Json_Auto_Value val);
+ErrDecl json_auto_dict_set(Json_Auto_Value *autojson, So key, Json_Auto_Value val); /* replaces the value of an existing key */
+ErrDecl json_auto_dict_remove(Json_Auto_Value *autojson, So key, Json_Auto_Value *out); /* key is decoded */
+Json_Auto_Key_Value *json_auto_dict_find(Json_Auto_Value *autojson, So key); /* key is decoded */
+
+/* compare by content: escapes resolved, numbers by value, objects ignoring
+ * member order. json_auto_so_cmp orders bytewise, a prefix first */
+int json_auto_so_cmp(So a, bool a_decoded, So b, bool b_decoded);
+bool json_auto_eq(Json_Auto_Value *a, Json_Auto_Value *b);
+
+/* 64 bit content hash, by the same rules as json_auto_eq. equal hashes don't
+ * make equal values, confirm with json_auto_eq. objects and arrays keep theirs
+ * in .hash once computed, so hashing again costs only what changed:
+ * json_auto_materialize and the mutation functions drop the cache of the level
+ * they edit, but a level can't tell its parents. editing below the top the
+ * way the accessors describe (json_auto_materialize on every level down)
+ * drops the hashes along the path; after edits that went in any other way,
+ * json_auto_unhash drops those of a whole tree (but of frozen levels). */
+uint64_t json_auto_hash(Json_Auto_Value *autojson);
+uint64_t json_auto_hash_so(So s, bool decoded);
+void json_auto_unhash(Json_Auto_Value *autojson);
+
 void json_auto_print(Json_Auto_Value autojson, Json_Auto_Fmt *fmt);
 void json_auto_fmt(So *out, Json_Auto_Value autojson, Json_Auto_Fmt *fmt);
+/* canonical form (RFC 8785, JCS): no whitespace, members sorted by key,
+ * strings minimally escaped and numbers as the shortest text that reads back
+ * as the same double. trees with the same canonical form have the same
+ * json_auto_hash, so the hash can serve as a cache key without formatting
+ * anything. lazy values of autojson get parsed. */
+void json_auto_fmt_canonical(So *out, Json_Auto_Value *autojson);
 void json_auto_free(Json_Auto_Value *autojson);
 
 #define RLJSON_AUTO_H
@@ -0,0 +1,345 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "rljson-bin.h"
+
+/* layout, all offsets are relative to the start of the struct they are in:
+ *
+ *  Json_Bin_Header
+ *  Json_Bin_Node           root
+ *  ...                     children blocks and string bytes, each 8 aligned
+ *
+ * arrays point to a block of .count Json_Bin_Node, objects to a block of
+ * .count Json_Bin_Key_Value, strings to their .count bytes. */
+
+typedef struct Json_Bin_Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t reserved;
+    uint64_t size;
+} Json_Bin_Header;
+
+typedef struct Json_Bin_Node {
+    uint32_t id;
+    uint32_t flags;
+    uint64_t count;
+    uint64_t data;
+} Json_Bin_Node;
+
+typedef struct Json_Bin_Key_Value {
+    uint64_t key_len;
+    uint64_t key;
+    Json_Bin_Node val;
+} Json_Bin_Key_Value;
+
+#define JSON_BIN_ENDIAN     0x01020304
+#define JSON_BIN_ALIGN(x)   (((x) + 7) & ~(size_t)7)
+
+/* append zeroed bytes, return their offset */
+size_t json_bin_reserve(So *out, size_t bytes) {
+    size_t len = so_len(*out);
+    size_t at = JSON_BIN_ALIGN(len);
+    size_t end = at + JSON_BIN_ALIGN(bytes);
+    if(end > len) {
+        so_resize(out, end);
+        memset(so_it(*out, len), 0, end - len);
+    }
+    return at;
+}
+
+size_t json_bin_string(So *out, So s) {
+    size_t at = json_bin_reserve(out, s.len);
+    if(s.len) memcpy(so_it(*out, at), s.str, s.len);
+    return at;
+}
+
+/* the node at offset 'at' has already been reserved */
+void json_bin_node(So *out, size_t at, Json_Auto_Value *autojson) {
+    /* the key belongs to the slot, the rest to what it holds */
+    unsigned char key_flags = autojson->flags & JSON_AUTO_FLAG_KEY_DECODED;
+    autojson = json_auto_borrow(autojson);
+    size_t packed = 0;
+    size_t *sizes = json_auto_sizes(autojson, &packed);
+    double *doubles = json_auto_doubles(autojson, &packed);
+    if(sizes || doubles) {
+        /* stored like the array they unpack into */
+        Json_Bin_Node node = {
+            .id = JSON_AUTO_VALUE_ARRAY,
+            .flags = key_flags,
+            .count = packed,
+        };
+        size_t block = json_bin_reserve(out, packed * sizeof(Json_Bin_Node));
+        node.data = block - at;
+        for(size_t i = 0; i < packed; ++i) {
+            Json_Bin_Node sub = { .id = sizes ? JSON_AUTO_VALUE_SIZE : JSON_AUTO_VALUE_DOUBLE };
+            if(sizes) sub.data = sizes[i];
+            else memcpy(&sub.data, &doubles[i], sizeof(sub.data));
+            memcpy(so_it(*out, block + i * sizeof(Json_Bin_Node)), &sub, sizeof(sub));
+        }
+        memcpy(so_it(*out, at), &node, sizeof(node));
+        return;
+    }
+    Json_Bin_Node node = {
+        .id = autojson->id,
+        .flags = (autojson->flags & JSON_AUTO_FLAG_DECODED) | key_flags,
+    };
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_NULL: break;
+        case JSON_AUTO_VALUE_BOOL: node.data = autojson->b; break;
+        case JSON_AUTO_VALUE_SIZE: node.data = autojson->z; break;
+        case JSON_AUTO_VALUE_DOUBLE: memcpy(&node.data, &autojson->f, sizeof(node.data)); break;
+        case JSON_AUTO_VALUE_STRING: {
+            node.count = autojson->so.len;
+            node.data = json_bin_string(out, autojson->so) - at;
+        } break;
+        case JSON_AUTO_VALUE_ARRAY: {
+            node.count = array_len(autojson->arr);
+            size_t block = json_bin_reserve(out, node.count * sizeof(Json_Bin_Node));
+            node.data = block - at;
+            for(size_t i = 0; i < node.count; ++i) {
+                json_bin_node(out, block + i * sizeof(Json_Bin_Node), array_it(autojson->arr, i));
+            }
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            node.count = array_len(autojson->dict);
+            size_t block = json_bin_reserve(out, node.count * sizeof(Json_Bin_Key_Value));
+            node.data = block - at;
+            for(size_t i = 0; i < node.count; ++i) {
+                Json_Auto_Key_Value *kv = array_it(autojson->dict, i);
+                size_t kv_at = block + i * sizeof(Json_Bin_Key_Value);
+                Json_Bin_Key_Value bin_kv = {
+                    .key_len = kv->key.len,
+                    .key = json_bin_string(out, kv->key) - kv_at,
+                };
+                memcpy(so_it(*out, kv_at), &bin_kv, sizeof(bin_kv));
+                json_bin_node(out, kv_at + offsetof(Json_Bin_Key_Value, val), &kv->val);
+            }
+        } break;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), autojson->id);
+    }
+    memcpy(so_it(*out, at), &node, sizeof(node));
+}
+
+void json_auto_fmt_bin(So *out, Json_Auto_Value *autojson) {
+    ASSERT_ARG(out);
+    ASSERT_ARG(autojson);
+    size_t begin = json_bin_reserve(out, sizeof(Json_Bin_Header));
+    size_t root = json_bin_reserve(out, sizeof(Json_Bin_Node));
+    json_bin_node(out, root, autojson);
+    Json_Bin_Header header = {
+        .magic = JSON_BIN_MAGIC,
+        .version = JSON_BIN_VERSION,
+        .endian = JSON_BIN_ENDIAN,
+        .size = so_len(*out) - begin,
+    };
+    memcpy(so_it(*out, begin), &header, sizeof(header));
+}
+
+/* the node at the start of bin alone: it fits, uses only ids and flags
+ * json_bin_node writes, its string lies within bin and its block of children
+ * does too, behind the node. blocks only ever lie further on, so no level
+ * can hold itself. what the block holds is for the level below to check */
+bool json_bin_node_valid(So bin) {
+    Json_Bin_Node node;
+    if(bin.len < sizeof(node)) return false;
+    memcpy(&node, bin.str, sizeof(node));
+    if(node.flags & ~(uint32_t)(JSON_AUTO_FLAG_DECODED | JSON_AUTO_FLAG_KEY_DECODED)) return false;
+    switch(node.id) {
+        case JSON_AUTO_VALUE_NULL:
+        case JSON_AUTO_VALUE_BOOL:
+        case JSON_AUTO_VALUE_SIZE:
+        case JSON_AUTO_VALUE_DOUBLE: return true;
+        case JSON_AUTO_VALUE_STRING: return node.data <= bin.len && node.count <= bin.len - node.data;
+        case JSON_AUTO_VALUE_ARRAY:
+        case JSON_AUTO_VALUE_OBJECT: break;
+        default: return false;
+    }
+    size_t size = node.id == JSON_AUTO_VALUE_OBJECT ? sizeof(Json_Bin_Key_Value) : sizeof(Json_Bin_Node);
+    return node.data >= sizeof(node) && node.data <= bin.len && node.count <= (bin.len - node.data) / size;
+}
+
+/* the key of the member at the start of bin lies within bin */
+bool json_bin_key_valid(So bin) {
+    Json_Bin_Key_Value kv;
+    memcpy(&kv, bin.str, sizeof(kv));
+    return kv.key <= bin.len && kv.key_len <= bin.len - kv.key;
+}
+
+/* turn the node at the start of bin, checked by json_bin_node_valid, into a
+ * value; objects and arrays stay lazy, bin.len is what's left of the snapshot
+ * behind the node */
+Json_Auto_Value json_bin_value(So bin) {
+    Json_Bin_Node node;
+    Json_Auto_Value result = {0};
+    memcpy(&node, bin.str, sizeof(node));
+    result.id = node.id;
+    result.flags = node.flags;
+    switch(node.id) {
+        case JSON_AUTO_VALUE_NULL: break;
+        case JSON_AUTO_VALUE_BOOL: result.b = node.data; break;
+        case JSON_AUTO_VALUE_SIZE: result.z = node.data; break;
+        case JSON_AUTO_VALUE_DOUBLE: memcpy(&result.f, &node.data, sizeof(result.f)); break;
+        case JSON_AUTO_VALUE_STRING: result.so = so_ll(bin.str + node.data, node.count); break;
+        case JSON_AUTO_VALUE_ARRAY:
+        case JSON_AUTO_VALUE_OBJECT: {
+            result.id = JSON_AUTO_VALUE_LAZY;
+            result.flags |= JSON_AUTO_FLAG_BINARY;
+            result.so = bin;
+        } break;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), node.id);
+    }
+    return result;
+}
+
+/* the node at the start of bin and everything below it are valid, no deeper
+ * than JSON_DEPTH_MAX and no more than *nodes in number: a snapshot can't
+ * hold more nodes than fit into it, which also keeps blocks that many nodes
+ * refer to from blowing up */
+bool json_bin_valid(So bin, size_t depth, size_t *nodes) {
+    if(depth > JSON_DEPTH_MAX || !*nodes || !json_bin_node_valid(bin)) return false;
+    --*nodes;
+    Json_Bin_Node node;
+    memcpy(&node, bin.str, sizeof(node));
+    if(node.id != JSON_AUTO_VALUE_ARRAY && node.id != JSON_AUTO_VALUE_OBJECT) return true;
+    size_t size = node.id == JSON_AUTO_VALUE_OBJECT ? sizeof(Json_Bin_Key_Value) : sizeof(Json_Bin_Node);
+    for(size_t i = 0; i < node.count; ++i) {
+        size_t at = node.data + i * size;
+        if(node.id == JSON_AUTO_VALUE_OBJECT) {
+            if(!json_bin_key_valid(so_ll(bin.str + at, bin.len - at))) return false;
+            at += offsetof(Json_Bin_Key_Value, val);
+        }
+        if(!json_bin_valid(so_ll(bin.str + at, bin.len - at), depth + 1, nodes)) return false;
+    }
+    return true;
+}
+
+size_t json_auto_bin_len(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    Json_Bin_Node node;
+    memcpy(&node, autojson->so.str, sizeof(node));
+    return node.count;
+}
+
+ErrDecl json_auto_bin_materialize(Json_Auto_Value *autojson) {
+    ASSERT_ARG(autojson);
+    So bin = autojson->so;
+    Json_Bin_Node node;
+    memcpy(&node, bin.str, sizeof(node));
+    Json_Auto_Value result = {
+        .id = node.id,
+        .flags = autojson->flags & ~JSON_AUTO_FLAG_BINARY,
+    };
+    size_t size = node.id == JSON_AUTO_VALUE_OBJECT ? sizeof(Json_Bin_Key_Value) : sizeof(Json_Bin_Node);
+    /* this one level, in one go, every node checked as it gets copied;
+     * strings stay in the snapshot, nested objects and arrays stay lazy */
+    if(node.id == JSON_AUTO_VALUE_ARRAY) array_resize(result.arr, node.count);
+    else array_resize(result.dict, node.count);
+    for(size_t i = 0; i < node.count; ++i) {
+        size_t at = node.data + i * size;
+        if(node.id == JSON_AUTO_VALUE_ARRAY) {
+            So sub = so_ll(bin.str + at, bin.len - at);
+            if(!json_bin_node_valid(sub)) goto invalid;
+            array_at(result.arr, i) = json_bin_value(sub);
+        } else {
+            So kv = so_ll(bin.str + at, bin.len - at);
+            size_t val = at + offsetof(Json_Bin_Key_Value, val);
+            So sub = so_ll(bin.str + val, bin.len - val);
+            if(!json_bin_key_valid(kv) || !json_bin_node_valid(sub)) goto invalid;
+            Json_Bin_Key_Value bin_kv;
+            memcpy(&bin_kv, kv.str, sizeof(bin_kv));
+            array_at(result.dict, i) = (Json_Auto_Key_Value){
+                .key = so_ll(kv.str + bin_kv.key, bin_kv.key_len),
+                .val = json_bin_value(sub),
+            };
+        }
+    }
+    *autojson = result;
+    return 0;
+invalid:
+    /* nothing in the level is owned yet */
+    if(node.id == JSON_AUTO_VALUE_ARRAY) array_free(result.arr);
+    else array_free(result.dict);
+    return -1;
+}
+
+/* the root node behind a header that fits bin */
+ErrDecl json_bin_root(So bin, So *root) {
+    Json_Bin_Header header;
+    if(bin.len < sizeof(header) + sizeof(Json_Bin_Node)) return -1;
+    memcpy(&header, bin.str, sizeof(header));
+    if(memcmp(header.magic, JSON_BIN_MAGIC, sizeof(header.magic))) return -1;
+    if(header.version != JSON_BIN_VERSION) return -1;
+    if(header.endian != JSON_BIN_ENDIAN) return -1;
+    if(header.size > bin.len || header.size < sizeof(header) + sizeof(Json_Bin_Node)) return -1;
+    *root = so_ll(bin.str + sizeof(header), header.size - sizeof(header));
+    return 0;
+}
+
+ErrDecl json_auto_from_bin(So bin, Json_Auto_Value *out) {
+    ASSERT_ARG(out);
+    So root;
+    if(json_bin_root(bin, &root) || !json_bin_node_valid(root)) return -1;
+    *out = json_bin_value(root);
+    return 0;
+}
+
+ErrDecl json_auto_bin_check(So bin) {
+    So root;
+    if(json_bin_root(bin, &root)) return -1;
+    size_t nodes = root.len / sizeof(Json_Bin_Node);
+    return json_bin_valid(root, 0, &nodes) ? 0 : -1;
+}
+
+ErrDecl json_auto_save_bin(Json_Auto_Value *autojson, So path) {
+    ASSERT_ARG(autojson);
+    int result = -1;
+    So out = SO, cpath = SO;
+    so_extend(&cpath, path);
+    so_push(&cpath, 0);
+    json_auto_fmt_bin(&out, autojson);
+    FILE *file = fopen(so_it(cpath, 0), "wb");
+    if(!file) goto clean;
+    if(fwrite(so_it(out, 0), 1, so_len(out), file) != so_len(out)) goto clean;
+    result = 0;
+clean:
+    if(file && fclose(file)) result = -1;
+    so_free(&out);
+    so_free(&cpath);
+    return result;
+}
+
+ErrDecl json_auto_load_bin(So path, Json_Auto_Bin *bin) {
+    ASSERT_ARG(bin);
+    memset(bin, 0, sizeof(*bin));
+    So cpath = SO;
+    so_extend(&cpath, path);
+    so_push(&cpath, 0);
+    int fd = open(so_it(cpath, 0), O_RDONLY);
+    so_free(&cpath);
+    if(fd < 0) return -1;
+    struct stat st;
+    if(fstat(fd, &st) || !st.st_size) goto error;
+    bin->size = st.st_size;
+    bin->map = mmap(0, bin->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(bin->map == MAP_FAILED) goto error;
+    close(fd);
+    if(json_auto_from_bin(so_ll(bin->map, bin->size), &bin->root)) {
+        json_auto_bin_free(bin);
+        return -1;
+    }
+    return 0;
+error:
+    close(fd);
+    memset(bin, 0, sizeof(*bin));
+    return -1;
+}
+
+void json_auto_bin_free(Json_Auto_Bin *bin) {
+    if(!bin) return;
+    json_auto_free(&bin->root);
+    if(bin->map) munmap(bin->map, bin->size);
+    memset(bin, 0, sizeof(*bin));
+}
+
@@ -0,0 +1,48 @@
+#ifndef RLJSON_BIN_H
+
+#include "rljson-auto.h"
+
+/* binary snapshots of a Json_Auto_Value tree.
+ *
+ * nodes refer to their children and strings by offsets instead of pointers,
+ * so a snapshot can be mapped into memory and used as is. nothing gets built,
+ * the tree starts out as a lazy value and gets read through the accessors
+ * (json_auto_at, json_auto_get, ...) like any other. the first access to an
+ * object or array copies that one level into a regular one, one
+ * Json_Auto_Value per member, with strings borrowed from the mapping and
+ * nested levels still lazy. json_auto_len reads the count without copying.
+ * snapshots use the byte order of the machine that wrote them.
+ *
+ * loading checks the header, the size and the root node only, so it costs
+ * the same for any size of snapshot; a truncated one fails with -1. every
+ * other node gets checked (bounds, ids, flags) when its level is copied, and
+ * a level that fails reads as null from then on. that keeps every access
+ * within the snapshot, but a forged one can still nest deep enough to
+ * overflow the stack of anything walking the whole tree, or refer to one
+ * block from many nodes. json_auto_bin_check reads all of it once, bounding
+ * nesting by JSON_DEPTH_MAX and nodes by what fits; do that first for
+ * snapshots that can not be trusted. string contents are taken as they are. */
+
+#define JSON_BIN_MAGIC      "RLJB"
+#define JSON_BIN_VERSION    1
+
+typedef struct Json_Auto_Bin {
+    void *map;
+    size_t size;
+    Json_Auto_Value root;
+} Json_Auto_Bin;
+
+void json_auto_fmt_bin(So *out, Json_Auto_Value *autojson); /* lazy values of autojson get parsed */
+ErrDecl json_auto_from_bin(So bin, Json_Auto_Value *out); /* bin has to outlive out */
+ErrDecl json_auto_bin_check(So bin); /* every node, -1 if any is off */
+ErrDecl json_auto_save_bin(Json_Auto_Value *autojson, So path);
+ErrDecl json_auto_load_bin(So path, Json_Auto_Bin *bin);
+void json_auto_bin_free(Json_Auto_Bin *bin);
+
+/* used by json_auto_materialize and json_auto_len */
+ErrDecl json_auto_bin_materialize(Json_Auto_Value *autojson); /* -1 leaves autojson as it was */
+size_t json_auto_bin_len(Json_Auto_Value *autojson);
+
+#define RLJSON_BIN_H
+#endif // RLJSON_BIN_H
+
@@ -0,0 +1,214 @@
+#include <string.h>
+#include "rljson-columns.h"
+#include "rljson-auto.h"
+
+static inline uint64_t json_columns_hash(So key) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(size_t i = 0; i < key.len; ++i) hash = (hash ^ (unsigned char)key.str[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+void json_columns_init(Json_Columns *columns, Json_Column_Spec *spec, size_t n) {
+    ASSERT_ARG(columns);
+    ASSERT_ARG(spec || !n);
+    memset(columns, 0, sizeof(*columns));
+    /* at most half full, so probing stays short */
+    size_t slots = 4;
+    while(slots < 2 * n) slots *= 2;
+    array_resize(columns->slots, slots);
+    memset(array_it(columns->slots, 0), 0, slots * sizeof(*columns->slots));
+    columns->mask = slots - 1;
+    for(size_t i = 0; i < n; ++i) {
+        array_push(columns->columns, (Json_Column){ .spec = spec[i] });
+        size_t slot = json_columns_hash(spec[i].key) & columns->mask;
+        while(array_at(columns->slots, slot)) slot = (slot + 1) & columns->mask;
+        array_at(columns->slots, slot) = (uint32_t)i + 1;
+    }
+}
+
+/* the column of a raw key, or 0. records mostly list their keys in the same
+ * order, so the one after the last match gets tried before the table */
+static Json_Column *json_columns_find(Json_Columns *columns, So key, size_t *guess) {
+    if(key.len && memchr(key.str, '\\', key.len)) {
+        so_clear(&columns->scratch);
+        so_extend(&columns->scratch, key);
+        json_fix_so(columns->scratch, &key);
+    }
+    size_t n = array_len(columns->columns);
+    if(*guess < n) {
+        Json_Column *column = array_it(columns->columns, *guess);
+        if(column->spec.key.len == key.len && !memcmp(column->spec.key.str, key.str, key.len)) {
+            ++*guess;
+            return column;
+        }
+    }
+    size_t slot = json_columns_hash(key) & columns->mask;
+    for(uint32_t index; (index = array_at(columns->slots, slot)); slot = (slot + 1) & columns->mask) {
+        Json_Column *column = array_it(columns->columns, index - 1);
+        if(column->spec.key.len == key.len && !memcmp(column->spec.key.str, key.str, key.len)) {
+            *guess = index;
+            return column;
+        }
+    }
+    return 0;
+}
+
+/* a new row, null until a value shows up */
+static void json_columns_row(Json_Columns *columns) {
+    size_t row = columns->rows;
+    for(size_t i = 0; i < array_len(columns->columns); ++i) {
+        Json_Column *column = array_it(columns->columns, i);
+        switch(column->spec.id) {
+            case JSON_COLUMN_SIZE: array_push(column->sizes, 0); break;
+            case JSON_COLUMN_DOUBLE: array_push(column->doubles, 0); break;
+            case JSON_COLUMN_BOOL: array_push(column->bools, false); break;
+            case JSON_COLUMN_STRING: array_push(column->strings, SO); break;
+            default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), column->spec.id);
+        }
+        if(row % 64 == 0) array_push(column->nulls, 0);
+        array_at(column->nulls, row / 64) |= 1ull << (row % 64);
+    }
+}
+
+/* back to whole rows */
+static void json_columns_truncate(Json_Columns *columns, size_t rows) {
+    for(size_t i = 0; i < array_len(columns->columns); ++i) {
+        Json_Column *column = array_it(columns->columns, i);
+        switch(column->spec.id) {
+            case JSON_COLUMN_SIZE: array_resize(column->sizes, rows); break;
+            case JSON_COLUMN_DOUBLE: array_resize(column->doubles, rows); break;
+            case JSON_COLUMN_BOOL: array_resize(column->bools, rows); break;
+            case JSON_COLUMN_STRING: array_resize(column->strings, rows); break;
+            default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), column->spec.id);
+        }
+        array_resize(column->nulls, (rows + 63) / 64);
+    }
+    columns->rows = rows;
+}
+
+static void json_columns_set(Json_Column *column, size_t row, Json_Parse_Value *val) {
+    bool set = true;
+    switch(column->spec.id) {
+        case JSON_COLUMN_SIZE:
+        case JSON_COLUMN_DOUBLE: {
+            if(val->id != JSON_NUMBER) {
+                set = false;
+                break;
+            }
+            Json_Auto_Value number = {0};
+            json_auto_number(val->s, &number);
+            if(number.id == JSON_AUTO_VALUE_SIZE && column->spec.id == JSON_COLUMN_SIZE) array_at(column->sizes, row) = number.z;
+            else if(number.id == JSON_AUTO_VALUE_SIZE) array_at(column->doubles, row) = (double)number.z;
+            else if(number.id == JSON_AUTO_VALUE_DOUBLE && column->spec.id == JSON_COLUMN_DOUBLE) array_at(column->doubles, row) = number.f;
+            else set = false;
+        } break;
+        case JSON_COLUMN_BOOL: {
+            if(val->id == JSON_BOOL) array_at(column->bools, row) = val->b;
+            else set = false;
+        } break;
+        case JSON_COLUMN_STRING: {
+            if(val->id == JSON_STRING) array_at(column->strings, row) = val->s;
+            else set = false;
+        } break;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), column->spec.id);
+    }
+    /* a repeated key may turn the row back to null */
+    uint64_t bit = 1ull << (row % 64);
+    if(set) {
+        array_at(column->nulls, row / 64) &= ~bit;
+        return;
+    }
+    array_at(column->nulls, row / 64) |= bit;
+    switch(column->spec.id) {
+        case JSON_COLUMN_SIZE: array_at(column->sizes, row) = 0; break;
+        case JSON_COLUMN_DOUBLE: array_at(column->doubles, row) = 0; break;
+        case JSON_COLUMN_BOOL: array_at(column->bools, row) = false; break;
+        case JSON_COLUMN_STRING: array_at(column->strings, row) = SO; break;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), column->spec.id);
+    }
+}
+
+ErrDecl json_columns_parse(Json_Columns *columns, So input, Json_Parse_Settings *settings) {
+    ASSERT_ARG(columns);
+    Json_Reader reader;
+    Json_Reader_Event event;
+    Json_Column *column = 0;
+    size_t guess = 0;
+    size_t at = 0;
+    json_reader_init(&reader, input, settings);
+    for(;;) {
+        at = so_len(input) - reader.q.head.len;
+        if(json_reader_next(&reader, &event)) goto invalid;
+        if(event.id == JSON_READER_END) break;
+        if(event.depth > 2) continue;
+        switch(event.depth) {
+            case 0: {
+                if(event.id != JSON_READER_ARRAY_BEGIN && event.id != JSON_READER_ARRAY_END) goto unexpected;
+            } break;
+            case 1: {
+                if(event.id == JSON_READER_OBJECT_BEGIN) {
+                    json_columns_row(columns);
+                    guess = 0;
+                } else if(event.id == JSON_READER_OBJECT_END) {
+                    ++columns->rows;
+                } else {
+                    goto unexpected;
+                }
+            } break;
+            default: {
+                /* nested objects and arrays leave the column null */
+                if(event.id == JSON_READER_KEY) {
+                    column = json_columns_find(columns, event.val.s, &guess);
+                } else if(column) {
+                    json_columns_set(column, columns->rows, &event.val);
+                    column = 0;
+                }
+            } break;
+        }
+    }
+    return 0;
+unexpected:
+    if(reader.q.settings.error) {
+        const char *s = so_it0(input);
+        while(at < so_len(input) && strchr(" \t\v\n\r,", s[at])) ++at;
+        *reader.q.settings.error = (Json_Parse_Error){
+            .offset = at,
+            .code = JSON_ERROR_UNEXPECTED,
+            .expected = "array of objects",
+            .input = input,
+        };
+    }
+invalid:
+    json_columns_truncate(columns, columns->rows);
+    return -1;
+}
+
+bool json_columns_null(Json_Column *column, size_t row) {
+    ASSERT_ARG(column);
+    return (array_at(column->nulls, row / 64) >> (row % 64)) & 1;
+}
+
+void json_columns_clear(Json_Columns *columns) {
+    ASSERT_ARG(columns);
+    json_columns_truncate(columns, 0);
+}
+
+void json_columns_free(Json_Columns *columns) {
+    ASSERT_ARG(columns);
+    for(size_t i = 0; i < array_len(columns->columns); ++i) {
+        Json_Column *column = array_it(columns->columns, i);
+        switch(column->spec.id) {
+            case JSON_COLUMN_SIZE: array_free(column->sizes); break;
+            case JSON_COLUMN_DOUBLE: array_free(column->doubles); break;
+            case JSON_COLUMN_BOOL: array_free(column->bools); break;
+            case JSON_COLUMN_STRING: array_free(column->strings); break;
+            default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), column->spec.id);
+        }
+        array_free(column->nulls);
+    }
+    array_free(columns->columns);
+    array_free(columns->slots);
+    so_free(&columns->scratch);
+    memset(columns, 0, sizeof(*columns));
+}
+
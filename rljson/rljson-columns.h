@@ -0,0 +1,61 @@
+#ifndef RLJSON_COLUMNS_H
+
+#include "rljson-reader.h"
+
+/* columnar loading of an array of records, [{"ts":1,"v":0.5}, ...], straight
+ * into one typed array per wanted key, without building a tree.
+ *
+ *     Json_Column_Spec spec[] = { { so("ts"), JSON_COLUMN_SIZE }, { so("v"), JSON_COLUMN_DOUBLE } };
+ *     Json_Columns columns;
+ *     json_columns_init(&columns, spec, 2);
+ *     if(json_columns_parse(&columns, input, 0)) ...
+ *     double *v = columns.columns[1].doubles; // columns.rows of them
+ *
+ * every record adds one row to every column. where a record lacks the key,
+ * has null or a value of another kind, the row is zero and its null bit set.
+ * other keys are skipped, nested objects and arrays never get looked at. when
+ * a key repeats within a record, its last value counts. strings are views
+ * into the input, escapes included; keys are matched decoded. */
+
+typedef enum {
+    JSON_COLUMN_SIZE,   /* integers, like JSON_AUTO_VALUE_SIZE */
+    JSON_COLUMN_DOUBLE, /* any number */
+    JSON_COLUMN_BOOL,
+    JSON_COLUMN_STRING,
+} Json_Column_List;
+
+typedef struct Json_Column_Spec {
+    So key; /* decoded */
+    Json_Column_List id;
+} Json_Column_Spec;
+
+typedef struct Json_Column {
+    Json_Column_Spec spec;
+    union {             /* arrays of Json_Columns.rows */
+        size_t *sizes;
+        double *doubles;
+        bool *bools;
+        So *strings;
+    };
+    uint64_t *nulls;    /* one bit per row, see json_columns_null */
+} Json_Column;
+
+typedef struct Json_Columns {
+    Json_Column *columns;
+    size_t rows;
+    uint32_t *slots;    /* key lookup: open addressing, column index + 1 */
+    size_t mask;
+    So scratch;         /* keys with escapes get decoded here */
+} Json_Columns;
+
+void json_columns_init(Json_Columns *columns, Json_Column_Spec *spec, size_t n);
+/* appends the records of input to the rows already there; on failure the rows
+ * read so far stay, settings->error tells where input got rejected */
+ErrDecl json_columns_parse(Json_Columns *columns, So input, Json_Parse_Settings *settings);
+bool json_columns_null(Json_Column *column, size_t row);
+void json_columns_clear(Json_Columns *columns); /* drops the rows, keeps the columns */
+void json_columns_free(Json_Columns *columns);
+
+#define RLJSON_COLUMNS_H
+#endif // RLJSON_COLUMNS_H
+
@@ -0,0 +1,300 @@
+/* the recursive descent parser, included by rljson-core.c once per variant.
+ * no include guard on purpose.
+ *
+ * settings that decide what the loops do are turned into constants here, so
+ * a variant carries no branches on them: JSON_VARIANT_FLAGS picks strict,
+ * callbacks, and checks (.duplicates, .limits and .reject_surrogates). JSON_PARSE_VARIANT_GENERIC
+ * instead reads every setting at runtime and traces with .verbose; that one
+ * is the public json_parse_value() and friends. JSON_VARIANT(f) names the
+ * functions of the variant */
+
+#if JSON_VARIANT_FLAGS & JSON_PARSE_VARIANT_GENERIC
+#define JSON_VARIANT_STATIC
+#define JSON_VARIANT_STRICT(p)      (p)->settings.strict
+#define JSON_VARIANT_TRACE(p)       (p)->settings.verbose
+#define JSON_VARIANT_CALLBACK(cb)   (cb)
+#define JSON_VARIANT_LIMIT(p, l)    (p)->settings.limits.l
+#define JSON_VARIANT_DUPLICATES(p)  ((p)->parser ? (p)->settings.duplicates : JSON_DUPLICATES_ALLOW)
+#define JSON_VARIANT_SURROGATES(p)  (p)->settings.reject_surrogates
+#else
+#define JSON_VARIANT_STATIC         static
+#define JSON_VARIANT_STRICT(p)      ((JSON_VARIANT_FLAGS & JSON_PARSE_VARIANT_STRICT) != 0)
+#define JSON_VARIANT_TRACE(p)       false
+#define JSON_VARIANT_CALLBACK(cb)   ((JSON_VARIANT_FLAGS & JSON_PARSE_VARIANT_CALLBACK) && (cb))
+#define JSON_VARIANT_LIMIT(p, l)    ((JSON_VARIANT_FLAGS & JSON_PARSE_VARIANT_CHECKS) ? (p)->settings.limits.l : 0)
+#define JSON_VARIANT_DUPLICATES(p)  ((JSON_VARIANT_FLAGS & JSON_PARSE_VARIANT_CHECKS) && (p)->parser ? (p)->settings.duplicates : JSON_DUPLICATES_ALLOW)
+#define JSON_VARIANT_SURROGATES(p)  ((JSON_VARIANT_FLAGS & JSON_PARSE_VARIANT_CHECKS) && (p)->settings.reject_surrogates)
+#endif
+
+JSON_VARIANT_STATIC bool JSON_VARIANT(json_parse_value)(Json_Parse *p, Json_Parse_Value *v);
+
+/* return true on successful parse */
+JSON_VARIANT_STATIC bool JSON_VARIANT(json_parse_string)(Json_Parse *p, So *val) {
+    ASSERT_ARG(p);
+    ASSERT_ARG(val);
+    Json_Parse q = *p;
+    if(!json_parse_ch(&q, '"')) goto invalid;
+    int escape = 0;
+    bool unicode = false;
+    while(q.head.len) {
+        if(escape < 0) {
+            escape = 0;
+            switch(*q.head.str) {
+                case '"' : break;
+                case '\\': break;
+                case '/' : break;
+                case 'b' : break;
+                case 'f' : break;
+                case 'n' : break;
+                case 'r' : break;
+                case 't' : break;
+                case 'u' : escape += 4; unicode = true; break;
+                default  : goto invalid;
+            }
+            ++q.head.str;
+            --q.head.len;
+        } else if(escape) {
+            if(!json_parse_any(&q, "0123456789abcdefABCDEF")) goto invalid;
+            --escape;
+        } else if(json_parse_ch(&q, '\\')) {
+            escape = -1;
+        } else if(json_parse_ch(&q, '"')) {
+            *val = so_ll(p->head.str + 1, q.head.str - p->head.str - 2);
+            if(JSON_VARIANT_LIMIT(p, string) && val->len > JSON_VARIANT_LIMIT(p, string)) goto invalid;
+            if(unicode && JSON_VARIANT_SURROGATES(p) && json_fix_unpaired(*val) < val->len) goto invalid;
+            p->head = q.head;
+            if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
+                if(JSON_VARIANT_TRACE(p)) printf("%*s[string] '%.*s' : '%.*s'\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)), SO_F(*val));
+            }
+            return true;
+        } else if(*q.head.str >= ' ') {
+            ++q.head.str;
+            --q.head.len;
+        } else {
+            So_Uc_Point u8p = {0};
+            if(so_uc_point(so_ll(q.head.str, q.head.len), &u8p)) {
+                goto invalid;
+            }
+            if(u8p.val == '\t' && JSON_VARIANT_STRICT(p)) goto invalid;
+            if(u8p.val == '\n') goto invalid;
+            q.head.str += u8p.bytes;
+            q.head.len -= u8p.bytes;
+        }
+    }
+invalid:
+    if(JSON_VARIANT_TRACE(p)) {
+        printf("%*s[invalid string] %.*s\n", (int)p->depth, "", (int)(p->head.len < 32 ? p->head.len : 32), p->head.str);
+    }
+    return false;
+}
+
+JSON_VARIANT_STATIC bool JSON_VARIANT(json_parse_bool)(Json_Parse *p, bool *val) {
+    ASSERT_ARG(p);
+    ASSERT_ARG(val);
+    Json_Parse q = *p;
+    if(json_parse_ch(&q, 't')) {
+        if(!json_parse_ch(&q, 'r')) return false;
+        if(!json_parse_ch(&q, 'u')) return false;
+        if(!json_parse_ch(&q, 'e')) return false;
+        *val = true;
+        if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
+            if(JSON_VARIANT_TRACE(p)) printf("%*s[bool] '%.*s' : true\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+        }
+        p->head = q.head;
+        return true;
+    }
+    if(json_parse_ch(&q, 'f')) {
+        if(!json_parse_ch(&q, 'a')) return false;
+        if(!json_parse_ch(&q, 'l')) return false;
+        if(!json_parse_ch(&q, 's')) return false;
+        if(!json_parse_ch(&q, 'e')) return false;
+        *val = false;
+        if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
+            if(JSON_VARIANT_TRACE(p)) printf("%*s[bool] '%.*s' : false\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+        }
+        p->head = q.head;
+        return true;
+    }
+    return false;
+}
+
+JSON_VARIANT_STATIC bool JSON_VARIANT(json_parse_number)(Json_Parse *p, So *val) {
+    ASSERT_ARG(p);
+    ASSERT_ARG(val);
+    Json_Parse q = *p;
+    json_parse_ch(&q, '-');
+    if(json_parse_ch(&q, '0')) {
+    } else if(json_parse_any(&q, JSON_DIGIT1)) {
+        while(json_parse_any(&q, JSON_DIGITS)) {}
+    } else {
+        return false;
+    }
+    if(json_parse_ch(&q, '.')) {
+        if(!json_parse_any(&q, JSON_DIGITS)) return false;
+        while(json_parse_any(&q, JSON_DIGITS)) {}
+    }
+    if(json_parse_any(&q, "eE")) {
+        json_parse_any(&q, "+-");
+        if(!json_parse_any(&q, JSON_DIGITS)) return false;
+        while(json_parse_any(&q, JSON_DIGITS)) {}
+    }
+    So result = so_ll(p->head.str, q.head.str - p->head.str);
+    size_t len = so_len(result);
+    if(len) {
+        *val = result;
+        if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
+            if(JSON_VARIANT_TRACE(p)) printf("%*s[number] '%.*s' : '%.*s'\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)), SO_F(*val));
+        }
+        p->head = q.head;
+    }
+    return (bool)len;
+}
+
+JSON_VARIANT_STATIC bool JSON_VARIANT(json_parse_null)(Json_Parse *p) {
+    ASSERT_ARG(p);
+    Json_Parse q = *p;
+    if(json_parse_ch(&q, 'n')) {
+        if(!json_parse_ch(&q, 'u')) return false;
+        if(!json_parse_ch(&q, 'l')) return false;
+        if(!json_parse_ch(&q, 'l')) return false;
+        p->head = q.head;
+        if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
+            if(JSON_VARIANT_TRACE(p)) printf("%*s[null] '%.*s'\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+        }
+        return true;
+    }
+    return false;
+}
+
+JSON_VARIANT_STATIC bool JSON_VARIANT(json_parse_array)(Json_Parse *p) {
+    ASSERT_ARG(p);
+    Json_Parse_Value v = {0};
+    Json_Parse q = *p;
+    if(!json_parse_ch(&q, '[')) return false;
+    q.key.id = JSON_ARRAY;
+    q.key.duplicate = 0;
+    ++q.depth;
+    if(q.depth >= JSON_DEPTH_MAX) return false;
+    if(p->depth) {
+        if(JSON_VARIANT_TRACE(p)) printf("%*s[array enter -> '%.*s']\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+        Json_Parse_Value key = p->key;
+        key.child = JSON_ARRAY;
+        if(JSON_VARIANT_CALLBACK(p->callback)) q.callback = p->callback(&q.user, key, 0);
+    }
+    json_parse_ws(&q);
+    size_t width = 0;
+    bool first = true;
+    do {
+        if(!JSON_VARIANT(json_parse_value)(&q, &v)) {
+            if(first) break;
+            else return false;
+        }
+        if(JSON_VARIANT_LIMIT(p, width) && ++width > JSON_VARIANT_LIMIT(p, width)) return false;
+        if(JSON_VARIANT_CALLBACK(q.callback) && v.id != JSON_OBJECT && v.id != JSON_ARRAY) {
+            if(JSON_VARIANT_TRACE(p)) printf("%*s[array] '%.*s' <- '%.*s'\n", (int)q.depth, "", SO_F(json_parse_value_str(v)), SO_F(json_parse_value_str(p->key)));
+            void *user = q.user; //p->user;
+            q.callback(&user, q.key, &v);
+        }
+        if(!json_parse_ch(&q, ',')) break;
+        first = false;
+    } while(q.head.len);
+    if(!json_parse_ch(&q, ']')) return false;
+    p->head = q.head;
+    if(p->depth) {
+        if(JSON_VARIANT_TRACE(p)) printf("%*s[array exit <- '%.*s']\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+    }
+    return true;
+}
+
+JSON_VARIANT_STATIC bool JSON_VARIANT(json_parse_object)(Json_Parse *p) {
+    ASSERT_ARG(p);
+    Json_Parse q = *p;
+    if(!json_parse_ch(&q, '{')) return false;
+    q.key.id = JSON_OBJECT;
+    ++q.depth;
+    if(q.depth >= JSON_DEPTH_MAX) return false;
+    if(p->depth) {
+        if(JSON_VARIANT_TRACE(p)) printf("%*s[object enter -> '%.*s']\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+        Json_Parse_Value key = p->key;
+        key.child = JSON_OBJECT;
+        if(JSON_VARIANT_CALLBACK(p->callback)) q.callback = p->callback(&q.user, key, 0);
+    }
+    Json_Duplicates_List duplicates = JSON_VARIANT_DUPLICATES(p);
+    Json_Parse_Keys *keys = duplicates ? &p->parser->keys : 0;
+    if(keys) json_parse_keys_enter(keys);
+    Json_Parse_Callback callback = q.callback;
+    json_parse_ws(&q);
+    Json_Parse_Value k = { .id = JSON_OBJECT };
+    Json_Parse_Value v = {0};
+    size_t width = 0;
+    bool first = true;
+    do {
+        json_parse_ws(&q);
+        if(!JSON_VARIANT(json_parse_string)(&q, &k.s)) {
+            if(first) break;
+            else goto invalid;
+        }
+        if(JSON_VARIANT_LIMIT(p, width) && ++width > JSON_VARIANT_LIMIT(p, width)) goto invalid;
+        json_parse_ws(&q);
+        if(!json_parse_ch(&q, ':')) goto invalid;
+        size_t earlier = 0;
+        bool repeated = keys && !json_parse_keys_add(keys, k.s, &earlier);
+        if(repeated && duplicates == JSON_DUPLICATES_REJECT) goto invalid;
+        k.duplicate = repeated && duplicates == JSON_DUPLICATES_LAST ? earlier + 1 : 0;
+        q.callback = repeated && duplicates == JSON_DUPLICATES_FIRST ? 0 : callback;
+        q.key = k;
+        if(!JSON_VARIANT(json_parse_value)(&q, &v)) goto invalid;
+        /* key-value pair found */
+        if(v.id != JSON_OBJECT && v.id != JSON_ARRAY) {
+            if(JSON_VARIANT_TRACE(p)) printf("%*s[object] '%.*s' : '%.*s' %u <- '%.*s'\n", (int)q.depth, "", SO_F(json_parse_value_str(k)), SO_F(json_parse_value_str(v)), v.id, SO_F(json_parse_value_str(p->key)));
+            //q.user = p->user;
+            void *user = q.user;
+            if(JSON_VARIANT_CALLBACK(q.callback)) q.callback(&user, q.key, &v);
+        }
+        /* next */
+        if(!json_parse_ch(&q, ',')) break;
+        first = false;
+    } while(q.head.len);
+    if(!json_parse_ch(&q, '}')) goto invalid;
+    if(keys) json_parse_keys_leave(keys);
+    p->head = q.head;
+    if(p->depth) {
+        if(JSON_VARIANT_TRACE(p)) printf("%*s[object exit <- '%.*s']\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+    }
+    return true;
+invalid:
+    if(keys) json_parse_keys_leave(keys);
+    return false;
+}
+
+JSON_VARIANT_STATIC bool JSON_VARIANT(json_parse_value)(Json_Parse *p, Json_Parse_Value *v) {
+    Json_Parse q = *p;
+    json_parse_ws(&q);
+    char *begin = q.head.str;
+    if(JSON_VARIANT(json_parse_object)(&q)) { v->id = JSON_OBJECT; goto container; }
+    if(JSON_VARIANT(json_parse_array)(&q)) { v->id = JSON_ARRAY; goto container; }
+    /* atomic */
+    if(JSON_VARIANT(json_parse_string)(&q, &v->s))  { v->id = JSON_STRING; goto valid; }
+    if(JSON_VARIANT(json_parse_number)(&q, &v->s)) { v->id = JSON_NUMBER; goto valid; }
+    if(JSON_VARIANT(json_parse_bool)(&q, &v->b)) { v->id = JSON_BOOL; goto valid; }
+    if(JSON_VARIANT(json_parse_null)(&q)) { v->id = JSON_NULL; goto valid; }
+    return false;
+container:
+    v->s = so_ll(begin, q.head.str - begin);
+valid:
+    /* counted once done, the parser is what every level shares */
+    if(JSON_VARIANT_LIMIT(p, nodes) && p->parser && ++p->parser->nodes > JSON_VARIANT_LIMIT(p, nodes)) return false;
+    json_parse_ws(&q);
+    p->head = q.head;
+    return true;
+}
+
+#undef JSON_VARIANT_STATIC
+#undef JSON_VARIANT_STRICT
+#undef JSON_VARIANT_TRACE
+#undef JSON_VARIANT_CALLBACK
+#undef JSON_VARIANT_LIMIT
+#undef JSON_VARIANT_DUPLICATES
+#undef JSON_VARIANT_SURROGATES
+#undef JSON_VARIANT_FLAGS
+#undef JSON_VARIANT
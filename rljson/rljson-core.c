@@ -1,8 +1,10 @@
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <rlso.h>
 #include <rlc/err.h>
 #include "rljson-core.h"
+#include "rljson-valid.h"
 
 bool json_parse_value(Json_Parse *p, Json_Parse_Value *v);
 
@@ -47,267 +49,270 @@ void json_parse_ws(Json_Parse *p) {
     while(json_parse_any(p, " \t\v\n\r")) {}
 }
 
-/* return true on successful parse */
-bool json_parse_string(Json_Parse *p, So *val) {
-    ASSERT_ARG(p);
-    ASSERT_ARG(val);
-    Json_Parse q = *p;
-    if(!json_parse_ch(&q, '"')) goto invalid;
-    int escape = 0;
-    while(q.head.len) {
-        if(escape < 0) {
-            escape = 0;
-            switch(*q.head.str) {
-                case '"' : break;
-                case '\\': break;
-                case '/' : break;
-                case 'b' : break;
-                case 'f' : break;
-                case 'n' : break;
-                case 'r' : break;
-                case 't' : break;
-                case 'u' : escape += 4; break;
-                default  : goto invalid;
-            }
-            ++q.head.str;
-            --q.head.len;
-        } else if(escape) {
-            if(!json_parse_any(&q, "0123456789abcdefABCDEF")) goto invalid;
-            --escape;
-        } else if(json_parse_ch(&q, '\\')) {
-            escape = -1;
-        } else if(json_parse_ch(&q, '"')) {
-            *val = so_ll(p->head.str + 1, q.head.str - p->head.str - 2);
-            p->head = q.head;
-            if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
-                if(p->settings.verbose) printf("%*s[string] '%.*s' : '%.*s'\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)), SO_F(*val));
-            }
-            return true;
-        } else if(*q.head.str >= ' ') {
-            ++q.head.str;
-            --q.head.len;
-        } else {
-            So_Uc_Point u8p = {0};
-            if(so_uc_point(so_ll(q.head.str, q.head.len), &u8p)) {
-                goto invalid;
-            }
-            if(u8p.val == '\t' && q.settings.strict) goto invalid;
-            if(u8p.val == '\n') goto invalid;
-            q.head.str += u8p.bytes;
-            q.head.len -= u8p.bytes;
-        }
-    }
-invalid:
-    if(p->settings.verbose) {
-        printf("%*s[invalid string] %.*s", (int)p->depth, "", (int)p->head.len, p->head.str);
+void json_parse_keys_enter(Json_Parse_Keys *keys) {
+    Json_Parse_Keys_Level level = {
+        .keys = array_len(keys->keys),
+        .slots = array_len(keys->slots),
+        .text = so_len(keys->text),
+    };
+    array_push(keys->levels, level);
+    array_resize(keys->slots, level.slots + 8);
+    memset(array_it(keys->slots, level.slots), 0, 8 * sizeof(*keys->slots));
+}
+
+static inline const char *json_parse_keys_str(Json_Parse_Keys *keys, Json_Parse_Key *key) {
+    return key->str ? key->str : so_it(keys->text, key->at);
+}
+
+/* the innermost object is always on top of every stack when keys get added */
+static void json_parse_keys_grow(Json_Parse_Keys *keys, Json_Parse_Keys_Level *level) {
+    size_t cap = 2 * (array_len(keys->slots) - level->slots);
+    array_resize(keys->slots, level->slots + cap);
+    uint32_t *slots = array_it(keys->slots, level->slots);
+    memset(slots, 0, cap * sizeof(*slots));
+    for(size_t i = level->keys; i < array_len(keys->keys); ++i) {
+        size_t slot = array_at(keys->keys, i).hash & (cap - 1);
+        while(slots[slot]) slot = (slot + 1) & (cap - 1);
+        slots[slot] = (uint32_t)(i - level->keys + 1);
     }
-    return false;
 }
 
-bool json_parse_bool(Json_Parse *p, bool *val) {
-    ASSERT_ARG(p);
-    ASSERT_ARG(val);
-    Json_Parse q = *p;
-    if(json_parse_ch(&q, 't')) {
-        if(!json_parse_ch(&q, 'r')) return false;
-        if(!json_parse_ch(&q, 'u')) return false;
-        if(!json_parse_ch(&q, 'e')) return false;
-        *val = true;
-        if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
-            if(p->settings.verbose) printf("%*s[bool] '%.*s' : true\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
-        }
-        p->head = q.head;
-        return true;
+bool json_parse_keys_add(Json_Parse_Keys *keys, So key, size_t *index) {
+    ASSERT_ARG(keys);
+    Json_Parse_Keys_Level *level = array_itL(keys->levels);
+    Json_Parse_Key entry = { .str = key.str, .len = key.len };
+    if(key.len && memchr(key.str, '\\', key.len)) {
+        entry.str = 0;
+        entry.at = so_len(keys->text);
+        so_extend(&keys->text, key);
+        So decoded = so_ll(so_it(keys->text, entry.at), key.len);
+        json_fix_so(decoded, &decoded);
+        entry.len = decoded.len;
+        so_resize(&keys->text, entry.at + entry.len);
     }
-    if(json_parse_ch(&q, 'f')) {
-        if(!json_parse_ch(&q, 'a')) return false;
-        if(!json_parse_ch(&q, 'l')) return false;
-        if(!json_parse_ch(&q, 's')) return false;
-        if(!json_parse_ch(&q, 'e')) return false;
-        *val = false;
-        if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
-            if(p->settings.verbose) printf("%*s[bool] '%.*s' : false\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
-        }
-        p->head = q.head;
-        return true;
+    const char *str = json_parse_keys_str(keys, &entry);
+    entry.hash = 0xcbf29ce484222325ULL;
+    for(size_t i = 0; i < entry.len; ++i) entry.hash = (entry.hash ^ (unsigned char)str[i]) * 0x100000001b3ULL;
+    entry.hash ^= entry.hash >> 32;
+    size_t count = array_len(keys->keys) - level->keys;
+    if(2 * (count + 1) > array_len(keys->slots) - level->slots) json_parse_keys_grow(keys, level);
+    size_t mask = array_len(keys->slots) - level->slots - 1;
+    uint32_t *slots = array_it(keys->slots, level->slots);
+    size_t slot = entry.hash & mask;
+    for(uint32_t i; (i = slots[slot]); slot = (slot + 1) & mask) {
+        Json_Parse_Key *other = array_it(keys->keys, level->keys + i - 1);
+        if(other->hash != entry.hash || other->len != entry.len) continue;
+        if(memcmp(json_parse_keys_str(keys, other), str, entry.len)) continue;
+        if(!entry.str) so_resize(&keys->text, entry.at);
+        if(index) *index = i - 1;
+        return false;
     }
-    return false;
+    slots[slot] = (uint32_t)(count + 1);
+    array_push(keys->keys, entry);
+    return true;
 }
 
+void json_parse_keys_leave(Json_Parse_Keys *keys) {
+    ASSERT_ARG(keys);
+    Json_Parse_Keys_Level level = *array_itL(keys->levels);
+    array_pop(keys->levels);
+    array_resize(keys->keys, level.keys);
+    array_resize(keys->slots, level.slots);
+    so_resize(&keys->text, level.text);
+}
 
+void json_parse_keys_clear(Json_Parse_Keys *keys) {
+    ASSERT_ARG(keys);
+    array_resize(keys->keys, 0);
+    array_resize(keys->slots, 0);
+    array_resize(keys->levels, 0);
+    so_clear(&keys->text);
+}
+
+void json_parse_keys_free(Json_Parse_Keys *keys) {
+    if(!keys) return;
+    array_free(keys->keys);
+    array_free(keys->slots);
+    array_free(keys->levels);
+    so_free(&keys->text);
+    memset(keys, 0, sizeof(*keys));
+}
+
+/* what a variant of the parser has fixed, see rljson-core-variant.h */
+#define JSON_PARSE_VARIANT_STRICT   1
+#define JSON_PARSE_VARIANT_CALLBACK 2
+#define JSON_PARSE_VARIANT_CHECKS   4
+#define JSON_PARSE_VARIANT_GENERIC  8
+
+/* shared by all of them */
 #define JSON_DIGITS  "0123456789"
 #define JSON_DIGIT1  "123456789"
 
-bool json_parse_number(Json_Parse *p, So *val) {
-    ASSERT_ARG(p);
-    ASSERT_ARG(val);
-    Json_Parse q = *p;
-    json_parse_ch(&q, '-');
-    if(json_parse_ch(&q, '0')) {
-    } else if(json_parse_any(&q, JSON_DIGIT1)) {
-        while(json_parse_any(&q, JSON_DIGITS)) {}
-    } else {
-        return false;
-    }
-    if(json_parse_ch(&q, '.')) {
-        if(!json_parse_any(&q, JSON_DIGITS)) return false;
-        while(json_parse_any(&q, JSON_DIGITS)) {}
-    }
-    if(json_parse_any(&q, "eE")) {
-        json_parse_any(&q, "+-");
-        if(!json_parse_any(&q, JSON_DIGITS)) return false;
-        while(json_parse_any(&q, JSON_DIGITS)) {}
-    }
-    So result = so_ll(p->head.str, q.head.str - p->head.str);
-    size_t len = so_len(result);
-    if(len) {
-        *val = result;
-        if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
-            if(p->settings.verbose) printf("%*s[number] '%.*s' : '%.*s'\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)), SO_F(*val));
-        }
-        p->head = q.head;
-    }
-    return (bool)len;
-}
+#define JSON_VARIANT(f)     f
+#define JSON_VARIANT_FLAGS  JSON_PARSE_VARIANT_GENERIC
+#include "rljson-core-variant.h"
+#define JSON_VARIANT(f)     f##_0
+#define JSON_VARIANT_FLAGS  0
+#include "rljson-core-variant.h"
+#define JSON_VARIANT(f)     f##_1
+#define JSON_VARIANT_FLAGS  1
+#include "rljson-core-variant.h"
+#define JSON_VARIANT(f)     f##_2
+#define JSON_VARIANT_FLAGS  2
+#include "rljson-core-variant.h"
+#define JSON_VARIANT(f)     f##_3
+#define JSON_VARIANT_FLAGS  3
+#include "rljson-core-variant.h"
+#define JSON_VARIANT(f)     f##_4
+#define JSON_VARIANT_FLAGS  4
+#include "rljson-core-variant.h"
+#define JSON_VARIANT(f)     f##_5
+#define JSON_VARIANT_FLAGS  5
+#include "rljson-core-variant.h"
+#define JSON_VARIANT(f)     f##_6
+#define JSON_VARIANT_FLAGS  6
+#include "rljson-core-variant.h"
+#define JSON_VARIANT(f)     f##_7
+#define JSON_VARIANT_FLAGS  7
+#include "rljson-core-variant.h"
 
-bool json_parse_null(Json_Parse *p) {
+/* indexed by JSON_PARSE_VARIANT_* */
+static bool (*const json_parse_variants[])(Json_Parse *p, Json_Parse_Value *v) = {
+    json_parse_value_0, json_parse_value_1, json_parse_value_2, json_parse_value_3,
+    json_parse_value_4, json_parse_value_5, json_parse_value_6, json_parse_value_7,
+};
+
+/* skip over an object or array that was already validated, matching brackets
+ * only; return true and its raw text on success */
+bool json_parse_skip(Json_Parse *p, So *span, size_t *nesting) {
     ASSERT_ARG(p);
-    Json_Parse q = *p;
-    if(json_parse_ch(&q, 'n')) {
-        if(!json_parse_ch(&q, 'u')) return false;
-        if(!json_parse_ch(&q, 'l')) return false;
-        if(!json_parse_ch(&q, 'l')) return false;
-        p->head = q.head;
-        if(p->key.id != JSON_ARRAY && p->key.id != JSON_OBJECT) {
-            if(p->settings.verbose) printf("%*s[null] '%.*s'\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+    ASSERT_ARG(span);
+    size_t depth = 0;
+    size_t deepest = 0;
+    bool string = false;
+    for(size_t i = 0; i < p->head.len; ++i) {
+        char c = p->head.str[i];
+        if(string) {
+            if(c == '\\') ++i;
+            else if(c == '"') string = false;
+            continue;
+        }
+        switch(c) {
+            case '"': string = true; break;
+            case '{': case '[': {
+                if(++depth > deepest) deepest = depth;
+            } break;
+            case '}': case ']': {
+                if(!depth) return false;
+                if(--depth) break;
+                if(nesting) *nesting = deepest;
+                *span = so_ll(p->head.str, i + 1);
+                so_shift(&p->head, i + 1);
+                return true;
+            }
+            default: if(!depth) return false; break;
         }
-        return true;
     }
     return false;
 }
 
-bool json_parse_array(Json_Parse *p) {
-    ASSERT_ARG(p);
-    Json_Parse_Value v = {0};
-    Json_Parse q = *p;
-    if(!json_parse_ch(&q, '[')) return false;
-    q.key.id = JSON_ARRAY;
-    ++q.depth;
-    if(q.depth >= JSON_DEPTH_MAX) return false;
-    if(p->depth) {
-        if(p->settings.verbose) printf("%*s[array enter -> '%.*s']\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
-        if(p->callback) q.callback = p->callback(&q.user, p->key, 0);
-    }
-    json_parse_ws(&q);
-    bool first = true;
-    do {
-        if(!json_parse_value(&q, &v)) {
-            if(first) break;
-            else return false;
-        }
-        if(q.callback && v.id != JSON_OBJECT && v.id != JSON_ARRAY) {
-            if(p->settings.verbose) printf("%*s[array] '%.*s' <- '%.*s'\n", (int)q.depth, "", SO_F(json_parse_value_str(v)), SO_F(json_parse_value_str(p->key)));
-            void *user = q.user; //p->user;
-            q.callback(&user, q.key, &v);
-        }
-        if(!json_parse_ch(&q, ',')) break;
-        first = false;
-    } while(q.head.len);
-    if(!json_parse_ch(&q, ']')) return false;
-    p->head = q.head;
-    if(p->depth) {
-        if(p->settings.verbose) printf("%*s[array exit <- '%.*s']\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
-    }
-    return true;
+ErrDecl json_parse_valid_ext(So input, Json_Parse_Settings *settings) {
+    ASSERT_ARG(settings);
+    /* only the full parser can trace what it does */
+    if(settings->verbose) return json_parse_ext(input, 0, 0, settings);
+    return json_valid(input, settings);
 }
 
-bool json_parse_object(Json_Parse *p) {
-    ASSERT_ARG(p);
-    Json_Parse q = *p;
-    if(!json_parse_ch(&q, '{')) return false;
-    q.key.id = JSON_OBJECT;
-    ++q.depth;
-    if(q.depth >= JSON_DEPTH_MAX) return false;
-    if(p->depth) {
-        if(p->settings.verbose) printf("%*s[object enter -> '%.*s']\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
-        if(p->callback) q.callback = p->callback(&q.user, p->key, 0);
-    }
-    json_parse_ws(&q);
-    Json_Parse_Value k = { .id = JSON_OBJECT };
-    Json_Parse_Value v = {0};
-    bool first = true;
-    do {
-        json_parse_ws(&q);
-        if(!json_parse_string(&q, &k.s)) {
-            if(first) break;
-            else return false;
-        }
-        json_parse_ws(&q);
-        if(!json_parse_ch(&q, ':')) return false;
-        q.key = k;
-        if(!json_parse_value(&q, &v)) return false;
-        /* key-value pair found */
-        if(v.id != JSON_OBJECT && v.id != JSON_ARRAY) {
-            if(p->settings.verbose) printf("%*s[object] '%.*s' : '%.*s' %u <- '%.*s'\n", (int)q.depth, "", SO_F(json_parse_value_str(k)), SO_F(json_parse_value_str(v)), v.id, SO_F(json_parse_value_str(p->key)));
-            //q.user = p->user;
-            void *user = q.user;
-            if(q.callback) q.callback(&user, q.key, &v);
+ErrDecl json_parse_valid(So input) {
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    return json_parse_valid_ext(input, &settings);
+}
+
+void json_parser_init(Json_Parser *parser, Json_Parse_Settings *settings) {
+    ASSERT_ARG(parser);
+    memset(parser, 0, sizeof(*parser));
+    parser->settings = settings ? *settings : JSON_PARSE_SETTINGS_DEFAULT;
+}
+
+void json_parser_reset(Json_Parser *parser) {
+    ASSERT_ARG(parser);
+    so_clear(&parser->scratch);
+    json_parse_keys_clear(&parser->keys);
+    /* the chunks of made up text become one, as big as all of them together:
+     * the next document that needs as much fits without allocating */
+    if(array_len(parser->texts) > 1) {
+        size_t total = 0;
+        for(size_t i = 0; i < array_len(parser->texts); ++i) {
+            total += so_len(array_at(parser->texts, i));
+            if(i) so_free(array_it(parser->texts, i));
         }
-        /* next */
-        if(!json_parse_ch(&q, ',')) break;
-        first = false;
-    } while(q.head.len);
-    if(!json_parse_ch(&q, '}')) return false;
-    p->head = q.head;
-    if(p->depth) {
-        if(p->settings.verbose) printf("%*s[object exit <- '%.*s']\n", (int)p->depth, "", SO_F(json_parse_value_str(p->key)));
+        array_resize(parser->texts, 1);
+        so_resize(array_it(parser->texts, 0), total);
     }
-    return true;
+    parser->texts_used = 0;
 }
 
-bool json_parse_value(Json_Parse *p, Json_Parse_Value *v) {
-    Json_Parse q = *p;
-    json_parse_ws(&q);
-    if(json_parse_object(&q)) { v->id = JSON_OBJECT; goto valid; }
-    if(json_parse_array(&q)) { v->id = JSON_ARRAY; goto valid; }
-    /* atomic */
-    if(json_parse_string(&q, &v->s))  { v->id = JSON_STRING; goto valid; }
-    if(json_parse_number(&q, &v->s)) { v->id = JSON_NUMBER; goto valid; }
-    if(json_parse_bool(&q, &v->b)) { v->id = JSON_BOOL; goto valid; }
-    if(json_parse_null(&q)) { v->id = JSON_NULL; goto valid; }
-    return false;
-valid:
-    json_parse_ws(&q);
-    p->head = q.head;
-    return true;
+void json_parser_free(Json_Parser *parser) {
+    if(!parser) return;
+    so_free(&parser->scratch);
+    array_free_ext(parser->texts, so_free);
+    json_parse_keys_free(&parser->keys);
+    array_free(parser->widths);
+    memset(parser, 0, sizeof(*parser));
 }
 
-ErrDecl json_parse_valid_ext(So input, Json_Parse_Settings *settings) {
-    return json_parse_ext(input, 0, 0, settings);
+ErrDecl json_parser_valid(Json_Parser *parser, So input) {
+    ASSERT_ARG(parser);
+    if(parser->settings.verbose) return json_parser_parse(parser, input, 0, 0);
+    return json_valid_ext(input, &parser->settings, &parser->keys, &parser->widths);
 }
 
-ErrDecl json_parse_valid(So input) {
-    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
-    return json_parse_valid_ext(input, &settings);
+/* the parser only knows that it failed, so find out where and why now, on
+ * the failing path; the validator decides the same way */
+static void json_parser_error(Json_Parser *parser, So input) {
+    Json_Parse_Error *error = parser->settings.error;
+    if(!error || error->code) return;
+    if(!json_valid_ext(input, &parser->settings, &parser->keys, &parser->widths)) {
+        *error = (Json_Parse_Error){ .code = JSON_ERROR_INVALID, .input = input };
+    }
 }
 
-ErrDecl json_parse_ext(So input, Json_Parse_Callback callback, void *user, Json_Parse_Settings *settings) {
-    ASSERT_ARG(settings);
+ErrDecl json_parser_parse(Json_Parser *parser, So input, Json_Parse_Callback callback, void *user) {
+    ASSERT_ARG(parser);
+    int result = 0;
+    if(parser->settings.error) *parser->settings.error = (Json_Parse_Error){0};
+    parser->nodes = 0;
     Json_Parse_Value v = {0};
     Json_Parse parse = {
         .head = input,
         .user = user,
         .callback = callback,
-        .settings = *settings,
+        .settings = parser->settings,
+        .parser = parser,
     };
+    if(parse.settings.limits.bytes && input.len > parse.settings.limits.bytes) {
+        result = -1;
+        goto invalid;
+    }
+    /* the settings hold for the whole document, so pick the variant once */
+    Json_Parse_Settings *settings = &parse.settings;
+    bool (*parse_value)(Json_Parse *p, Json_Parse_Value *v) = json_parse_value;
+    if(!settings->verbose) {
+        bool checks = settings->duplicates || settings->limits.nodes || settings->limits.width || settings->limits.string
+            || settings->reject_surrogates;
+        parse_value = json_parse_variants[(settings->strict ? JSON_PARSE_VARIANT_STRICT : 0)
+            | (callback ? JSON_PARSE_VARIANT_CALLBACK : 0) | (checks ? JSON_PARSE_VARIANT_CHECKS : 0)];
+    }
     json_parse_ws(&parse);
-    if(!json_parse_value(&parse, &v)) {
+    if(!parse_value(&parse, &v)) {
         /* invalid json */
-        return -1;
+        result = -1;
+        goto invalid;
     }
     if(parse.settings.strict) {
         if(v.id != JSON_OBJECT && v.id != JSON_ARRAY) {
-            return -1;
+            result = -1;
+            goto invalid;
         }
     } else {
         switch(v.id) {
@@ -317,13 +322,77 @@ ErrDecl json_parse_ext(So input, Json_Parse_Callback callback, void *user, Json_
             case JSON_NULL:
             case JSON_NUMBER:
             case JSON_STRING: {
-                callback(&user, v, 0);
+                if(callback) callback(&user, v, 0);
             } break;
             default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), v.id);
         }
     }
     json_parse_ws(&parse);
-    return parse.head.len;
+    result = parse.head.len;
+invalid:
+    if(result) json_parser_error(parser, input);
+    return result;
+}
+
+const char *json_parse_error_str(Json_Error_List code) {
+    switch(code) {
+        case JSON_ERROR_NONE: return "no error";
+        case JSON_ERROR_INVALID: return "invalid json";
+        case JSON_ERROR_END: return "unexpected end of input";
+        case JSON_ERROR_UNEXPECTED: return "unexpected character";
+        case JSON_ERROR_TRAILING: return "trailing data";
+        case JSON_ERROR_ROOT: return "top level value is not an object or array";
+        case JSON_ERROR_DEPTH: return "nested too deep";
+        case JSON_ERROR_UNTERMINATED_STRING: return "unterminated string";
+        case JSON_ERROR_ESCAPE: return "invalid escape";
+        case JSON_ERROR_UNICODE_ESCAPE: return "invalid \\u escape";
+        case JSON_ERROR_CONTROL_CHARACTER: return "control character in string";
+        case JSON_ERROR_UTF8: return "invalid utf-8";
+        case JSON_ERROR_NUMBER: return "invalid number";
+        case JSON_ERROR_LITERAL: return "invalid literal";
+        case JSON_ERROR_DUPLICATE_KEY: return "duplicate key";
+        case JSON_ERROR_LIMIT_BYTES: return "input too long";
+        case JSON_ERROR_LIMIT_NODES: return "too many values";
+        case JSON_ERROR_LIMIT_WIDTH: return "too many members or elements";
+        case JSON_ERROR_LIMIT_STRING: return "string too long";
+        case JSON_ERROR_LIMIT_MEMORY: return "tree too large";
+        case JSON_ERROR_SURROGATE: return "unpaired surrogate escape";
+    }
+    return "(unknown error)";
+}
+
+void json_parse_error_position(Json_Parse_Error *error, size_t *line, size_t *column) {
+    ASSERT_ARG(error);
+    const char *s = so_it0(error->input);
+    size_t end = error->offset < so_len(error->input) ? error->offset : so_len(error->input);
+    size_t lines = 1;
+    size_t begin = 0;
+    const char *nl = 0;
+    while(begin < end && (nl = memchr(s + begin, '\n', end - begin))) {
+        ++lines;
+        begin = (size_t)(nl - s) + 1;
+    }
+    if(line) *line = lines;
+    if(column) *column = end - begin + 1;
+}
+
+So json_parser_unescape(Json_Parser *parser, So json_str) {
+    ASSERT_ARG(parser);
+    so_clear(&parser->scratch);
+    if(!json_str.len) return json_str;
+    so_extend(&parser->scratch, json_str);
+    So result = so_ll(so_it(parser->scratch, 0), so_len(parser->scratch));
+    json_fix_so(result, &result);
+    return result;
+}
+
+ErrDecl json_parse_ext(So input, Json_Parse_Callback callback, void *user, Json_Parse_Settings *settings) {
+    ASSERT_ARG(settings);
+    Json_Parser parser;
+    json_parser_init(&parser, settings);
+    int result = json_parser_parse(&parser, input, callback, user);
+    json_parser_free(&parser);
+    return result;
 }
 
 ErrDecl json_parse(So input, Json_Parse_Callback callback, void *user) {
@@ -331,98 +400,166 @@ ErrDecl json_parse(So input, Json_Parse_Callback callback, void *user) {
     return json_parse_ext(input, callback, user, &settings);
 }
 
-void json_fix_so(So json_str, So *out) {
-    So ref = json_str;
-    int escape = 0;
-    size_t begin = 0;
-    size_t j = 0;
-    uint16_t w1 = 0;
-    uint16_t w2 = 0;
-    for(size_t i = 0; i < ref.len; ++i) {
-        char c = ref.str[i];
-        if(!escape && c == '\\') {
-            escape = -1;
-        } else if(escape < 0) {
-            escape = 0;
-            switch(c) {
-                case 'b':  *so_it(json_str, j++) = '\b'; break;
-                case '"':  *so_it(json_str, j++) = '\"'; break;
-                case '\'': *so_it(json_str, j++) = '\''; break;
-                case '/':  *so_it(json_str, j++) = '/';  break;
-                case 'f':  *so_it(json_str, j++) = '\f'; break;
-                case 'n':  *so_it(json_str, j++) = '\n'; break;
-                case 'r':  *so_it(json_str, j++) = '\r'; break;
-                case 't':  *so_it(json_str, j++) = '\t'; break;
-                case 'u': escape = 4; break;
-                default: break; /* TODO what do ? should never reach this */
-            }
-        } else if(escape > 0) {
-            --escape;
-            if(escape == 3) begin = i;
-            if(escape == 0) {
-                if(!(4 == i - begin + 1)) { // expect to have 4 characters...
-                    // TODO: err handling!
-                    // invalid...
-                    *so_it(json_str, j++) = c;
+/* encode a code point as utf8 without going through a temporary string */
+static size_t json_utf8_encode(uint32_t u32, char *buf) {
+    if(u32 < 0x80) {
+        buf[0] = (char)u32;
+        return 1;
+    }
+    if(u32 < 0x800) {
+        buf[0] = (char)(0xC0 | (u32 >> 6));
+        buf[1] = (char)(0x80 | (u32 & 0x3F));
+        return 2;
+    }
+    if(u32 < 0x10000) {
+        buf[0] = (char)(0xE0 | (u32 >> 12));
+        buf[1] = (char)(0x80 | ((u32 >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (u32 & 0x3F));
+        return 3;
+    }
+    if(u32 < 0x110000) {
+        buf[0] = (char)(0xF0 | (u32 >> 18));
+        buf[1] = (char)(0x80 | ((u32 >> 12) & 0x3F));
+        buf[2] = (char)(0x80 | ((u32 >> 6) & 0x3F));
+        buf[3] = (char)(0x80 | (u32 & 0x3F));
+        return 4;
+    }
+    return 0;
+}
+
+/* hex digit + 1, 0 for anything else */
+static const unsigned char json_hex[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+    ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+#define JSON_REPLACEMENT    0xFFFD
+
+/* the code unit of "\uXXXX" at s, or -1 */
+static inline int32_t json_fix_u16(const char *s, size_t len) {
+    if(len < 6 || s[0] != '\\' || s[1] != 'u') return -1;
+    unsigned h0 = json_hex[(unsigned char)s[2]];
+    unsigned h1 = json_hex[(unsigned char)s[3]];
+    unsigned h2 = json_hex[(unsigned char)s[4]];
+    unsigned h3 = json_hex[(unsigned char)s[5]];
+    if(!h0 || !h1 || !h2 || !h3) return -1;
+    return (int32_t)(((h0 - 1) << 12) | ((h1 - 1) << 8) | ((h2 - 1) << 4) | (h3 - 1));
+}
+
+/* decode the escape at s[*i] (the backslash) into out, advancing *i past it;
+ * returns how many bytes were written. reads everything it needs before
+ * writing, so out may trail s */
+static inline size_t json_fix_escape(char *out, const char *s, size_t len, size_t *i, int *malformed) {
+    if(*i + 1 >= len) {
+        ++*malformed; /* lone backslash at the end */
+        *i = len;
+        return 0;
+    }
+    char c = s[*i + 1];
+    *i += 2;
+    switch(c) {
+        case 'b':  *out = '\b'; return 1;
+        case '"':  *out = '\"'; return 1;
+        case '\\': *out = '\\'; return 1;
+        case '\'': *out = '\''; return 1;
+        case '/':  *out = '/';  return 1;
+        case 'f':  *out = '\f'; return 1;
+        case 'n':  *out = '\n'; return 1;
+        case 'r':  *out = '\r'; return 1;
+        case 't':  *out = '\t'; return 1;
+        case 'u': {
+            int32_t w1 = json_fix_u16(s + *i - 2, len - *i + 2);
+            uint32_t u32 = JSON_REPLACEMENT;
+            if(w1 < 0) {
+                /* not four hex digits: drop the "\\u", whatever follows stays text */
+                ++*malformed;
+                return 0;
+            } else if((w1 >> 10) == 0x36) {
+                /* high surrogate, only valid with a low one right after */
+                int32_t w2 = json_fix_u16(s + *i + 4, len - *i - 4);
+                if(w2 >= 0 && (w2 >> 10) == 0x37) {
+                    u32 = ((((uint32_t)w1 & 0x3FF) << 10) | ((uint32_t)w2 & 0x3FF)) + 0x10000;
+                    *i += 10;
                 } else {
-                    So num = so_ll(so_it(json_str, begin), 4);
-                    size_t z = 0;
-                    uint32_t u32 = 0;
-                    bool go = false;
-                    if(!so_as_size(num, &z, 16)) {
-                        if(!w1) {
-                            if((z >> 10) == 0x36) { // high utf16 surrogate
-                                w1 = z;
-                                if(!(begin + 4 < json_str.len && so_at(json_str, begin + 4) == '\\' && so_at(json_str, begin + 5) == 'u')) {
-                                    // invalid...
-                                    u32 = z;
-                                    go = true;
-                                }
-                            }
-                            else
-                            {
-                                u32 = z;
-                                go = true;
-                                // okay, use w1!
-                            }
-                        }
-                        if(w1) {
-                            if((z >> 10) == 0x37) { // low utf16 surrogate
-                                w2 = z;
-                                go = true;
-                                u32 = (((uint32_t)w1 & 0x3FF) << 10) | ((uint32_t)w2 & 0x3FF) + 0x10000; // reconstruct utf16 from high+low surrogates
-                            } else {
-                                // invalid...
-                                u32 = w1;
-                                go = true;
-                            }
-                        }
-                        // now check if we wanna go:
-                        if(go) {
-                            So_Uc_Point u8p = { .val = u32 };
-                            So u8 = {0};
-                            if(!so_uc_fmt_point(&u8, &u8p)) {
-                                So p = u8;
-                                if(!w1 && !w2) {
-                                    ASSERT(p.len <= 3, "expect to have 3 or less characters (0xFFFF max)...");
-                                } else {
-                                    ASSERT(p.len <= 5, "expect to have 5 or less characters (0x10FFFF max)...");
-                                }
-                                for(size_t k = 0; k < p.len; ++k) {
-                                    *so_it(json_str, j++) = p.str[k];
-                                }
-                            }
-                        }
-                    }
+                    ++*malformed;
+                    *i += 4;
                 }
+            } else if((w1 >> 10) == 0x37) {
+                ++*malformed; /* low surrogate without a high one */
+                *i += 4;
+            } else {
+                u32 = (uint32_t)w1;
+                *i += 4;
             }
-        } else {
-            *so_it(json_str, j++) = c;
+            /* never longer than the escape it replaces */
+            return json_utf8_encode(u32, out);
         }
+        default: ++*malformed; return 0;
     }
-    ASSERT(j <= so_len(json_str), "we only want to shrink the string!");
+}
+
+int json_fix_so(So json_str, So *out) {
+    char *s = so_it0(json_str);
+    size_t len = so_len(json_str);
+    size_t i = 0;
+    size_t j = 0;
+    int malformed = 0;
+    while(i < len) {
+        /* copy the run up to the next escape in one go; memchr is vectorized */
+        const char *escape = memchr(s + i, '\\', len - i);
+        size_t run = escape ? (size_t)(escape - (s + i)) : len - i;
+        if(j != i) memmove(s + j, s + i, run);
+        i += run;
+        j += run;
+        if(!escape) break;
+        j += json_fix_escape(s + j, s, len, &i, &malformed);
+    }
+    ASSERT(j <= len, "we only want to shrink the string!");
     so_resize(&json_str, j);
     *out = json_str;
+    return malformed;
+}
+
+size_t json_fix_unpaired(So json_str) {
+    const char *s = json_str.str;
+    size_t len = json_str.len;
+    for(size_t i = 0; i < len; ++i) {
+        const char *escape = memchr(s + i, '\\', len - i);
+        if(!escape) break;
+        i = (size_t)(escape - s);
+        int32_t w1 = json_fix_u16(s + i, len - i);
+        /* anything else escaped is skipped along with its backslash */
+        if(w1 < 0 || (w1 >> 11) != 0x1B) {
+            ++i;
+            continue;
+        }
+        if((w1 >> 10) == 0x37) return i;
+        int32_t w2 = json_fix_u16(s + i + 6, len - i - 6);
+        if(w2 < 0 || (w2 >> 10) != 0x37) return i;
+        i += 11;
+    }
+    return len;
+}
+
+bool json_fix_next(So *json_str, char buf[4], So *piece) {
+    if(!json_str->len) return false;
+    const char *s = json_str->str;
+    size_t len = json_str->len;
+    if(*s != '\\') {
+        const char *escape = memchr(s, '\\', len);
+        size_t run = escape ? (size_t)(escape - s) : len;
+        *piece = so_ll(s, run);
+        so_shift(json_str, run);
+        return true;
+    }
+    size_t i = 0;
+    int malformed = 0;
+    size_t n = json_fix_escape(buf, s, len, &i, &malformed);
+    *piece = so_ll(buf, n);
+    so_shift(json_str, i);
+    return true;
 }
 
 void json_parse_value_print(Json_Parse_Value *val) {
@@ -10,6 +10,7 @@
     (Json_Parse_Settings){ \
         .verbose = false, \
         .strict = false, \
+        .duplicates = JSON_DUPLICATES_ALLOW, \
     }
 #endif
 
@@ -30,21 +31,138 @@ typedef struct Json_Parse_Value {
         bool b;
     };
     Json_List id;
+    Json_List child; /* when entering (val == 0): JSON_OBJECT or JSON_ARRAY, what is entered */
+    size_t duplicate; /* keys, with JSON_DUPLICATES_LAST: 1 + index of the member this key repeats, else 0 */
 } Json_Parse_Value;
 
+typedef enum {
+    JSON_ERROR_NONE,
+    JSON_ERROR_INVALID,             /* rejected, nothing more known */
+    JSON_ERROR_END,                 /* input ended early */
+    JSON_ERROR_UNEXPECTED,          /* see .expected */
+    JSON_ERROR_TRAILING,            /* data after the top level value */
+    JSON_ERROR_ROOT,                /* strict: top level is not an object or array */
+    JSON_ERROR_DEPTH,               /* JSON_DEPTH_MAX exceeded */
+    JSON_ERROR_UNTERMINATED_STRING,
+    JSON_ERROR_ESCAPE,
+    JSON_ERROR_UNICODE_ESCAPE,
+    JSON_ERROR_CONTROL_CHARACTER,
+    JSON_ERROR_UTF8,
+    JSON_ERROR_NUMBER,
+    JSON_ERROR_LITERAL,
+    JSON_ERROR_DUPLICATE_KEY,       /* JSON_DUPLICATES_REJECT: key repeats within an object */
+    JSON_ERROR_LIMIT_BYTES,         /* Json_Parse_Limits exceeded, see there */
+    JSON_ERROR_LIMIT_NODES,
+    JSON_ERROR_LIMIT_WIDTH,
+    JSON_ERROR_LIMIT_STRING,
+    JSON_ERROR_LIMIT_MEMORY,
+    JSON_ERROR_SURROGATE,           /* .reject_surrogates: \u escape of an unpaired utf-16 surrogate */
+} Json_Error_List;
+
+/* where and why input got rejected. only filled on failure, the parser itself
+ * just fails; the error is then located with json_valid (rljson-valid.h) */
+typedef struct Json_Parse_Error {
+    size_t offset;          /* bytes into .input */
+    Json_Error_List code;
+    const char *expected;   /* static string or 0 */
+    So input;               /* view of the rejected input */
+} Json_Parse_Error;
+
+/* what to do about an object repeating a key; keys are compared decoded, and
+ * members are counted per distinct key. the index .duplicate refers to is
+ * that count, so it is the position in a container that keeps the first
+ * member of every key where it is */
+typedef enum {
+    JSON_DUPLICATES_ALLOW,  /* every member reaches the callbacks, unchecked */
+    JSON_DUPLICATES_REJECT, /* the input is invalid, JSON_ERROR_DUPLICATE_KEY */
+    JSON_DUPLICATES_FIRST,  /* repeated members are parsed, but reach no callback */
+    JSON_DUPLICATES_LAST,   /* repeated members come with .duplicate set on their key */
+} Json_Duplicates_List;
+
+/* caps on what one document may cost, for input that can not be trusted; 0
+ * leaves a limit off. checked while parsing, so a document going over one
+ * fails there, with the matching JSON_ERROR_LIMIT_* at the value, key or
+ * string that went over (.bytes at the first byte too many). binary input
+ * is held to them as well, see rljson-pack.h */
+typedef struct Json_Parse_Limits {
+    size_t bytes;   /* input length */
+    size_t nodes;   /* values in the whole document, objects and arrays included, keys not */
+    size_t width;   /* members of one object or elements of one array */
+    size_t string;  /* raw bytes between the quotes of a string or key, escapes undecoded */
+    size_t memory;  /* bytes of tree rljson-auto may build, see rljson-auto.h; ignored elsewhere */
+} Json_Parse_Limits;
+
 typedef struct Json_Parse_Settings {
     bool verbose;
     bool strict;
+    Json_Duplicates_List duplicates;
+    Json_Parse_Limits limits;
+    bool reject_surrogates; /* unpaired surrogate escapes are invalid, instead of decoding to U+FFFD */
+    bool pack; /* rljson-auto stores arrays of numbers of one kind packed, see rljson-auto.h; ignored elsewhere */
+    Json_Parse_Error *error; /* optional, filled on failure; one per thread */
 } Json_Parse_Settings;
 
 typedef void *(*Json_Parse_Callback)(void **user, Json_Parse_Value key, Json_Parse_Value *val);
 
+/* keys of the objects open while parsing, for .duplicates. objects nest, so
+ * this is a stack: the innermost object's keys and hash table are on top.
+ * the buffers are kept for the next object and document, so checking does not
+ * allocate once they have grown */
+typedef struct Json_Parse_Key {
+    uint64_t hash;
+    const char *str;    /* view of the input, or 0: decoded into Json_Parse_Keys.text at .at */
+    size_t at;
+    size_t len;
+} Json_Parse_Key;
+
+typedef struct Json_Parse_Keys_Level {
+    size_t keys;        /* where the object's part of every stack begins */
+    size_t slots;
+    size_t text;
+} Json_Parse_Keys_Level;
+
+typedef struct Json_Parse_Keys {
+    Json_Parse_Key *keys;
+    uint32_t *slots;    /* open addressing, index into the object's keys + 1 */
+    So text;            /* keys with escapes, decoded */
+    Json_Parse_Keys_Level *levels;
+} Json_Parse_Keys;
+
+void json_parse_keys_enter(Json_Parse_Keys *keys);
+bool json_parse_keys_add(Json_Parse_Keys *keys, So key, size_t *index); /* false if the innermost object has key already, as member *index */
+void json_parse_keys_leave(Json_Parse_Keys *keys);
+void json_parse_keys_clear(Json_Parse_Keys *keys);
+void json_parse_keys_free(Json_Parse_Keys *keys);
+
+/* reusable parser context.
+ *
+ * rljson keeps no global or static state: any number of threads may parse at
+ * the same time, as long as every thread uses its own Json_Parser (and its own
+ * output). a single Json_Parser must never be used by two threads at once.
+ * with .verbose enabled all threads print to the shared stdout.
+ *
+ * the parser owns its buffers and keeps them across json_parser_reset(), so
+ * after the first few documents parsing, validating (json_parser_valid() and
+ * the error of a failing document), unescaping and the text made up for binary
+ * input (rljson-pack.h) no longer allocate.
+ * per-depth state lives on the call stack (bounded by JSON_DEPTH_MAX). */
+typedef struct Json_Parser {
+    Json_Parse_Settings settings;
+    So scratch;     /* unescape buffer, see json_parser_unescape() */
+    So *texts;      /* chunks of text made up for callbacks, see rljson-pack.h */
+    size_t texts_used; /* bytes in use of the last chunk */
+    Json_Parse_Keys keys; /* see Json_Parse_Settings.duplicates */
+    size_t *widths; /* counts of the open containers, for json_valid_ext */
+    size_t nodes;   /* values parsed so far in the current document, see Json_Parse_Limits */
+} Json_Parser;
+
 typedef struct Json_Parse {
     So head;
     Json_Parse_Value key;
     size_t depth;
     Json_Parse_Callback callback;
     Json_Parse_Settings settings;
+    Json_Parser *parser;
     void *user;
 } Json_Parse;
 
@@ -57,7 +175,37 @@ ErrDecl json_parse_valid_ext(So input, Json_Parse_Settings *settings);
 ErrDecl json_parse(So input, Json_Parse_Callback callback, void *user);
 ErrDecl json_parse_ext(So input, Json_Parse_Callback callback, void *user, Json_Parse_Settings *settings);
 
-void json_fix_so(So json_str, So *out); /* modifies the existing string; no additional memory allocation */
+void json_parser_init(Json_Parser *parser, Json_Parse_Settings *settings);
+void json_parser_reset(Json_Parser *parser);
+void json_parser_free(Json_Parser *parser);
+ErrDecl json_parser_valid(Json_Parser *parser, So input);
+ErrDecl json_parser_parse(Json_Parser *parser, So input, Json_Parse_Callback callback, void *user);
+So json_parser_unescape(Json_Parser *parser, So json_str); /* result is valid until the next call or reset */
+
+/* low level scanning on a Json_Parse cursor, return true on match and advance .head.
+ * these read every setting at runtime and trace with .verbose; json_parser_parse
+ * runs a copy specialized to its settings instead, see rljson-core-variant.h */
+bool json_parse_ch(Json_Parse *p, char c);
+void json_parse_ws(Json_Parse *p);
+bool json_parse_string(Json_Parse *p, So *val);
+bool json_parse_number(Json_Parse *p, So *val);
+bool json_parse_bool(Json_Parse *p, bool *val);
+bool json_parse_null(Json_Parse *p);
+bool json_parse_value(Json_Parse *p, Json_Parse_Value *v); /* objects and arrays get their raw text in v->s */
+bool json_parse_skip(Json_Parse *p, So *span, size_t *nesting); /* already validated object/array only; nesting may be 0 */
+
+const char *json_parse_error_str(Json_Error_List code);
+void json_parse_error_position(Json_Parse_Error *error, size_t *line, size_t *column); /* 1-based, counted when asked */
+
+/* decode escapes, in place without allocating. unpaired surrogates become
+ * U+FFFD, other malformed escapes are dropped; returns how many there were.
+ * validated input only has the former, and with .reject_surrogates none */
+int json_fix_so(So json_str, So *out);
+size_t json_fix_unpaired(So json_str); /* offset of the first unpaired surrogate escape, or .len */
+/* the same decoding, piece by piece and without writing to json_str: each
+ * call hands out the next run of text up to an escape, or one decoded escape
+ * (held in buf, maybe empty). false once all of json_str is consumed */
+bool json_fix_next(So *json_str, char buf[4], So *piece);
 void json_parse_value_print(Json_Parse_Value *val);
 
 #define RLJSON_CORE_H
@@ -0,0 +1,727 @@
+#include <math.h>
+#include <inttypes.h>
+#include "rljson-pack.h"
+
+typedef enum {
+    JSON_PACK_ITEM_NULL,
+    JSON_PACK_ITEM_BOOL,
+    JSON_PACK_ITEM_UINT,
+    JSON_PACK_ITEM_NEGINT, /* -1 - .u */
+    JSON_PACK_ITEM_FLOAT,
+    JSON_PACK_ITEM_STRING,
+    JSON_PACK_ITEM_ARRAY,
+    JSON_PACK_ITEM_MAP,
+    JSON_PACK_ITEM_BREAK, /* end of an indefinite length cbor array or map */
+} Json_Pack_Item_List;
+
+typedef struct Json_Pack_Item {
+    Json_Pack_Item_List id;
+    bool indefinite;
+    uint64_t u; /* bool, integer, or count of a container */
+    double f;
+    So s;
+    size_t escaped; /* strings: bytes json text needs between the quotes */
+} Json_Pack_Item;
+
+#define JSON_PACK_TEXT_CHUNK    4096
+
+void json_pack_be(So *out, uint64_t u, size_t bytes) {
+    for(size_t i = bytes; i > 0; --i) {
+        so_push(out, (char)(u >> (8 * (i - 1))));
+    }
+}
+
+/* cbor head: major type and argument, in as few bytes as possible */
+void json_pack_cbor_head(So *out, unsigned char major, uint64_t u) {
+    major <<= 5;
+    if(u < 24) {
+        so_push(out, (char)(major | u));
+    } else if(u <= 0xFF) {
+        so_push(out, (char)(major | 24));
+        json_pack_be(out, u, 1);
+    } else if(u <= 0xFFFF) {
+        so_push(out, (char)(major | 25));
+        json_pack_be(out, u, 2);
+    } else if(u <= 0xFFFFFFFF) {
+        so_push(out, (char)(major | 26));
+        json_pack_be(out, u, 4);
+    } else {
+        so_push(out, (char)(major | 27));
+        json_pack_be(out, u, 8);
+    }
+}
+
+/* msgpack: fix form if it fits, else the 8 (if there is one), 16 or 32 bit form */
+void json_pack_msgpack_head(So *out, unsigned char fix, size_t fix_max, unsigned char marker8, unsigned char marker16, size_t u) {
+    if(u <= fix_max) {
+        so_push(out, (char)(fix | u));
+    } else if(marker8 && u <= 0xFF) {
+        so_push(out, (char)marker8);
+        json_pack_be(out, u, 1);
+    } else if(u <= 0xFFFF) {
+        so_push(out, (char)marker16);
+        json_pack_be(out, u, 2);
+    } else {
+        ASSERT(u <= 0xFFFFFFFF, "too large for msgpack: %zu", u);
+        so_push(out, (char)(marker16 + 1));
+        json_pack_be(out, u, 4);
+    }
+}
+
+void json_pack_uint(So *out, uint64_t u, Json_Pack_List format) {
+    if(format == JSON_PACK_CBOR) {
+        json_pack_cbor_head(out, 0, u);
+    } else if(u < 0x80) {
+        so_push(out, (char)u);
+    } else {
+        unsigned char marker = u <= 0xFF ? 0xcc : u <= 0xFFFF ? 0xcd : u <= 0xFFFFFFFF ? 0xce : 0xcf;
+        so_push(out, (char)marker);
+        json_pack_be(out, u, (size_t)1 << (marker - 0xcc));
+    }
+}
+
+/* the integer -1 - n */
+void json_pack_negint(So *out, uint64_t n, Json_Pack_List format) {
+    if(format == JSON_PACK_CBOR) {
+        json_pack_cbor_head(out, 1, n);
+    } else if(n < 32) {
+        so_push(out, (char)(0xe0 | (31 - n)));
+    } else {
+        int64_t i = -1 - (int64_t)n;
+        unsigned char marker = i >= INT8_MIN ? 0xd0 : i >= INT16_MIN ? 0xd1 : i >= INT32_MIN ? 0xd2 : 0xd3;
+        so_push(out, (char)marker);
+        json_pack_be(out, (uint64_t)i, (size_t)1 << (marker - 0xd0));
+    }
+}
+
+void json_pack_double(So *out, double f, Json_Pack_List format) {
+    /* whole numbers go as integers, other doubles as float32 where lossless */
+    if(f == floor(f) && fabs(f) < 9007199254740992.0 && !(f == 0 && signbit(f))) {
+        if(f >= 0) json_pack_uint(out, (uint64_t)f, format);
+        else json_pack_negint(out, (uint64_t)(-1 - f), format);
+        return;
+    }
+    float f32 = (float)f;
+    if((double)f32 == f) {
+        uint32_t bits;
+        memcpy(&bits, &f32, sizeof(bits));
+        so_push(out, format == JSON_PACK_CBOR ? (char)0xfa : (char)0xca);
+        json_pack_be(out, bits, 4);
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        so_push(out, format == JSON_PACK_CBOR ? (char)0xfb : (char)0xcb);
+        json_pack_be(out, bits, 8);
+    }
+}
+
+void json_pack_string(So *out, So s, bool decoded, Json_Pack_List format) {
+    So fix = SO;
+    if(!decoded && s.len && memchr(s.str, '\\', s.len)) {
+        so_extend(&fix, s);
+        json_fix_so(fix, &s);
+    }
+    if(format == JSON_PACK_CBOR) json_pack_cbor_head(out, 3, s.len);
+    else json_pack_msgpack_head(out, 0xa0, 31, 0xd9, 0xda, s.len);
+    so_extend(out, s);
+    so_free(&fix);
+}
+
+void json_auto_fmt_pack(So *out, Json_Auto_Value *autojson, Json_Pack_List format) {
+    ASSERT_ARG(out);
+    ASSERT_ARG(autojson);
+    bool cbor = format == JSON_PACK_CBOR;
+    autojson = json_auto_borrow(autojson);
+    size_t packed = 0;
+    size_t *sizes = json_auto_sizes(autojson, &packed);
+    double *doubles = json_auto_doubles(autojson, &packed);
+    if(sizes || doubles) {
+        if(cbor) json_pack_cbor_head(out, 4, packed);
+        else json_pack_msgpack_head(out, 0x90, 15, 0, 0xdc, packed);
+        for(size_t i = 0; i < packed; ++i) {
+            if(sizes) json_pack_uint(out, sizes[i], format);
+            else json_pack_double(out, doubles[i], format);
+        }
+        return;
+    }
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_NULL: so_push(out, cbor ? (char)0xf6 : (char)0xc0); break;
+        case JSON_AUTO_VALUE_BOOL: {
+            if(cbor) so_push(out, autojson->b ? (char)0xf5 : (char)0xf4);
+            else so_push(out, autojson->b ? (char)0xc3 : (char)0xc2);
+        } break;
+        case JSON_AUTO_VALUE_SIZE: json_pack_uint(out, autojson->z, format); break;
+        case JSON_AUTO_VALUE_DOUBLE: json_pack_double(out, autojson->f, format); break;
+        case JSON_AUTO_VALUE_STRING: {
+            json_pack_string(out, autojson->so, autojson->flags & JSON_AUTO_FLAG_DECODED, format);
+        } break;
+        case JSON_AUTO_VALUE_ARRAY: {
+            size_t len = array_len(autojson->arr);
+            if(cbor) json_pack_cbor_head(out, 4, len);
+            else json_pack_msgpack_head(out, 0x90, 15, 0, 0xdc, len);
+            for(size_t i = 0; i < len; ++i) {
+                json_auto_fmt_pack(out, array_it(autojson->arr, i), format);
+            }
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            size_t len = array_len(autojson->dict);
+            if(cbor) json_pack_cbor_head(out, 5, len);
+            else json_pack_msgpack_head(out, 0x80, 15, 0, 0xde, len);
+            for(size_t i = 0; i < len; ++i) {
+                Json_Auto_Key_Value *kv = array_it(autojson->dict, i);
+                json_pack_string(out, kv->key, kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED, format);
+                json_auto_fmt_pack(out, &kv->val, format);
+            }
+        } break;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), autojson->id);
+    }
+}
+
+bool json_pack_take(So *in, size_t bytes, uint64_t *u) {
+    if(in->len < bytes) return false;
+    uint64_t result = 0;
+    for(size_t i = 0; i < bytes; ++i) {
+        result = (result << 8) | (unsigned char)in->str[i];
+    }
+    so_shift(in, bytes);
+    *u = result;
+    return true;
+}
+
+double json_pack_half(uint16_t half) {
+    int exp = (half >> 10) & 0x1F;
+    int mant = half & 0x3FF;
+    double result;
+    if(exp == 0) result = ldexp(mant, -24);
+    else if(exp != 31) result = ldexp(mant + 1024, exp - 25);
+    else result = mant ? NAN : INFINITY;
+    return half & 0x8000 ? -result : result;
+}
+
+/* json text only holds utf-8, the same check json_parse_string does. on the
+ * way it counts what escaping takes: strings that need none get used as they
+ * are, without looking at them again */
+bool json_pack_utf8(So s, size_t *escaped) {
+    size_t len = s.len;
+    for(size_t i = 0; i < s.len;) {
+        unsigned char c = (unsigned char)s.str[i];
+        if(!(c & 0x80)) {
+            if(c == '"' || c == '\\') len += 1;
+            else if(c < ' ') len += 5;
+            ++i;
+            continue;
+        }
+        So_Uc_Point point = {0};
+        if(so_uc_point(so_ll(s.str + i, s.len - i), &point)) return false;
+        i += point.bytes;
+    }
+    *escaped = len;
+    return true;
+}
+
+ErrDecl json_pack_cbor_item(So *in, Json_Pack_Item *item) {
+    uint64_t u = 0;
+    for(;;) {
+        if(!json_pack_take(in, 1, &u)) return -1;
+        unsigned char major = u >> 5;
+        unsigned char info = u & 0x1F;
+        *item = (Json_Pack_Item){0};
+        if(major == 7) {
+            switch(info) {
+                case 20: item->id = JSON_PACK_ITEM_BOOL; item->u = 0; return 0;
+                case 21: item->id = JSON_PACK_ITEM_BOOL; item->u = 1; return 0;
+                case 22: item->id = JSON_PACK_ITEM_NULL; return 0;
+                case 25: {
+                    if(!json_pack_take(in, 2, &u)) return -1;
+                    item->f = json_pack_half(u);
+                } break;
+                case 26: {
+                    if(!json_pack_take(in, 4, &u)) return -1;
+                    uint32_t bits = u;
+                    float f32;
+                    memcpy(&f32, &bits, sizeof(f32));
+                    item->f = f32;
+                } break;
+                case 27: {
+                    if(!json_pack_take(in, 8, &u)) return -1;
+                    memcpy(&item->f, &u, sizeof(item->f));
+                } break;
+                case 31: item->id = JSON_PACK_ITEM_BREAK; return 0;
+                default: return -1; /* undefined and other simple values */
+            }
+            if(!isfinite(item->f)) return -1;
+            item->id = JSON_PACK_ITEM_FLOAT;
+            return 0;
+        }
+        if(info == 31) {
+            if(major != 4 && major != 5) return -1;
+            item->id = major == 4 ? JSON_PACK_ITEM_ARRAY : JSON_PACK_ITEM_MAP;
+            item->indefinite = true;
+            return 0;
+        }
+        if(info < 24) u = info;
+        else if(info > 27) return -1;
+        else if(!json_pack_take(in, (size_t)1 << (info - 24), &u)) return -1;
+        switch(major) {
+            case 0: item->id = JSON_PACK_ITEM_UINT; break;
+            case 1: item->id = JSON_PACK_ITEM_NEGINT; break;
+            case 2: return -1; /* byte string */
+            case 3: {
+                if(u > in->len) return -1;
+                item->id = JSON_PACK_ITEM_STRING;
+                item->s = so_ll(in->str, u);
+                if(!json_pack_utf8(item->s, &item->escaped)) return -1;
+                so_shift(in, u);
+            } break;
+            case 4: item->id = JSON_PACK_ITEM_ARRAY; break;
+            case 5: item->id = JSON_PACK_ITEM_MAP; break;
+            case 6: continue; /* tag, the tagged item follows */
+            default: return -1;
+        }
+        item->u = u;
+        return 0;
+    }
+}
+
+ErrDecl json_pack_msgpack_item(So *in, Json_Pack_Item *item) {
+    uint64_t u = 0;
+    if(!json_pack_take(in, 1, &u)) return -1;
+    unsigned char c = u;
+    size_t bytes = 0;
+    *item = (Json_Pack_Item){0};
+    if(c <= 0x7f) {
+        item->id = JSON_PACK_ITEM_UINT;
+        item->u = c;
+        return 0;
+    }
+    if(c >= 0xe0) {
+        item->id = JSON_PACK_ITEM_NEGINT;
+        item->u = 0xff - c;
+        return 0;
+    }
+    if((c & 0xf0) == 0x80 || (c & 0xf0) == 0x90) {
+        item->id = (c & 0xf0) == 0x80 ? JSON_PACK_ITEM_MAP : JSON_PACK_ITEM_ARRAY;
+        item->u = c & 0x0f;
+        return 0;
+    }
+    if((c & 0xe0) == 0xa0) {
+        u = c & 0x1f;
+        goto string;
+    }
+    switch(c) {
+        case 0xc0: item->id = JSON_PACK_ITEM_NULL; return 0;
+        case 0xc2: case 0xc3: item->id = JSON_PACK_ITEM_BOOL; item->u = c & 1; return 0;
+        case 0xca: {
+            if(!json_pack_take(in, 4, &u)) return -1;
+            uint32_t bits = u;
+            float f32;
+            memcpy(&f32, &bits, sizeof(f32));
+            item->f = f32;
+        } goto floating;
+        case 0xcb: {
+            if(!json_pack_take(in, 8, &u)) return -1;
+            memcpy(&item->f, &u, sizeof(item->f));
+        } goto floating;
+        case 0xcc: case 0xcd: case 0xce: case 0xcf: {
+            if(!json_pack_take(in, (size_t)1 << (c - 0xcc), &item->u)) return -1;
+            item->id = JSON_PACK_ITEM_UINT;
+        } return 0;
+        case 0xd0: case 0xd1: case 0xd2: case 0xd3: {
+            bytes = (size_t)1 << (c - 0xd0);
+            if(!json_pack_take(in, bytes, &u)) return -1;
+            /* sign extend */
+            if(bytes < 8 && (u >> (8 * bytes - 1))) u |= ~(uint64_t)0 << (8 * bytes);
+            int64_t i = (int64_t)u;
+            item->id = i < 0 ? JSON_PACK_ITEM_NEGINT : JSON_PACK_ITEM_UINT;
+            item->u = i < 0 ? (uint64_t)(-(i + 1)) : (uint64_t)i;
+        } return 0;
+        case 0xd9: case 0xda: case 0xdb: {
+            if(!json_pack_take(in, (size_t)1 << (c - 0xd9), &u)) return -1;
+        } goto string;
+        case 0xdc: case 0xdd: case 0xde: case 0xdf: {
+            if(!json_pack_take(in, c & 1 ? 4 : 2, &item->u)) return -1;
+            item->id = c <= 0xdd ? JSON_PACK_ITEM_ARRAY : JSON_PACK_ITEM_MAP;
+        } return 0;
+        default: return -1; /* never used, bin and ext */
+    }
+string:
+    if(u > in->len) return -1;
+    item->id = JSON_PACK_ITEM_STRING;
+    item->s = so_ll(in->str, u);
+    if(!json_pack_utf8(item->s, &item->escaped)) return -1;
+    so_shift(in, u);
+    return 0;
+floating:
+    if(!isfinite(item->f)) return -1;
+    item->id = JSON_PACK_ITEM_FLOAT;
+    return 0;
+}
+
+ErrDecl json_pack_item(So *in, Json_Pack_List format, Json_Pack_Item *item) {
+    if(format == JSON_PACK_CBOR) return json_pack_cbor_item(in, item);
+    return json_pack_msgpack_item(in, item);
+}
+
+/* next element of a container; false at its end. every element takes at
+ * least a byte, which bounds the claimed count by what's left of the input.
+ * only cbor has indefinite lengths, ended by a break byte */
+bool json_pack_more(So *in, Json_Pack_List format, Json_Pack_Item *container, size_t i, int *err) {
+    if(format != JSON_PACK_CBOR || !container->indefinite) {
+        if(i < container->u && container->u - i > in->len) *err = -1;
+        return !*err && i < container->u;
+    }
+    if(!in->len) {
+        *err = -1;
+        return false;
+    }
+    if((unsigned char)*in->str != 0xff) return true;
+    so_shift(in, 1);
+    return false;
+}
+
+/* writes the .escaped bytes of a string item */
+void json_pack_escape_to(char *out, So s) {
+    size_t j = 0;
+    for(size_t i = 0; i < s.len; ++i) {
+        unsigned char c = (unsigned char)s.str[i];
+        if(c == '"' || c == '\\') {
+            out[j++] = '\\';
+            out[j++] = c;
+        } else if(c < ' ') {
+            memcpy(out + j, "\\u00", 4);
+            out[j + 4] = "0123456789abcdef"[c >> 4];
+            out[j + 5] = "0123456789abcdef"[c & 0xF];
+            j += 6;
+        } else {
+            out[j++] = c;
+        }
+    }
+}
+
+void json_pack_fmt_escaped(So *out, Json_Pack_Item *item) {
+    size_t len = so_len(*out);
+    so_resize(out, len + item->escaped);
+    json_pack_escape_to(so_it(*out, len), item->s);
+}
+
+/* Json_Parse_Settings on binary input, checked as the text parser does:
+ * .limits (with .string on the text json would hold), .duplicates and
+ * .strict, and where the input got rejected for .error. offsets are bytes
+ * into the binary input, at the item that went over */
+typedef struct Json_Pack_Check {
+    So input;
+    Json_Parse_Settings *settings;
+    Json_Parse_Keys *keys;  /* 0 with JSON_DUPLICATES_ALLOW */
+    size_t nodes;
+    size_t nodes_max;
+    Json_Error_List code;
+    size_t offset;
+    So escaped;             /* a decoded key with a backslash, escaped for keys */
+} Json_Pack_Check;
+
+int json_pack_fail(Json_Pack_Check *c, Json_Error_List code, const char *at) {
+    if(!c->code) {
+        c->code = code;
+        c->offset = (size_t)(at - c->input.str);
+    }
+    return -1;
+}
+
+ErrDecl json_pack_check_node(Json_Pack_Check *c, const char *at) {
+    if(c->nodes_max && ++c->nodes > c->nodes_max) return json_pack_fail(c, JSON_ERROR_LIMIT_NODES, at);
+    return 0;
+}
+
+ErrDecl json_pack_check_string(Json_Pack_Check *c, size_t escaped_len, const char *at) {
+    if(c->settings->limits.string && escaped_len > c->settings->limits.string) return json_pack_fail(c, JSON_ERROR_LIMIT_STRING, at);
+    return 0;
+}
+
+/* key is what json text would have held; *repeated with the index of the
+ * member it repeats + 1, for JSON_DUPLICATES_FIRST and _LAST */
+ErrDecl json_pack_check_key(Json_Pack_Check *c, So key, const char *at, size_t *repeated) {
+    *repeated = 0;
+    if(!c->keys) return 0;
+    size_t earlier = 0;
+    if(json_parse_keys_add(c->keys, key, &earlier)) return 0;
+    if(c->settings->duplicates == JSON_DUPLICATES_REJECT) return json_pack_fail(c, JSON_ERROR_DUPLICATE_KEY, at);
+    *repeated = earlier + 1;
+    return 0;
+}
+
+ErrDecl json_pack_check_begin(Json_Pack_Check *c, So input, Json_Parse_Settings *settings, Json_Parse_Keys *keys) {
+    *c = (Json_Pack_Check){
+        .input = input,
+        .settings = settings,
+        .keys = settings->duplicates ? keys : 0,
+        .nodes_max = settings->limits.nodes,
+    };
+    if(settings->error) *settings->error = (Json_Parse_Error){0};
+    if(settings->limits.bytes && input.len > settings->limits.bytes) {
+        return json_pack_fail(c, JSON_ERROR_LIMIT_BYTES, input.str + settings->limits.bytes);
+    }
+    return 0;
+}
+
+/* at is where decoding stopped, for failures without a code of their own */
+int json_pack_check_end(Json_Pack_Check *c, int result, const char *at) {
+    if(result && c->keys) json_parse_keys_clear(c->keys);
+    if(result && !c->code) json_pack_fail(c, JSON_ERROR_INVALID, at);
+    if(result && c->settings->error) {
+        *c->settings->error = (Json_Parse_Error){ .code = c->code, .offset = c->offset, .input = c->input };
+    }
+    so_free(&c->escaped);
+    return result;
+}
+
+ErrDecl json_pack_auto(Json_Pack_Check *c, So *in, Json_Pack_List format, Json_Auto_Value *out, size_t depth) {
+    Json_Pack_Item item;
+    int err = 0;
+    const char *at = in->str;
+    if(depth >= JSON_DEPTH_MAX) return json_pack_fail(c, JSON_ERROR_DEPTH, at);
+    if(json_pack_item(in, format, &item)) return -1;
+    if(json_pack_check_node(c, at)) return -1;
+    switch(item.id) {
+        case JSON_PACK_ITEM_NULL: out->id = JSON_AUTO_VALUE_NULL; break;
+        case JSON_PACK_ITEM_BOOL: out->id = JSON_AUTO_VALUE_BOOL; out->b = item.u; break;
+        case JSON_PACK_ITEM_UINT: out->id = JSON_AUTO_VALUE_SIZE; out->z = item.u; break;
+        case JSON_PACK_ITEM_NEGINT: out->id = JSON_AUTO_VALUE_DOUBLE; out->f = -1.0 - (double)item.u; break;
+        case JSON_PACK_ITEM_FLOAT: out->id = JSON_AUTO_VALUE_DOUBLE; out->f = item.f; break;
+        case JSON_PACK_ITEM_STRING: {
+            out->id = JSON_AUTO_VALUE_STRING;
+            out->so = item.s;
+            out->flags |= JSON_AUTO_FLAG_DECODED;
+            if(c->settings->limits.string && json_pack_check_string(c, item.escaped, at)) return -1;
+        } break;
+        case JSON_PACK_ITEM_ARRAY: {
+            out->id = JSON_AUTO_VALUE_ARRAY;
+            size_t width = c->settings->limits.width;
+            for(size_t i = 0; json_pack_more(in, format, &item, i, &err); ++i) {
+                if(width && i >= width) return json_pack_fail(c, JSON_ERROR_LIMIT_WIDTH, in->str);
+                array_push(out->arr, (Json_Auto_Value){0});
+                if(json_pack_auto(c, in, format, array_itL(out->arr), depth + 1)) return -1;
+            }
+        } break;
+        case JSON_PACK_ITEM_MAP: {
+            out->id = JSON_AUTO_VALUE_OBJECT;
+            size_t width = c->settings->limits.width;
+            if(c->keys) json_parse_keys_enter(c->keys);
+            for(size_t i = 0; json_pack_more(in, format, &item, i, &err); ++i) {
+                Json_Pack_Item key;
+                const char *key_at = in->str;
+                if(width && i >= width) return json_pack_fail(c, JSON_ERROR_LIMIT_WIDTH, key_at);
+                if(json_pack_item(in, format, &key) || key.id != JSON_PACK_ITEM_STRING) return -1;
+                if(c->settings->limits.string && json_pack_check_string(c, key.escaped, key_at)) return -1;
+                size_t repeated = 0;
+                if(c->keys) {
+                    /* keys get compared as json text holds them */
+                    So text = key.s;
+                    if(key.s.len && memchr(key.s.str, '\\', key.s.len)) {
+                        so_clear(&c->escaped);
+                        json_pack_fmt_escaped(&c->escaped, &key);
+                        text = c->escaped;
+                    }
+                    if(json_pack_check_key(c, text, key_at, &repeated)) return -1;
+                }
+                Json_Auto_Value *val = 0, discard = {0};
+                if(!repeated) {
+                    array_push(out->dict, ((Json_Auto_Key_Value){ .key = key.s, .val.flags = JSON_AUTO_FLAG_KEY_DECODED }));
+                    val = &array_itL(out->dict)->val;
+                } else if(c->settings->duplicates == JSON_DUPLICATES_LAST) {
+                    /* the last value, where the key came first */
+                    val = &array_it(out->dict, repeated - 1)->val;
+                    json_auto_free(val);
+                    *val = (Json_Auto_Value){ .flags = JSON_AUTO_FLAG_KEY_DECODED };
+                } else {
+                    /* JSON_DUPLICATES_FIRST: checked, but not kept */
+                    val = &discard;
+                }
+                int sub = json_pack_auto(c, in, format, val, depth + 1);
+                json_auto_free(&discard);
+                if(sub) return -1;
+            }
+            if(c->keys) json_parse_keys_leave(c->keys);
+        } break;
+        default: return -1;
+    }
+    return err;
+}
+
+ErrDecl json_auto_from_pack(So input, Json_Auto_Value *out, Json_Pack_List format) {
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    return json_auto_from_pack_ext(input, out, format, &settings);
+}
+
+ErrDecl json_auto_from_pack_ext(So input, Json_Auto_Value *out, Json_Pack_List format, Json_Parse_Settings *settings) {
+    ASSERT_ARG(out);
+    ASSERT_ARG(settings);
+    *out = (Json_Auto_Value){0};
+    Json_Pack_Check c;
+    Json_Parse_Keys keys = {0};
+    So head = input;
+    int result = json_pack_check_begin(&c, input, settings, &keys);
+    c.nodes_max = json_auto_limit_nodes(settings->limits);
+    if(!result) result = json_pack_auto(&c, &head, format, out, 0);
+    if(!result && head.len) result = json_pack_fail(&c, JSON_ERROR_TRAILING, head.str);
+    if(!result && settings->strict && out->id != JSON_AUTO_VALUE_OBJECT && out->id != JSON_AUTO_VALUE_ARRAY) {
+        result = json_pack_fail(&c, JSON_ERROR_ROOT, input.str);
+    }
+    /* the values ran out because of the memory limit */
+    if(c.code == JSON_ERROR_LIMIT_NODES && c.nodes_max != settings->limits.nodes) c.code = JSON_ERROR_LIMIT_MEMORY;
+    json_pack_check_end(&c, result, head.str);
+    json_parse_keys_free(&keys);
+    if(result) {
+        json_auto_free(out);
+        *out = (Json_Auto_Value){0};
+    }
+    return result;
+}
+
+/* writable memory that stays put until json_parser_reset */
+char *json_pack_text(Json_Parser *parser, size_t len) {
+    size_t n = array_len(parser->texts);
+    if(!n || parser->texts_used + len > so_len(array_at(parser->texts, n - 1))) {
+        So chunk = SO;
+        so_resize(&chunk, len > JSON_PACK_TEXT_CHUNK ? len : JSON_PACK_TEXT_CHUNK);
+        array_push(parser->texts, chunk);
+        parser->texts_used = 0;
+        ++n;
+    }
+    char *result = so_it(array_at(parser->texts, n - 1), parser->texts_used);
+    parser->texts_used += len;
+    return result;
+}
+
+/* what json text would have held between the quotes */
+So json_pack_escape(Json_Parser *parser, Json_Pack_Item *item) {
+    if(item->escaped == item->s.len) return item->s;
+    char *out = json_pack_text(parser, item->escaped);
+    json_pack_escape_to(out, item->s);
+    return so_ll(out, item->escaped);
+}
+
+/* integers are written back to front, without a format string */
+So json_pack_number(Json_Parser *parser, Json_Pack_Item *item) {
+    char buf[32];
+    char *end = buf + sizeof(buf), *begin = end;
+    switch(item->id) {
+        case JSON_PACK_ITEM_UINT:
+        case JSON_PACK_ITEM_NEGINT: {
+            uint64_t u = item->u;
+            bool negative = item->id == JSON_PACK_ITEM_NEGINT;
+            /* -1 - .u, one past UINT64_MAX when .u is */
+            if(negative && u == UINT64_MAX) {
+                memcpy(begin -= 20, "18446744073709551616", 20);
+            } else {
+                if(negative) ++u;
+                do *--begin = '0' + u % 10; while(u /= 10);
+            }
+            if(negative) *--begin = '-';
+        } break;
+        case JSON_PACK_ITEM_FLOAT: {
+            begin = buf;
+            end = buf + snprintf(buf, sizeof(buf), "%.17g", item->f);
+        } break;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), item->id);
+    }
+    size_t len = end - begin;
+    char *out = json_pack_text(parser, len);
+    memcpy(out, begin, len);
+    return so_ll(out, len);
+}
+
+typedef struct Json_Pack_Parse {
+    So head;
+    Json_Pack_List format;
+    Json_Parser *parser;
+    Json_Pack_Check check;
+} Json_Pack_Parse;
+
+/* turn a scalar item into the value json text would have produced */
+ErrDecl json_pack_parse_scalar(Json_Pack_Parse *p, Json_Pack_Item *item, const char *at, Json_Parse_Value *v) {
+    *v = (Json_Parse_Value){0};
+    switch(item->id) {
+        case JSON_PACK_ITEM_NULL: v->id = JSON_NULL; break;
+        case JSON_PACK_ITEM_BOOL: v->id = JSON_BOOL; v->b = item->u; break;
+        case JSON_PACK_ITEM_STRING: {
+            v->id = JSON_STRING;
+            v->s = json_pack_escape(p->parser, item);
+            if(json_pack_check_string(&p->check, v->s.len, at)) return -1;
+        } break;
+        default: v->id = JSON_NUMBER; v->s = json_pack_number(p->parser, item); break;
+    }
+    return json_pack_check_node(&p->check, at);
+}
+
+/* mirrors json_parse_array / json_parse_object: key is the level's own key */
+ErrDecl json_pack_parse_level(Json_Pack_Parse *p, Json_Pack_Item *container, Json_Parse_Value key, Json_Parse_Callback callback, void *user, size_t depth, const char *at) {
+    int err = 0;
+    Json_Pack_Check *c = &p->check;
+    if(depth >= JSON_DEPTH_MAX) return json_pack_fail(c, JSON_ERROR_DEPTH, at);
+    if(json_pack_check_node(c, at)) return -1;
+    bool map = container->id == JSON_PACK_ITEM_MAP;
+    key.id = map ? JSON_OBJECT : JSON_ARRAY;
+    key.duplicate = 0;
+    size_t width = c->settings->limits.width;
+    if(map && c->keys) json_parse_keys_enter(c->keys);
+    for(size_t i = 0; json_pack_more(&p->head, p->format, container, i, &err); ++i) {
+        Json_Pack_Item item;
+        Json_Parse_Callback subcallback = callback;
+        if(width && i >= width) return json_pack_fail(c, JSON_ERROR_LIMIT_WIDTH, p->head.str);
+        if(map) {
+            const char *key_at = p->head.str;
+            if(json_pack_item(&p->head, p->format, &item) || item.id != JSON_PACK_ITEM_STRING) return -1;
+            key.s = json_pack_escape(p->parser, &item);
+            size_t repeated = 0;
+            if(json_pack_check_string(c, key.s.len, key_at) || json_pack_check_key(c, key.s, key_at, &repeated)) return -1;
+            key.duplicate = repeated && c->settings->duplicates == JSON_DUPLICATES_LAST ? repeated : 0;
+            if(repeated && c->settings->duplicates == JSON_DUPLICATES_FIRST) subcallback = 0;
+        }
+        const char *item_at = p->head.str;
+        if(json_pack_item(&p->head, p->format, &item)) return -1;
+        if(item.id == JSON_PACK_ITEM_ARRAY || item.id == JSON_PACK_ITEM_MAP) {
+            Json_Parse_Value enter = key;
+            enter.child = item.id == JSON_PACK_ITEM_MAP ? JSON_OBJECT : JSON_ARRAY;
+            void *subuser = user;
+            Json_Parse_Callback nested = subcallback ? subcallback(&subuser, enter, 0) : 0;
+            if(json_pack_parse_level(p, &item, key, nested, subuser, depth + 1, item_at)) return -1;
+        } else if(item.id == JSON_PACK_ITEM_BREAK) {
+            return -1;
+        } else {
+            Json_Parse_Value v;
+            if(json_pack_parse_scalar(p, &item, item_at, &v)) return -1;
+            void *subuser = user;
+            if(subcallback) subcallback(&subuser, key, &v);
+        }
+    }
+    if(map && c->keys) json_parse_keys_leave(c->keys);
+    return err;
+}
+
+ErrDecl json_parser_parse_pack(Json_Parser *parser, So input, Json_Pack_List format, Json_Parse_Callback callback, void *user) {
+    ASSERT_ARG(parser);
+    Json_Pack_Parse p = {
+        .head = input,
+        .format = format,
+        .parser = parser,
+    };
+    Json_Pack_Check *c = &p.check;
+    int result = json_pack_check_begin(c, input, &parser->settings, &parser->keys);
+    Json_Pack_Item item;
+    if(result || (result = json_pack_item(&p.head, format, &item))) goto done;
+    if(item.id == JSON_PACK_ITEM_ARRAY || item.id == JSON_PACK_ITEM_MAP) {
+        result = json_pack_parse_level(&p, &item, (Json_Parse_Value){0}, callback, user, 1, input.str);
+    } else if(item.id == JSON_PACK_ITEM_BREAK) {
+        result = -1;
+    } else if(parser->settings.strict) {
+        result = json_pack_fail(c, JSON_ERROR_ROOT, input.str);
+    } else {
+        Json_Parse_Value v;
+        result = json_pack_parse_scalar(&p, &item, input.str, &v);
+        if(!result && callback) callback(&user, v, 0);
+    }
+    if(!result && p.head.len) result = json_pack_fail(c, JSON_ERROR_TRAILING, p.head.str);
+done:
+    return json_pack_check_end(c, result, p.head.str);
+}
+
@@ -0,0 +1,42 @@
+#ifndef RLJSON_PACK_H
+
+#include "rljson-auto.h"
+
+/* CBOR (RFC 8949) and MessagePack interchange for Json_Auto_Value trees.
+ *
+ * only what json can hold goes through: byte strings, extension types, non
+ * finite floats, text strings that aren't valid utf-8 and maps with
+ * non-string keys are rejected when decoding.
+ * CBOR tags are skipped, indefinite length arrays and maps are accepted,
+ * indefinite length strings are not. strings are stored decoded, so decoding
+ * doesn't copy them: the tree's strings are views into the input, which has
+ * to outlive it. whole numbers below zero come back as doubles, like they do
+ * from json text. */
+
+typedef enum {
+    JSON_PACK_CBOR,
+    JSON_PACK_MSGPACK,
+} Json_Pack_List;
+
+void json_auto_fmt_pack(So *out, Json_Auto_Value *autojson, Json_Pack_List format); /* lazy values of autojson get parsed */
+ErrDecl json_auto_from_pack(So input, Json_Auto_Value *out, Json_Pack_List format);
+/* with the checks of json_auto_parse_ext: .limits, .duplicates, .strict and
+ * .error, see below; .pack is not applied */
+ErrDecl json_auto_from_pack_ext(So input, Json_Auto_Value *out, Json_Pack_List format, Json_Parse_Settings *settings);
+
+/* feed binary input to an existing Json_Parse_Callback, as if it came from
+ * json text: strings are handed out escaped and numbers as text. strings
+ * without anything to escape are views into the input; everything else is
+ * made up in parser->texts and stays valid until json_parser_reset.
+ *
+ * the parser's settings hold as they do for json text: .limits (but .memory,
+ * as in the core), .duplicates and .strict, with failures reported in .error.
+ * .bytes counts the binary input, .string the text json would hold between
+ * the quotes, and error offsets are bytes into the binary input, at the item
+ * that went over; input that isn't valid cbor or msgpack is
+ * JSON_ERROR_INVALID where decoding stopped. */
+ErrDecl json_parser_parse_pack(Json_Parser *parser, So input, Json_Pack_List format, Json_Parse_Callback callback, void *user);
+
+#define RLJSON_PACK_H
+#endif // RLJSON_PACK_H
+
@@ -0,0 +1,409 @@
+#include "rljson-patch.h"
+
+#define JSON_PATCH_KEY_FLAGS    (JSON_AUTO_FLAG_KEY_OWNED | JSON_AUTO_FLAG_KEY_DECODED)
+
+typedef struct Json_Patch {
+    So path;
+    So from;
+    So token;
+    So op;
+} Json_Patch;
+
+/* replace a value, the key it may be stored under stays */
+void json_patch_set(Json_Auto_Value *dst, Json_Auto_Value val) {
+    unsigned char key_flags = dst->flags & JSON_PATCH_KEY_FLAGS;
+    json_auto_free(dst);
+    *dst = val;
+    dst->flags = (val.flags & ~JSON_PATCH_KEY_FLAGS) | key_flags;
+}
+
+/* decoded text of a string value of the patch */
+bool json_patch_so(Json_Auto_Value *patch, So key, So *buf, So *out) {
+    Json_Auto_Value *val = json_auto_get(patch, key);
+    if(!val || val->id != JSON_AUTO_VALUE_STRING) return false;
+    if(val->flags & JSON_AUTO_FLAG_DECODED) {
+        *out = val->so;
+        return true;
+    }
+    so_clear(buf);
+    so_extend(buf, val->so);
+    *out = so_len(*buf) ? so_ll(so_it(*buf, 0), so_len(*buf)) : SO;
+    json_fix_so(*out, out);
+    return true;
+}
+
+/* split off the next reference token, resolving ~1 and ~0; any other ~
+ * (including one at the end of the token) makes the pointer invalid */
+bool json_pointer_next(So *pointer, So *buf, So *token) {
+    if(!pointer->len || *pointer->str != '/') return false;
+    so_shift(pointer, 1);
+    size_t len = 0;
+    while(len < pointer->len && pointer->str[len] != '/') ++len;
+    so_clear(buf);
+    for(size_t i = 0; i < len; ++i) {
+        char c = pointer->str[i];
+        if(c == '~') {
+            if(i + 1 >= len || (pointer->str[i + 1] != '0' && pointer->str[i + 1] != '1')) return false;
+            c = pointer->str[++i] == '0' ? '~' : '/';
+        }
+        so_push(buf, c);
+    }
+    so_shift(pointer, len);
+    *token = so_len(*buf) ? so_ll(so_it(*buf, 0), so_len(*buf)) : SO;
+    return true;
+}
+
+/* array index, no leading zeros; '-' is one past the end */
+bool json_pointer_index(Json_Auto_Value *autojson, So token, size_t *index) {
+    if(token.len == 1 && *token.str == '-') {
+        *index = json_auto_len(autojson);
+        return true;
+    }
+    if(!token.len || (token.len > 1 && *token.str == '0')) return false;
+    size_t result = 0;
+    for(size_t i = 0; i < token.len; ++i) {
+        if(token.str[i] < '0' || token.str[i] > '9') return false;
+        if(result > (SIZE_MAX - 9) / 10) return false;
+        result = result * 10 + (token.str[i] - '0');
+    }
+    *index = result;
+    return true;
+}
+
+/* one level down. without tmp whatever is below may get edited, so the level
+ * gets a private copy of itself first; with tmp it is only looked through, and
+ * a packed element gets copied into *tmp */
+Json_Auto_Value *json_pointer_step(Json_Auto_Value *autojson, So token, Json_Auto_Value *tmp) {
+    size_t index = 0;
+    if(tmp) autojson = json_auto_borrow(autojson);
+    else json_auto_materialize(autojson);
+    if(autojson->id == JSON_AUTO_VALUE_OBJECT) return json_auto_get(autojson, token);
+    if(!json_pointer_index(autojson, token, &index)) return 0;
+    if(tmp) return json_auto_element(autojson, index, tmp);
+    return autojson->id == JSON_AUTO_VALUE_ARRAY ? json_auto_at(autojson, index) : 0;
+}
+
+/* resolve everything but the last token, which is left in *token */
+Json_Auto_Value *json_pointer_parent(Json_Auto_Value *autojson, So pointer, So *buf, So *token) {
+    if(!json_pointer_next(&pointer, buf, token)) return 0;
+    while(pointer.len) {
+        autojson = json_pointer_step(autojson, *token, 0);
+        if(!autojson) return 0;
+        if(!json_pointer_next(&pointer, buf, token)) return 0;
+    }
+    return json_auto_materialize(autojson);
+}
+
+Json_Auto_Value *json_pointer_walk(Json_Auto_Value *autojson, So pointer, So *buf, Json_Auto_Value *tmp) {
+    So token = SO;
+    while(autojson && pointer.len) {
+        if(!json_pointer_next(&pointer, buf, &token)) autojson = 0;
+        else autojson = json_pointer_step(autojson, token, tmp);
+    }
+    return autojson;
+}
+
+/* the read-only lookup of test and copy, a packed element ends up in *tmp */
+Json_Auto_Value *json_pointer_find(Json_Patch *patch, Json_Auto_Value *autojson, So pointer, Json_Auto_Value *tmp) {
+    return json_pointer_walk(autojson, pointer, &patch->token, tmp);
+}
+
+Json_Auto_Value *json_auto_pointer(Json_Auto_Value *autojson, So pointer) {
+    ASSERT_ARG(autojson);
+    So buf = SO;
+    autojson = json_pointer_walk(autojson, pointer, &buf, 0);
+    so_free(&buf);
+    return autojson;
+}
+
+/* on failure val gets freed */
+ErrDecl json_patch_add(Json_Patch *patch, Json_Auto_Value *autojson, So path, Json_Auto_Value val) {
+    if(!path.len) {
+        json_patch_set(autojson, val);
+        return 0;
+    }
+    So token = SO;
+    Json_Auto_Value *parent = json_pointer_parent(autojson, path, &patch->token, &token);
+    if(parent && parent->id == JSON_AUTO_VALUE_OBJECT) {
+        So key = SO;
+        so_extend(&key, token);
+        val.flags |= JSON_PATCH_KEY_FLAGS;
+        if(!json_auto_dict_set(parent, key, val)) return 0;
+        so_free(&key);
+    } else if(parent && parent->id == JSON_AUTO_VALUE_ARRAY) {
+        size_t index = 0;
+        val.flags &= ~JSON_PATCH_KEY_FLAGS;
+        if(json_pointer_index(parent, token, &index) && !json_auto_arr_insert(parent, index, val)) return 0;
+    }
+    json_auto_free(&val);
+    return -1;
+}
+
+ErrDecl json_patch_remove(Json_Patch *patch, Json_Auto_Value *autojson, So path, Json_Auto_Value *out) {
+    So token = SO;
+    Json_Auto_Value *parent = json_pointer_parent(autojson, path, &patch->token, &token);
+    if(!parent) return -1;
+    if(parent->id == JSON_AUTO_VALUE_OBJECT) {
+        return json_auto_dict_remove(parent, token, out);
+    }
+    if(parent->id == JSON_AUTO_VALUE_ARRAY) {
+        size_t index = 0;
+        if(token.len == 1 && *token.str == '-') return -1;
+        if(!json_pointer_index(parent, token, &index)) return -1;
+        return json_auto_arr_remove(parent, index, out);
+    }
+    return -1;
+}
+
+ErrDecl json_patch_operation(Json_Patch *patch, Json_Auto_Value *autojson, Json_Auto_Value *operation) {
+    So op = SO, path = SO, from = SO;
+    if(!json_patch_so(operation, so("op"), &patch->op, &op)) return -1;
+    if(!json_patch_so(operation, so("path"), &patch->path, &path)) return -1;
+    Json_Auto_Value *value = json_auto_get(operation, so("value"));
+    if(!so_cmp(op, so("add"))) {
+        if(!value) return -1;
+        return json_patch_add(patch, autojson, path, json_auto_clone(value));
+    }
+    if(!so_cmp(op, so("remove"))) {
+        return json_patch_remove(patch, autojson, path, 0);
+    }
+    if(!so_cmp(op, so("replace"))) {
+        Json_Auto_Value *target = json_auto_pointer(autojson, path);
+        if(!value || !target) return -1;
+        json_patch_set(target, json_auto_clone(value));
+        return 0;
+    }
+    Json_Auto_Value tmp = {0};
+    if(!so_cmp(op, so("test"))) {
+        Json_Auto_Value *target = json_pointer_find(patch, autojson, path, &tmp);
+        if(!value || !target) return -1;
+        return json_auto_eq(target, value) ? 0 : -1;
+    }
+    if(!json_patch_so(operation, so("from"), &patch->from, &from)) return -1;
+    if(!so_cmp(op, so("copy"))) {
+        Json_Auto_Value *source = json_pointer_find(patch, autojson, from, &tmp);
+        if(!source) return -1;
+        return json_patch_add(patch, autojson, path, json_auto_clone(source));
+    }
+    if(!so_cmp(op, so("move"))) {
+        if(!so_cmp(from, path)) return json_pointer_find(patch, autojson, from, &tmp) ? 0 : -1;
+        /* can't move a value into one of its children */
+        if(path.len > from.len && !memcmp(path.str, from.str, from.len) && path.str[from.len] == '/') return -1;
+        Json_Auto_Value moved = {0};
+        if(!from.len || json_patch_remove(patch, autojson, from, &moved)) return -1;
+        return json_patch_add(patch, autojson, path, moved);
+    }
+    return -1;
+}
+
+ErrDecl json_auto_patch(Json_Auto_Value *autojson, Json_Auto_Value *patch) {
+    ASSERT_ARG(autojson);
+    ASSERT_ARG(patch);
+    int result = 0;
+    Json_Patch ctx = {0};
+    patch = json_auto_borrow(patch);
+    if(patch->id != JSON_AUTO_VALUE_ARRAY) return -1;
+    for(size_t i = 0; !result && i < json_auto_len(patch); ++i) {
+        result = json_patch_operation(&ctx, autojson, json_auto_at(patch, i));
+    }
+    so_free(&ctx.path);
+    so_free(&ctx.from);
+    so_free(&ctx.token);
+    so_free(&ctx.op);
+    return result;
+}
+
+ErrDecl json_auto_merge_patch(Json_Auto_Value *autojson, Json_Auto_Value *patch) {
+    ASSERT_ARG(autojson);
+    ASSERT_ARG(patch);
+    /* the patch is only read */
+    patch = json_auto_borrow(patch);
+    if(patch->id != JSON_AUTO_VALUE_OBJECT) {
+        json_patch_set(autojson, json_auto_clone(patch));
+        return 0;
+    }
+    if(json_auto_materialize(autojson)->id != JSON_AUTO_VALUE_OBJECT) {
+        json_patch_set(autojson, (Json_Auto_Value){ .id = JSON_AUTO_VALUE_OBJECT });
+    }
+    for(size_t i = 0; i < array_len(patch->dict); ++i) {
+        Json_Auto_Key_Value *kv = array_it(patch->dict, i);
+        So key = SO;
+        so_extend(&key, kv->key);
+        if(!(kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED)) json_fix_so(key, &key);
+        Json_Auto_Key_Value *target = json_auto_dict_find(autojson, key);
+        if(json_auto_borrow(&kv->val)->id == JSON_AUTO_VALUE_NULL) {
+            int removed = target ? json_auto_dict_remove(autojson, key, 0) : 0;
+            so_free(&key);
+            if(removed) return -1;
+        } else if(target) {
+            so_free(&key);
+            if(json_auto_merge_patch(&target->val, &kv->val)) return -1;
+        } else {
+            Json_Auto_Value val = {0};
+            if(json_auto_merge_patch(&val, &kv->val)) return -1;
+            val.flags |= JSON_PATCH_KEY_FLAGS;
+            if(json_auto_dict_set(autojson, key, val)) return -1;
+        }
+    }
+    return 0;
+}
+
+typedef struct Json_Diff {
+    So path;
+    size_t *slots; /* key index of every object level being diffed, stacked */
+    Json_Auto_Value *out;
+    bool confirm;
+} Json_Diff;
+
+void json_diff_value(Json_Diff *diff, Json_Auto_Value *a, Json_Auto_Value *b);
+
+void json_diff_path_key(So *path, So key, bool decoded) {
+    So fix = SO;
+    if(!decoded && key.len && memchr(key.str, '\\', key.len)) {
+        so_extend(&fix, key);
+        json_fix_so(fix, &key);
+    }
+    so_push(path, '/');
+    for(size_t i = 0; i < key.len; ++i) {
+        switch(key.str[i]) {
+            case '~': so_extend(path, so("~0")); break;
+            case '/': so_extend(path, so("~1")); break;
+            default: so_push(path, key.str[i]); break;
+        }
+    }
+    so_free(&fix);
+}
+
+void json_diff_op(Json_Diff *diff, So op, Json_Auto_Value *value) {
+    Json_Auto_Value result = { .id = JSON_AUTO_VALUE_OBJECT };
+    Json_Auto_Value val = {
+        .id = JSON_AUTO_VALUE_STRING,
+        .so = op,
+        .flags = JSON_AUTO_FLAG_DECODED | JSON_AUTO_FLAG_KEY_DECODED,
+    };
+    array_push(result.dict, ((Json_Auto_Key_Value){ .key = so("op"), .val = val }));
+    val.so = SO;
+    so_extend(&val.so, diff->path);
+    val.flags |= JSON_AUTO_FLAG_OWNED;
+    array_push(result.dict, ((Json_Auto_Key_Value){ .key = so("path"), .val = val }));
+    if(value) {
+        val = json_auto_clone(value);
+        val.flags |= JSON_AUTO_FLAG_KEY_DECODED;
+        array_push(result.dict, ((Json_Auto_Key_Value){ .key = so("value"), .val = val }));
+    }
+    array_push(diff->out->arr, result);
+}
+
+void json_diff_object(Json_Diff *diff, Json_Auto_Value *a, Json_Auto_Value *b) {
+    size_t n = array_len(b->dict);
+    size_t cap = 8;
+    while(cap < 2 * n) cap *= 2;
+    /* open addressing over the keys of b (index + 1), followed by n 'matched' marks */
+    size_t base = array_len(diff->slots);
+    array_resize(diff->slots, base + cap + n);
+    memset(array_it(diff->slots, base), 0, (cap + n) * sizeof(*diff->slots));
+    for(size_t j = 0; j < n; ++j) {
+        Json_Auto_Key_Value *kv = array_it(b->dict, j);
+        size_t slot = json_auto_hash_so(kv->key, kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED) & (cap - 1);
+        while(array_at(diff->slots, base + slot)) slot = (slot + 1) & (cap - 1);
+        array_at(diff->slots, base + slot) = j + 1;
+    }
+    size_t path_len = so_len(diff->path);
+    for(size_t i = 0; i < array_len(a->dict); ++i) {
+        Json_Auto_Key_Value *kv = array_it(a->dict, i);
+        bool decoded = kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED;
+        Json_Auto_Key_Value *other = 0;
+        size_t slot = json_auto_hash_so(kv->key, decoded) & (cap - 1);
+        for(size_t j; (j = array_at(diff->slots, base + slot)); slot = (slot + 1) & (cap - 1)) {
+            Json_Auto_Key_Value *candidate = array_it(b->dict, j - 1);
+            if(json_auto_so_cmp(kv->key, decoded, candidate->key, candidate->val.flags & JSON_AUTO_FLAG_KEY_DECODED)) continue;
+            array_at(diff->slots, base + cap + j - 1) = 1;
+            other = candidate;
+            break;
+        }
+        json_diff_path_key(&diff->path, kv->key, decoded);
+        if(other) json_diff_value(diff, &kv->val, &other->val);
+        else json_diff_op(diff, so("remove"), 0);
+        so_resize(&diff->path, path_len);
+    }
+    for(size_t j = 0; j < n; ++j) {
+        if(array_at(diff->slots, base + cap + j)) continue;
+        Json_Auto_Key_Value *kv = array_it(b->dict, j);
+        json_diff_path_key(&diff->path, kv->key, kv->val.flags & JSON_AUTO_FLAG_KEY_DECODED);
+        json_diff_op(diff, so("add"), &kv->val);
+        so_resize(&diff->path, path_len);
+    }
+    array_resize(diff->slots, base);
+}
+
+/* by the cached hashes; json_auto_eq confirms a match only when asked to */
+bool json_diff_same(Json_Diff *diff, Json_Auto_Value *a, Json_Auto_Value *b) {
+    if(json_auto_hash(a) != json_auto_hash(b)) return false;
+    return !diff->confirm || json_auto_eq(a, b);
+}
+
+/* packed arrays too, element by element */
+void json_diff_array(Json_Diff *diff, Json_Auto_Value *a, Json_Auto_Value *b) {
+    size_t na = json_auto_len(a), nb = json_auto_len(b), begin = 0;
+    Json_Auto_Value tmp_a, tmp_b;
+    /* skip the unchanged head and tail */
+    while(begin < na && begin < nb && json_diff_same(diff, json_auto_element(a, begin, &tmp_a), json_auto_element(b, begin, &tmp_b))) ++begin;
+    while(na > begin && nb > begin && json_diff_same(diff, json_auto_element(a, na - 1, &tmp_a), json_auto_element(b, nb - 1, &tmp_b))) {
+        --na;
+        --nb;
+    }
+    size_t path_len = so_len(diff->path);
+    for(size_t i = begin; i < na && i < nb; ++i) {
+        so_fmt(&diff->path, "/%zu", i);
+        json_diff_value(diff, json_auto_element(a, i, &tmp_a), json_auto_element(b, i, &tmp_b));
+        so_resize(&diff->path, path_len);
+    }
+    for(size_t i = nb; i < na; ++i) {
+        so_fmt(&diff->path, "/%zu", nb);
+        json_diff_op(diff, so("remove"), 0);
+        so_resize(&diff->path, path_len);
+    }
+    for(size_t i = na; i < nb; ++i) {
+        so_fmt(&diff->path, "/%zu", i);
+        json_diff_op(diff, so("add"), json_auto_element(b, i, &tmp_b));
+        so_resize(&diff->path, path_len);
+    }
+}
+
+bool json_diff_is_array(Json_Auto_Value *autojson) {
+    switch(autojson->id) {
+        case JSON_AUTO_VALUE_ARRAY:
+        case JSON_AUTO_VALUE_SIZES:
+        case JSON_AUTO_VALUE_DOUBLES: return true;
+        default: return false;
+    }
+}
+
+void json_diff_value(Json_Diff *diff, Json_Auto_Value *a, Json_Auto_Value *b) {
+    if(json_diff_same(diff, a, b)) return;
+    a = json_auto_borrow(a);
+    b = json_auto_borrow(b);
+    if(a->id == JSON_AUTO_VALUE_OBJECT && b->id == JSON_AUTO_VALUE_OBJECT) {
+        json_diff_object(diff, a, b);
+    } else if(json_diff_is_array(a) && json_diff_is_array(b)) {
+        json_diff_array(diff, a, b);
+    } else {
+        json_diff_op(diff, so("replace"), b);
+    }
+}
+
+void json_auto_diff_ext(Json_Auto_Value *a, Json_Auto_Value *b, Json_Auto_Value *out, bool confirm) {
+    ASSERT_ARG(a);
+    ASSERT_ARG(b);
+    ASSERT_ARG(out);
+    Json_Diff diff = { .out = out, .confirm = confirm };
+    *out = (Json_Auto_Value){ .id = JSON_AUTO_VALUE_ARRAY };
+    json_diff_value(&diff, a, b);
+    so_free(&diff.path);
+    array_free(diff.slots);
+}
+
+void json_auto_diff(Json_Auto_Value *a, Json_Auto_Value *b, Json_Auto_Value *out) {
+    json_auto_diff_ext(a, b, out, false);
+}
+
@@ -0,0 +1,35 @@
+#ifndef RLJSON_PATCH_H
+
+#include "rljson-auto.h"
+
+/* JSON Pointer (RFC 6901), JSON Patch (RFC 6902) and JSON Merge Patch
+ * (RFC 7396), applied in place on a Json_Auto_Value tree.
+ *
+ * only the paths named by the patch are visited (and, for lazy trees,
+ * parsed), so the cost follows the patch, not the document. values from the
+ * patch are copied into the document with owned strings, the patch can be
+ * freed right after. operations are applied one after another: when one of
+ * them fails, the ones before it stay applied. */
+
+/* the value to edit at pointer: every level on the way gets materialized, see
+ * json_auto_materialize. the test and copy operations only read. 0 when
+ * nothing is there, or the pointer is invalid (a ~ not followed by 0 or 1) */
+Json_Auto_Value *json_auto_pointer(Json_Auto_Value *autojson, So pointer); /* pointer is decoded */
+ErrDecl json_auto_patch(Json_Auto_Value *autojson, Json_Auto_Value *patch);
+ErrDecl json_auto_merge_patch(Json_Auto_Value *autojson, Json_Auto_Value *patch);
+
+/* the JSON Patch that turns a into b. subtrees with the same json_auto_hash
+ * are skipped, object members are matched by key, arrays by position after
+ * dropping their common head and tail. hashes stay cached in the trees (see
+ * json_auto_hash), so the first diff of a tree hashes all of it, later ones
+ * only what got edited since; beyond that, the work is scanning the levels
+ * that hold a difference, not the documents. equal hashes are taken as equal subtrees, which a 64 bit hash
+ * gets wrong about as rarely as it collides; with confirm, json_auto_eq
+ * checks every match, walking each skipped subtree (but those a and b
+ * share), which makes the diff cost as much as the documents again. */
+void json_auto_diff(Json_Auto_Value *a, Json_Auto_Value *b, Json_Auto_Value *out);
+void json_auto_diff_ext(Json_Auto_Value *a, Json_Auto_Value *b, Json_Auto_Value *out, bool confirm);
+
+#define RLJSON_PATCH_H
+#endif // RLJSON_PATCH_H
+
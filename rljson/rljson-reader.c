@@ -0,0 +1,142 @@
+#include <string.h>
+#include "rljson-reader.h"
+#include "rljson-valid.h"
+
+typedef enum {
+    JSON_READER_STATE_VALUE,    /* a value has to follow */
+    JSON_READER_STATE_FIRST,    /* right after '{' or '[' */
+    JSON_READER_STATE_KEY,      /* after ',' in an object */
+    JSON_READER_STATE_NEXT,     /* after a value: ',' or the end of the container */
+    JSON_READER_STATE_END,
+    JSON_READER_STATE_INVALID,
+} Json_Reader_State_List;
+
+void json_reader_init(Json_Reader *reader, So input, Json_Parse_Settings *settings) {
+    ASSERT_ARG(reader);
+    memset(reader, 0, sizeof(*reader));
+    reader->input = input;
+    reader->q.head = input;
+    reader->q.settings = settings ? *settings : JSON_PARSE_SETTINGS_DEFAULT;
+    reader->state = JSON_READER_STATE_VALUE;
+    if(reader->q.settings.error) *reader->q.settings.error = (Json_Parse_Error){0};
+    Json_Parse_Limits *limits = &reader->q.settings.limits;
+    if(limits->bytes && input.len > limits->bytes) {
+        reader->state = JSON_READER_STATE_INVALID;
+        if(reader->q.settings.error && !json_valid(input, &reader->q.settings)) {
+            *reader->q.settings.error = (Json_Parse_Error){ .code = JSON_ERROR_INVALID, .input = input };
+        }
+    }
+}
+
+static inline bool json_reader_object(Json_Reader *reader) {
+    size_t depth = reader->q.depth - 1;
+    return (reader->objects[depth / 64] >> (depth % 64)) & 1;
+}
+
+ErrDecl json_reader_next(Json_Reader *reader, Json_Reader_Event *event) {
+    ASSERT_ARG(reader);
+    ASSERT_ARG(event);
+    Json_Parse *q = &reader->q;
+    bool object = q->depth && json_reader_object(reader);
+    switch(reader->state) {
+        case JSON_READER_STATE_VALUE: goto value;
+        case JSON_READER_STATE_KEY: goto key;
+        case JSON_READER_STATE_FIRST: {
+            json_parse_ws(q);
+            if(json_parse_ch(q, object ? '}' : ']')) goto close;
+            if(object) goto key;
+            goto value;
+        }
+        case JSON_READER_STATE_NEXT: {
+            json_parse_ws(q);
+            if(!q->depth) {
+                if(q->head.len) goto invalid;
+                reader->state = JSON_READER_STATE_END;
+                goto end;
+            }
+            if(json_parse_ch(q, ',')) {
+                if(object) goto key;
+                goto value;
+            }
+            if(json_parse_ch(q, object ? '}' : ']')) goto close;
+            goto invalid;
+        }
+        case JSON_READER_STATE_END: goto end;
+        case JSON_READER_STATE_INVALID: return -1;
+        default: ABORT(ERR_UNREACHABLE("invalid switch: %u"), reader->state);
+    }
+
+key:
+    json_parse_ws(q);
+    if(!json_parse_string(q, &event->val.s)) goto invalid;
+    json_parse_ws(q);
+    if(!json_parse_ch(q, ':')) goto invalid;
+    event->id = JSON_READER_KEY;
+    event->val.id = JSON_STRING;
+    event->depth = q->depth;
+    reader->state = JSON_READER_STATE_VALUE;
+    return 0;
+
+value:
+    json_parse_ws(q);
+    if(!q->head.len) goto invalid;
+    if(q->settings.limits.nodes && ++reader->nodes > q->settings.limits.nodes) goto invalid;
+    switch(*q->head.str) {
+        case '{':
+        case '[': {
+            object = *q->head.str == '{';
+            if(q->depth + 1 >= JSON_DEPTH_MAX) goto invalid;
+            if(object) reader->objects[q->depth / 64] |= 1ull << (q->depth % 64);
+            else reader->objects[q->depth / 64] &= ~(1ull << (q->depth % 64));
+            event->id = object ? JSON_READER_OBJECT_BEGIN : JSON_READER_ARRAY_BEGIN;
+            event->val = (Json_Parse_Value){ .id = object ? JSON_OBJECT : JSON_ARRAY };
+            event->depth = q->depth++;
+            so_shift(&q->head, 1);
+            reader->state = JSON_READER_STATE_FIRST;
+            return 0;
+        }
+        case '"': {
+            if(!json_parse_string(q, &event->val.s)) goto invalid;
+            event->val.id = JSON_STRING;
+        } break;
+        case 't':
+        case 'f': {
+            if(!json_parse_bool(q, &event->val.b)) goto invalid;
+            event->val.id = JSON_BOOL;
+        } break;
+        case 'n': {
+            if(!json_parse_null(q)) goto invalid;
+            event->val.id = JSON_NULL;
+        } break;
+        default: {
+            if(!json_parse_number(q, &event->val.s)) goto invalid;
+            event->val.id = JSON_NUMBER;
+        } break;
+    }
+    if(!q->depth && q->settings.strict) goto invalid;
+    event->id = JSON_READER_VALUE;
+    event->depth = q->depth;
+    reader->state = JSON_READER_STATE_NEXT;
+    return 0;
+
+close:
+    event->id = object ? JSON_READER_OBJECT_END : JSON_READER_ARRAY_END;
+    event->val = (Json_Parse_Value){ .id = object ? JSON_OBJECT : JSON_ARRAY };
+    event->depth = --q->depth;
+    reader->state = JSON_READER_STATE_NEXT;
+    return 0;
+
+end:
+    event->id = JSON_READER_END;
+    event->val = (Json_Parse_Value){0};
+    event->depth = 0;
+    return 0;
+
+invalid:
+    reader->state = JSON_READER_STATE_INVALID;
+    /* like json_parser_parse: where and why is only worked out now */
+    if(q->settings.error && !json_valid(reader->input, &q->settings)) {
+        *q->settings.error = (Json_Parse_Error){ .code = JSON_ERROR_INVALID, .input = reader->input };
+    }
+    return -1;
+}
@@ -0,0 +1,49 @@
+#ifndef RLJSON_READER_H
+
+#include "rljson-core.h"
+
+/* pull parsing: instead of handing callbacks to the parser, ask it for one
+ * event after the other. built on the same scanners as json_parse, with the
+ * same decisions; nothing is allocated, so stopping early needs no cleanup.
+ *
+ *     Json_Reader reader;
+ *     Json_Reader_Event event;
+ *     json_reader_init(&reader, input, 0);
+ *     while(!json_reader_next(&reader, &event) && event.id != JSON_READER_END) { ... }
+ *
+ * keys and strings are raw views into the input, escapes included, like the
+ * callbacks get them. the reader keeps no keys, so .duplicates is not looked
+ * at: every member comes through. invalid input is only noticed when the reader gets
+ * there, after the events before it; settings->error then tells where.
+ * of the limits, .bytes, .nodes and .string are checked; .width would take a
+ * count per open container, so it is not. */
+
+typedef enum {
+    JSON_READER_OBJECT_BEGIN,
+    JSON_READER_OBJECT_END,
+    JSON_READER_ARRAY_BEGIN,
+    JSON_READER_ARRAY_END,
+    JSON_READER_KEY,    /* .val.s is the key */
+    JSON_READER_VALUE,  /* .val is a string, number, bool or null */
+    JSON_READER_END,    /* whole input read, and again on every further call */
+} Json_Reader_List;
+
+typedef struct Json_Reader_Event {
+    Json_Reader_List id;
+    Json_Parse_Value val;
+    size_t depth;       /* of the containers open around the event */
+} Json_Reader_Event;
+
+typedef struct Json_Reader {
+    Json_Parse q;
+    So input;
+    int state;
+    size_t nodes;       /* values so far, see Json_Parse_Limits */
+    uint64_t objects[JSON_DEPTH_MAX / 64]; /* one bit per open container */
+} Json_Reader;
+
+void json_reader_init(Json_Reader *reader, So input, Json_Parse_Settings *settings); /* 0 -> JSON_PARSE_SETTINGS_DEFAULT */
+ErrDecl json_reader_next(Json_Reader *reader, Json_Reader_Event *event);
+
+#define RLJSON_READER_H
+#endif // RLJSON_READER_H
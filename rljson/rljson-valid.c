@@ -0,0 +1,270 @@
+#include <string.h>
+#include "rljson-valid.h"
+
+#define JSON_VALID_ONES     0x0101010101010101ull
+#define JSON_VALID_HIGHS    0x8080808080808080ull
+#define JSON_VALID_WS       ((1ull << ' ') | (1ull << '\t') | (1ull << '\n') | (1ull << '\v') | (1ull << '\r'))
+
+/* high bit set in every byte of w that ends a plain run inside a string:
+ * '"', '\\', below ' ' or above 0x7f. borrows can only mark bytes above the
+ * first real one, so the lowest marked byte is always right */
+static inline uint64_t json_valid_special(uint64_t w) {
+    uint64_t quote = w ^ (JSON_VALID_ONES * '"');
+    uint64_t slash = w ^ (JSON_VALID_ONES * '\\');
+    return (((quote - JSON_VALID_ONES) & ~quote)
+          | ((slash - JSON_VALID_ONES) & ~slash)
+          | (w - JSON_VALID_ONES * ' ')
+          | w) & JSON_VALID_HIGHS;
+}
+
+static inline size_t json_valid_ws(const unsigned char *s, size_t len, size_t i) {
+    while(i < len && s[i] <= ' ' && ((JSON_VALID_WS >> s[i]) & 1)) ++i;
+    return i;
+}
+
+static inline bool json_valid_digit(unsigned char c) {
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline bool json_valid_hex(unsigned char c) {
+    return (unsigned char)(c - '0') < 10 || (unsigned char)((c | 0x20) - 'a') < 6;
+}
+
+/* s[*i] is the opening quote */
+static Json_Error_List json_valid_string(const unsigned char *s, size_t len, size_t *i, bool strict, bool surrogates) {
+    Json_Error_List code = JSON_ERROR_NONE;
+    size_t j = *i + 1;
+    for(;;) {
+        while(j + 8 <= len) {
+            uint64_t w;
+            memcpy(&w, s + j, 8);
+            uint64_t special = json_valid_special(w);
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            if(special) { j += (size_t)__builtin_ctzll(special) / 8; break; }
+#else
+            if(special) break;
+#endif
+            j += 8;
+        }
+        if(j >= len) { code = JSON_ERROR_UNTERMINATED_STRING; goto invalid; }
+        unsigned char c = s[j];
+        if(c == '"') break;
+        if(c >= ' ' && c < 0x80 && c != '\\') {
+            ++j;
+        } else if(c == '\\') {
+            if(j + 1 >= len) { code = JSON_ERROR_UNTERMINATED_STRING; goto invalid; }
+            switch(s[j + 1]) {
+                case '"': case '\\': case '/':
+                case 'b': case 'f': case 'n': case 'r': case 't': j += 2; break;
+                case 'u': {
+                    if(j + 6 > len || !json_valid_hex(s[j + 2]) || !json_valid_hex(s[j + 3])
+                            || !json_valid_hex(s[j + 4]) || !json_valid_hex(s[j + 5])) {
+                        code = JSON_ERROR_UNICODE_ESCAPE;
+                        goto invalid;
+                    }
+                    unsigned char unit = s[j + 3] | 0x20;
+                    if(surrogates && (s[j + 2] | 0x20) == 'd' && unit >= '8') {
+                        /* a high one needs a low one right after, which goes with it */
+                        if(!json_fix_unpaired(so_ll((const char *)s + j, len - j < 12 ? len - j : 12))) { code = JSON_ERROR_SURROGATE; goto invalid; }
+                        if(unit < 'c') j += 6;
+                    }
+                    j += 6;
+                } break;
+                default: code = JSON_ERROR_ESCAPE; goto invalid;
+            }
+        } else {
+            /* same rules as json_parse_string */
+            So_Uc_Point point = {0};
+            if(so_uc_point(so_ll((const char *)s + j, len - j), &point)) { code = JSON_ERROR_UTF8; goto invalid; }
+            if(point.val == '\n' || (point.val == '\t' && strict)) { code = JSON_ERROR_CONTROL_CHARACTER; goto invalid; }
+            j += point.bytes;
+        }
+    }
+    *i = j + 1;
+    return JSON_ERROR_NONE;
+invalid:
+    *i = j;
+    return code;
+}
+
+static bool json_valid_number(const unsigned char *s, size_t len, size_t *i) {
+    size_t j = *i;
+    if(s[j] == '-') ++j;
+    if(j < len && s[j] == '0') {
+        ++j;
+    } else if(j < len && (unsigned char)(s[j] - '1') < 9) {
+        while(++j < len && json_valid_digit(s[j])) {}
+    } else {
+        goto invalid;
+    }
+    if(j < len && s[j] == '.') {
+        if(++j >= len || !json_valid_digit(s[j])) goto invalid;
+        while(++j < len && json_valid_digit(s[j])) {}
+    }
+    if(j < len && (s[j] | 0x20) == 'e') {
+        if(++j < len && (s[j] == '+' || s[j] == '-')) ++j;
+        if(j >= len || !json_valid_digit(s[j])) goto invalid;
+        while(++j < len && json_valid_digit(s[j])) {}
+    }
+    *i = j;
+    return true;
+invalid:
+    *i = j;
+    return false;
+}
+
+static inline bool json_valid_literal(const unsigned char *s, size_t len, size_t *i, const char *literal, size_t n) {
+    if(len - *i < n || memcmp(s + *i, literal, n)) return false;
+    *i += n;
+    return true;
+}
+
+static const char *json_valid_expected[] = {
+    [JSON_ERROR_UNTERMINATED_STRING] = "'\"'",
+    [JSON_ERROR_ESCAPE] = "escape character",
+    [JSON_ERROR_UNICODE_ESCAPE] = "hex digit",
+    [JSON_ERROR_NUMBER] = "digit",
+};
+
+ErrDecl json_valid_ext(So input, Json_Parse_Settings *settings, Json_Parse_Keys *keys, size_t **widths_stack) {
+    ASSERT_ARG(settings);
+    ASSERT_ARG(keys);
+    ASSERT_ARG(widths_stack);
+    const unsigned char *s = (const unsigned char *)so_it0(input);
+    size_t len = so_len(input);
+    size_t i = 0;
+    size_t begin = 0;
+    size_t depth = 0;
+    uint64_t objects[JSON_DEPTH_MAX / 64] = {0}; /* one bit per open container */
+    Json_Error_List code = JSON_ERROR_NONE;
+    const char *expected = 0;
+    bool object = false;
+    size_t key = 0;
+    /* the one part that allocates, the keys of the open objects, in buffers
+     * of the caller that are left empty, not freed */
+    json_parse_keys_clear(keys);
+    bool unique = settings->duplicates == JSON_DUPLICATES_REJECT;
+    /* ... and the counts of the open containers, for .limits.width */
+    Json_Parse_Limits limits = settings->limits;
+    size_t *widths = *widths_stack;
+    array_resize(widths, 0);
+    size_t nodes = 0;
+    if(limits.bytes && len > limits.bytes) { i = limits.bytes; code = JSON_ERROR_LIMIT_BYTES; goto invalid; }
+
+value:
+    i = json_valid_ws(s, len, i);
+    begin = i;
+    if(i >= len) { code = JSON_ERROR_UNEXPECTED; expected = "value"; goto invalid; }
+    if(limits.nodes && ++nodes > limits.nodes) { code = JSON_ERROR_LIMIT_NODES; goto invalid; }
+    switch(s[i]) {
+        case '{': case '[': {
+            object = s[i] == '{';
+            if(depth + 1 >= JSON_DEPTH_MAX) { code = JSON_ERROR_DEPTH; goto invalid; }
+            if(object) objects[depth / 64] |= 1ull << (depth % 64);
+            else objects[depth / 64] &= ~(1ull << (depth % 64));
+            ++depth;
+            i = json_valid_ws(s, len, i + 1);
+            if(i < len && s[i] == (object ? '}' : ']')) {
+                ++i;
+                --depth;
+                goto next;
+            }
+            if(object && unique) json_parse_keys_enter(keys);
+            if(limits.width) array_push(widths, 1);
+            if(object) goto key;
+            goto value;
+        }
+        case '"': {
+            if((code = json_valid_string(s, len, &i, settings->strict, settings->reject_surrogates))) goto invalid;
+            if(limits.string && i - begin - 2 > limits.string) { i = begin; code = JSON_ERROR_LIMIT_STRING; goto invalid; }
+        } break;
+        case 't': {
+            if(!json_valid_literal(s, len, &i, "true", 4)) { code = JSON_ERROR_LITERAL; expected = "true"; goto invalid; }
+        } break;
+        case 'f': {
+            if(!json_valid_literal(s, len, &i, "false", 5)) { code = JSON_ERROR_LITERAL; expected = "false"; goto invalid; }
+        } break;
+        case 'n': {
+            if(!json_valid_literal(s, len, &i, "null", 4)) { code = JSON_ERROR_LITERAL; expected = "null"; goto invalid; }
+        } break;
+        case '-': case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9': {
+            if(!json_valid_number(s, len, &i)) { code = JSON_ERROR_NUMBER; goto invalid; }
+        } break;
+        default: code = JSON_ERROR_UNEXPECTED; expected = "value"; goto invalid;
+    }
+    if(!depth && settings->strict) { i = begin; code = JSON_ERROR_ROOT; expected = "object or array"; goto invalid; }
+
+next:
+    i = json_valid_ws(s, len, i);
+    if(!depth) goto end;
+    object = (objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1;
+    if(i < len && s[i] == ',') {
+        ++i;
+        if(limits.width && ++*array_itL(widths) > limits.width) {
+            i = json_valid_ws(s, len, i);
+            code = JSON_ERROR_LIMIT_WIDTH;
+            goto invalid;
+        }
+        if(object) goto key;
+        goto value;
+    }
+    if(i < len && s[i] == (object ? '}' : ']')) {
+        ++i;
+        --depth;
+        if(object && unique) json_parse_keys_leave(keys);
+        if(limits.width) array_pop(widths);
+        goto next;
+    }
+    code = JSON_ERROR_UNEXPECTED;
+    expected = object ? "',' or '}'" : "',' or ']'";
+    goto invalid;
+
+key:
+    i = json_valid_ws(s, len, i);
+    if(i >= len || s[i] != '"') { code = JSON_ERROR_UNEXPECTED; expected = "string"; goto invalid; }
+    key = i;
+    if((code = json_valid_string(s, len, &i, settings->strict, settings->reject_surrogates))) goto invalid;
+    size_t key_end = i;
+    if(limits.string && key_end - key - 2 > limits.string) { i = key; code = JSON_ERROR_LIMIT_STRING; goto invalid; }
+    i = json_valid_ws(s, len, i);
+    if(i >= len || s[i] != ':') { code = JSON_ERROR_UNEXPECTED; expected = "':'"; goto invalid; }
+    if(unique && !json_parse_keys_add(keys, so_ll((const char *)s + key + 1, key_end - key - 2), 0)) {
+        i = key;
+        code = JSON_ERROR_DUPLICATE_KEY;
+        goto invalid;
+    }
+    ++i;
+    goto value;
+
+end:
+    if(i < len) { code = JSON_ERROR_TRAILING; expected = "end of input"; goto invalid; }
+    json_parse_keys_clear(keys);
+    array_resize(widths, 0);
+    *widths_stack = widths;
+    return 0;
+invalid:
+    json_parse_keys_clear(keys);
+    array_resize(widths, 0);
+    *widths_stack = widths;
+    if(settings->error) {
+        if(code == JSON_ERROR_UNEXPECTED && i >= len) code = JSON_ERROR_END;
+        if(!expected && code < sizeof(json_valid_expected) / sizeof(*json_valid_expected)) expected = json_valid_expected[code];
+        *settings->error = (Json_Parse_Error){
+            .offset = i,
+            .code = code,
+            .expected = expected,
+            .input = input,
+        };
+    }
+    return -1;
+}
+
+ErrDecl json_valid(So input, Json_Parse_Settings *settings) {
+    Json_Parse_Keys keys = {0};
+    size_t *widths = 0;
+    int result = json_valid_ext(input, settings, &keys, &widths);
+    json_parse_keys_free(&keys);
+    array_free(widths);
+    return result;
+}
@@ -0,0 +1,24 @@
+#ifndef RLJSON_VALID_H
+
+#include "rljson-core.h"
+
+/* accept/reject only, without extracting any value.
+ *
+ * a separate engine from json_parse: one loop over the input with an explicit
+ * stack instead of recursion, plain string runs are skipped a word at a time.
+ * decisions are the same as json_parse_ext with the same settings (including
+ * JSON_DEPTH_MAX, which control characters strings may hold,
+ * JSON_DUPLICATES_REJECT and the limits). .verbose is ignored, json_parse_valid_ext falls back
+ * to the tracing parser for that.
+ * on failure settings->error, if set, tells where and why. */
+
+ErrDecl json_valid(So input, Json_Parse_Settings *settings);
+
+/* the same in the caller's buffers for the keys (JSON_DUPLICATES_REJECT) and
+ * the counts of the open containers (.limits.width), e.g. a Json_Parser's:
+ * they are left empty, not freed, and once grown checking no longer allocates */
+ErrDecl json_valid_ext(So input, Json_Parse_Settings *settings, Json_Parse_Keys *keys, size_t **widths);
+
+#define RLJSON_VALID_H
+#endif // RLJSON_VALID_H
+
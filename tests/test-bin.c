@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include "../rljson/rljson-bin.h"
+
+static const char *document =
+    "{\"meta\":{\"version\":1,\"name\":\"n\\u00e4me\"},"
+    "\"users\":[{\"id\":1,\"tags\":[\"a\",\"b\"]},{\"id\":2,\"tags\":[]},{\"id\":3,\"scores\":[0.5,1.5]}],"
+    "\"ids\":[1,2,3],\"empty\":{},\"s\\\"q\":\"x\\ny\",\"t\":true,\"n\":null}";
+
+/* through the accessors, every level */
+static size_t bin_walk(Json_Auto_Value *val) {
+    size_t n = 1;
+    for(size_t i = 0; i < json_auto_len(val); ++i) {
+        (void)json_auto_key(val, i);
+        n += bin_walk(json_auto_at(val, i));
+    }
+    return n;
+}
+
+/* a snapshot that loads has to be usable, whatever it holds; one that passes
+ * the full check has to load */
+static int bin_check(So bin, Json_Auto_Value *plain, bool intact) {
+    Json_Auto_Value json = {0};
+    bool checked = !json_auto_bin_check(bin);
+    if(intact && !checked) return -1;
+    if(json_auto_from_bin(bin, &json)) return checked ? -1 : 0;
+    int result = 0;
+    So out = SO;
+    json_auto_fmt(&out, json, &(Json_Auto_Fmt){0});
+    (void)json_auto_hash(&json);
+    bin_walk(&json);
+    if(intact && !json_auto_eq(&json, plain)) result = -1;
+    json_auto_free(&json);
+    so_free(&out);
+    return result;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    Json_Auto_Value plain = {0};
+    So bin = SO, broken = SO;
+    if(json_auto_parse(so_l(document), &plain)) ABORT("invalid document");
+    json_auto_fmt_bin(&bin, &plain);
+    if(bin_check(bin, &plain, true)) {
+        printff(F("INVALID", FG_RD_B) " snapshot does not read back");
+        status = 1;
+    }
+    ++n;
+
+    /* cut short anywhere */
+    for(size_t len = 0; len < so_len(bin); ++len, ++n) {
+        Json_Auto_Value json = {0};
+        if(!json_auto_from_bin(so_ll(so_it(bin, 0), len), &json)) {
+            printff(F("INVALID", FG_RD_B) " snapshot cut to %zu of %zu bytes loads", len, so_len(bin));
+            json_auto_free(&json);
+            status = 1;
+        }
+    }
+
+    /* any byte changed: rejected, or still safe to read */
+    unsigned char flips[] = { 0x01, 0x10, 0x80, 0xff };
+    for(size_t i = 0; i < so_len(bin); ++i) {
+        for(size_t j = 0; j < sizeof(flips); ++j, ++n) {
+            so_clear(&broken);
+            so_extend(&broken, bin);
+            *(unsigned char *)so_it(broken, i) ^= flips[j];
+            if(bin_check(broken, &plain, false)) status = 1;
+        }
+    }
+
+    /* an array that holds itself */
+    So self_bin = SO;
+    Json_Auto_Value nested = {0};
+    if(json_auto_parse(so("[[]]"), &nested)) ABORT("invalid document");
+    json_auto_fmt_bin(&self_bin, &nested);
+    json_auto_free(&nested);
+    /* the root node follows the 24 byte header, its block offset (.data) is at 16 */
+    uint64_t self = 0;
+    so_clear(&broken);
+    so_extend(&broken, self_bin);
+    memcpy(so_it(broken, 24 + 16), &self, sizeof(self));
+    if(bin_check(broken, &plain, false)) status = 1;
+    if(!json_auto_from_bin(broken, &nested)) {
+        printff(F("INVALID", FG_RD_B) " snapshot of an array holding itself loads");
+        json_auto_free(&nested);
+        status = 1;
+    }
+    ++n;
+
+    /* the same further down: loading only looks at the root, the level
+     * holding the array finds it and reads as null */
+    so_clear(&broken);
+    so_extend(&broken, self_bin);
+    /* the inner node is the root's block, right behind the root */
+    memcpy(so_it(broken, 24 + 24 + 16), &self, sizeof(self));
+    if(bin_check(broken, &plain, false)) status = 1;
+    if(!json_auto_bin_check(broken)) {
+        printff(F("INVALID", FG_RD_B) " snapshot of a nested array holding itself passes the check");
+        status = 1;
+    }
+    if(json_auto_from_bin(broken, &nested)) {
+        printff(F("INVALID", FG_RD_B) " snapshot with a corrupt nested array does not load");
+        status = 1;
+    } else {
+        if(json_auto_len(&nested) != 1 || json_auto_at(&nested, 0) || json_auto_materialize(&nested)->id != JSON_AUTO_VALUE_NULL) {
+            printff(F("INVALID", FG_RD_B) " corrupt level of a snapshot does not read as null");
+            status = 1;
+        }
+        json_auto_free(&nested);
+    }
+    so_free(&self_bin);
+    n += 2;
+
+    /* and from a file */
+    char path[] = "/tmp/rljson-test-bin-XXXXXX";
+    int fd = mkstemp(path);
+    if(fd < 0) ABORT("failed creating a temporary file");
+    close(fd);
+    Json_Auto_Bin loaded;
+    if(json_auto_save_bin(&plain, so_l(path)) || json_auto_load_bin(so_l(path), &loaded)) status = 1;
+    else if(!json_auto_eq(&loaded.root, &plain)) status = 1;
+    json_auto_bin_free(&loaded);
+    if(truncate(path, so_len(bin) / 2) || !json_auto_load_bin(so_l(path), &loaded)) status = 1;
+    unlink(path);
+    n += 2;
+
+    json_auto_free(&plain);
+    so_free(&bin);
+    so_free(&broken);
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu snapshot cases", n);
+    }
+    return status;
+}
@@ -0,0 +1,100 @@
+#include "../rljson/rljson-auto.h"
+
+typedef struct Canonical_Case {
+    const char *input;
+    const char *expect;
+} Canonical_Case;
+
+static Canonical_Case canonical_cases[] = {
+    /* RFC 8785, section 3.2.2 */
+    { "{\"numbers\": [333333333.33333329, 1E30, 4.50, 2e-3, 0.000000000000000000000000001],"
+      " \"string\": \"\\u20ac$\\u000F\\u000aA'\\u0042\\u0022\\u005c\\\\\\\"\\/\","
+      " \"literals\": [null, true, false]}",
+      "{\"literals\":[null,true,false],\"numbers\":[333333333.3333333,1e+30,4.5,0.002,1e-27],"
+      "\"string\":\"\xe2\x82\xac$\\u000f\\nA'B\\\"\\\\\\\\\\\"/\"}" },
+    /* RFC 8785, section 3.2.3: UTF-16 order */
+    { "{\"\\u20ac\": \"Euro Sign\", \"\\r\": \"Carriage Return\", \"\\ufb33\": \"Hebrew Letter Dalet With Dagesh\","
+      " \"1\": \"One\", \"\\ud83d\\ude00\": \"Emoji: Grinning Face\", \"\\u0080\": \"Control\","
+      " \"\\u00f6\": \"Latin Small Letter O With Diaeresis\"}",
+      "{\"\\r\":\"Carriage Return\",\"1\":\"One\",\"\xc2\x80\":\"Control\",\"\xc3\xb6\":\"Latin Small Letter O With Diaeresis\","
+      "\"\xe2\x82\xac\":\"Euro Sign\",\"\xf0\x9f\x98\x80\":\"Emoji: Grinning Face\",\"\xef\xac\xb3\":\"Hebrew Letter Dalet With Dagesh\"}" },
+    /* numbers, RFC 8785 appendix B */
+    { "[0.0, -0.0, 1e21, 1e20, 123456789012345680000, 0.000001, 1e-7, 5e-324, 1.7976931348623157e308, 0.1, -1.5e-9]",
+      "[0,0,1e+21,100000000000000000000,123456789012345680000,0.000001,1e-7,5e-324,1.7976931348623157e+308,0.1,-1.5e-9]" },
+    { " { \"b\" : [ ], \"a\" : { } } ", "{\"a\":{},\"b\":[]}" },
+    /* above 2^53 integers round, and hash as what they round to */
+    { "[9007199254740993, 18446744073709551615]", "[9007199254740992,18446744073709552000]" },
+};
+
+/* members in another order and numbers written differently hash the same */
+static const char *hash_equal[][2] = {
+    { "{\"a\":1,\"b\":[1.0,\"x\"]}", "{\"b\":[1,\"\\u0078\"],\"a\":1e0}" },
+    { "{\"a\":{\"c\":null,\"d\":true}}", "{\"a\":{\"d\":true,\"c\":null}}" },
+    { "[9007199254740993,-0.0]", "[9007199254740992.0,0]" },
+};
+
+static const char *hash_differ[][2] = {
+    { "[1,2]", "[2,1]" },
+    { "{\"a\":1}", "{\"a\":\"1\"}" },
+    { "{\"a\":1,\"b\":2}", "{\"a\":2,\"b\":1}" },
+    { "{}", "[]" },
+    { "\"ab\"", "\"ab\\u0000\"" },
+};
+
+static int test_canonical(Canonical_Case *c) {
+    int result = 0;
+    Json_Auto_Value json = {0}, again = {0};
+    So out = SO, out_again = SO;
+    if(json_auto_parse(so_l(c->input), &json)) ABORT("invalid input: %s", c->input);
+    json_auto_fmt_canonical(&out, &json);
+    if(so_cmp(out, so_l(c->expect))) result = -1;
+    /* canonical form is a fixed point */
+    if(json_auto_parse(out, &again)) result = -1;
+    json_auto_fmt_canonical(&out_again, &again);
+    if(so_cmp(out, out_again)) result = -1;
+    if(json_auto_hash(&json) != json_auto_hash(&again)) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " canonical: %s\n  got    %.*s\n  expect %s", c->input, SO_F(out), c->expect);
+    }
+    json_auto_free(&json);
+    json_auto_free(&again);
+    so_free(&out);
+    so_free(&out_again);
+    return result;
+}
+
+static int test_hash(const char *a, const char *b, bool equal) {
+    Json_Auto_Value ja = {0}, jb = {0};
+    if(json_auto_parse(so_l(a), &ja)) ABORT("invalid input: %s", a);
+    if(json_auto_parse(so_l(b), &jb)) ABORT("invalid input: %s", b);
+    int result = (json_auto_hash(&ja) == json_auto_hash(&jb)) == equal ? 0 : -1;
+    /* the hash follows json_auto_eq */
+    if(json_auto_eq(&ja, &jb) != equal) result = -1;
+    /* the second call comes from the cache */
+    if(json_auto_hash(&ja) != json_auto_hash(&ja)) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " hash: %s %s %s", a, equal ? "!=" : "==", b);
+    }
+    json_auto_free(&ja);
+    json_auto_free(&jb);
+    return result;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < sizeof(canonical_cases) / sizeof(*canonical_cases); ++i, ++n) {
+        if(test_canonical(&canonical_cases[i])) status = 1;
+    }
+    for(size_t i = 0; i < sizeof(hash_equal) / sizeof(*hash_equal); ++i, ++n) {
+        if(test_hash(hash_equal[i][0], hash_equal[i][1], true)) status = 1;
+    }
+    for(size_t i = 0; i < sizeof(hash_differ) / sizeof(*hash_differ); ++i, ++n) {
+        if(test_hash(hash_differ[i][0], hash_differ[i][1], false)) status = 1;
+    }
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu canonical forms and hashes", n);
+    }
+    return status;
+}
+
@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include "../rljson/rljson-columns.h"
+#include "../rljson/rljson-auto.h"
+
+static Json_Column_Spec spec[] = {
+    { {0}, JSON_COLUMN_SIZE },
+    { {0}, JSON_COLUMN_DOUBLE },
+    { {0}, JSON_COLUMN_BOOL },
+    { {0}, JSON_COLUMN_STRING },
+};
+
+/* the same row, worked out through a tree */
+static int test_row(Json_Columns *columns, size_t row, Json_Auto_Value *record) {
+    int result = 0;
+    for(size_t i = 0; i < array_len(columns->columns); ++i) {
+        Json_Column *column = array_it(columns->columns, i);
+        /* the last of repeated keys counts */
+        Json_Auto_Value *val = 0;
+        for(size_t j = 0; j < json_auto_len(record); ++j) {
+            if(!json_auto_so_cmp(json_auto_key(record, j), false, column->spec.key, true)) val = json_auto_at(record, j);
+        }
+        bool null = json_columns_null(column, row);
+        bool expect_null = true;
+        switch(column->spec.id) {
+            case JSON_COLUMN_SIZE: {
+                if(val && val->id == JSON_AUTO_VALUE_SIZE) {
+                    expect_null = false;
+                    if(column->sizes[row] != val->z) result = -1;
+                }
+                if(expect_null && column->sizes[row]) result = -1;
+            } break;
+            case JSON_COLUMN_DOUBLE: {
+                if(val && (val->id == JSON_AUTO_VALUE_SIZE || val->id == JSON_AUTO_VALUE_DOUBLE)) {
+                    expect_null = false;
+                    if(column->doubles[row] != (val->id == JSON_AUTO_VALUE_SIZE ? (double)val->z : val->f)) result = -1;
+                }
+                if(expect_null && column->doubles[row]) result = -1;
+            } break;
+            case JSON_COLUMN_BOOL: {
+                if(val && val->id == JSON_AUTO_VALUE_BOOL) {
+                    expect_null = false;
+                    if(column->bools[row] != val->b) result = -1;
+                }
+                if(expect_null && column->bools[row]) result = -1;
+            } break;
+            case JSON_COLUMN_STRING: {
+                if(val && val->id == JSON_AUTO_VALUE_STRING) {
+                    expect_null = false;
+                    if(so_cmp(column->strings[row], val->so)) result = -1;
+                }
+                if(expect_null && column->strings[row].len) result = -1;
+            } break;
+        }
+        if(null != expect_null) result = -1;
+    }
+    return result;
+}
+
+static int test_columns(const char *input, size_t rows) {
+    int result = 0;
+    Json_Columns columns;
+    Json_Auto_Value json = {0};
+    json_columns_init(&columns, spec, sizeof(spec) / sizeof(*spec));
+    if(json_columns_parse(&columns, so_l(input), 0)) result = -1;
+    if(json_auto_parse(so_l(input), &json)) ABORT("invalid input: %s", input);
+    if(columns.rows != rows || json_auto_len(&json) != rows) result = -1;
+    for(size_t i = 0; !result && i < rows; ++i) {
+        if(test_row(&columns, i, json_auto_at(&json, i))) result = -1;
+    }
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " columns: %s", input);
+    }
+    json_auto_free(&json);
+    json_columns_free(&columns);
+    return result;
+}
+
+static int test_reject(const char *input, size_t rows, size_t offset, Json_Error_List code) {
+    int result = 0;
+    Json_Columns columns;
+    Json_Parse_Error error = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.error = &error;
+    json_columns_init(&columns, spec, sizeof(spec) / sizeof(*spec));
+    if(!json_columns_parse(&columns, so_l(input), &settings)) result = -1;
+    if(columns.rows != rows || error.offset != offset || error.code != code) result = -1;
+    /* whole rows only */
+    for(size_t i = 0; i < array_len(columns.columns); ++i) {
+        Json_Column *column = array_it(columns.columns, i);
+        size_t len = 0;
+        switch(column->spec.id) {
+            case JSON_COLUMN_SIZE: len = array_len(column->sizes); break;
+            case JSON_COLUMN_DOUBLE: len = array_len(column->doubles); break;
+            case JSON_COLUMN_BOOL: len = array_len(column->bools); break;
+            case JSON_COLUMN_STRING: len = array_len(column->strings); break;
+        }
+        if(len != rows) result = -1;
+    }
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " columns reject: %s, %zu rows, %s at %zu", input, columns.rows, json_parse_error_str(error.code), error.offset);
+    }
+    json_columns_free(&columns);
+    return result;
+}
+
+static const char *values[] = {
+    "0", "17", "18446744073709551615", "-3", "2.5", "1e3", "true", "false", "null",
+    "\"text\"", "\"esc\\\"aped\"", "[]", "[1,{\"ts\":2}]", "{\"ts\":3}", "\"\"",
+};
+
+static const char *keys[] = {
+    "\"ts\"", "\"v\"", "\"on\"", "\"tag\"", "\"t\\u0073\"", "\"other\"", "\"\"",
+};
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    spec[0].key = so("ts");
+    spec[1].key = so("v");
+    spec[2].key = so("on");
+    spec[3].key = so("tag");
+
+    if(test_columns("[]", 0)) status = 1;
+    if(test_columns(" [ {} ] ", 1)) status = 1;
+    if(test_columns("[{\"ts\":1,\"v\":0.5,\"on\":true,\"tag\":\"a\"},{\"tag\":\"b\",\"on\":false,\"v\":-2,\"ts\":2}]", 2)) status = 1;
+    if(test_columns("[{\"ts\":1.5,\"v\":\"x\",\"on\":null,\"tag\":7}]", 1)) status = 1;
+    if(test_columns("[{\"ts\":1,\"ts\":{\"ts\":2}},{\"v\":[0.5],\"v\":0.25}]", 2)) status = 1;
+    if(test_columns("[{\"t\\u0073\":5,\"ta\\u0067\":\"\\u00e4\"}]", 1)) status = 1;
+    n += 6;
+
+    /* random records, more than one word of null bits */
+    srand(1);
+    for(size_t round = 0; round < 200; ++round, ++n) {
+        So input = SO;
+        size_t rows = (size_t)rand() % 150;
+        so_push(&input, '[');
+        for(size_t i = 0; i < rows; ++i) {
+            so_extend(&input, so_l(i ? ",{" : "{"));
+            size_t members = (size_t)rand() % 6;
+            for(size_t j = 0; j < members; ++j) {
+                so_fmt(&input, "%s%s:%s", j ? "," : "", keys[rand() % (sizeof(keys) / sizeof(*keys))],
+                        values[rand() % (sizeof(values) / sizeof(*values))]);
+            }
+            so_push(&input, '}');
+        }
+        so_push(&input, ']');
+        so_push(&input, 0);
+        if(test_columns(so_it0(input), rows)) status = 1;
+        so_free(&input);
+    }
+
+    if(test_reject("[1]", 0, 1, JSON_ERROR_UNEXPECTED)) status = 1;
+    if(test_reject("{\"ts\":1}", 0, 0, JSON_ERROR_UNEXPECTED)) status = 1;
+    if(test_reject("[{\"ts\":1}, [2]]", 1, 11, JSON_ERROR_UNEXPECTED)) status = 1;
+    if(test_reject("[{\"ts\":1},{\"ts\":2", 1, 17, JSON_ERROR_END)) status = 1;
+    n += 4;
+
+    /* rows add up over several inputs */
+    Json_Columns columns;
+    json_columns_init(&columns, spec, 1);
+    if(json_columns_parse(&columns, so("[{\"ts\":1}]"), 0)) status = 1;
+    if(json_columns_parse(&columns, so("[{\"ts\":2},{\"ts\":3}]"), 0)) status = 1;
+    if(columns.rows != 3 || columns.columns[0].sizes[2] != 3) status = 1;
+    json_columns_clear(&columns);
+    if(columns.rows || array_len(columns.columns[0].sizes)) status = 1;
+    json_columns_free(&columns);
+    ++n;
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu columnar cases", n);
+    }
+    return status;
+}
+
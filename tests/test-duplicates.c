@@ -0,0 +1,174 @@
+#include "../rljson/rljson-auto.h"
+#include "../rljson/rljson-valid.h"
+#include "../rljson/rljson-pack.h"
+
+typedef struct Duplicates_Case {
+    const char *input;
+    const char *first;  /* compact, as kept by JSON_DUPLICATES_FIRST */
+    const char *last;   /* ... and by JSON_DUPLICATES_LAST */
+    size_t offset;      /* where JSON_DUPLICATES_REJECT rejects, 0 -> accepted */
+} Duplicates_Case;
+
+static Duplicates_Case cases[] = {
+    { "{}", "{}", "{}", 0 },
+    { "{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":2}", "{\"a\":1,\"b\":2}", 0 },
+    { "{\"a\":1,\"a\":2}", "{\"a\":1}", "{\"a\":2}", 7 },
+    { "{\"a\":1,\"b\":2,\"a\":{\"c\":[1]}}", "{\"a\":1,\"b\":2}", "{\"a\":{\"c\":[1]},\"b\":2}", 13 },
+    { "{\"a\":[1],\"a\":{\"b\":1},\"a\":3}", "{\"a\":[1]}", "{\"a\":3}", 9 },
+    { "{\"a\":1, \"\\u0061\" :2}", "{\"a\":1}", "{\"a\":2}", 8 },
+    { "{\"a\\\"\":1,\"a\\u0022\":2}", "{\"a\\\"\":1}", "{\"a\\\"\":2}", 9 },
+    { "{\"a\":{\"a\":1},\"b\":{\"a\":2}}", "{\"a\":{\"a\":1},\"b\":{\"a\":2}}", "{\"a\":{\"a\":1},\"b\":{\"a\":2}}", 0 },
+    { "{\"a\":{\"x\":1,\"x\":2}}", "{\"a\":{\"x\":1}}", "{\"a\":{\"x\":2}}", 12 },
+    { "[{\"a\":1},{\"a\":2,\"b\":3,\"b\":4}]", "[{\"a\":1},{\"a\":2,\"b\":3}]", "[{\"a\":1},{\"a\":2,\"b\":4}]", 22 },
+    { "{\"a\":1,\"a\":[{\"b\":1,\"b\":[2]}]}", "{\"a\":1}", "{\"a\":[{\"b\":[2]}]}", 7 },
+    { "{\"\":1,\"\":2,\"x\":[{\"\":3}]}", "{\"\":1,\"x\":[{\"\":3}]}", "{\"\":2,\"x\":[{\"\":3}]}", 6 },
+    { "{\"a\":1,\"b\":{\"a\":2},\"c\":3,\"b\":4,\"a\":5}", "{\"a\":1,\"b\":{\"a\":2},\"c\":3}", "{\"a\":5,\"b\":4,\"c\":3}", 25 },
+};
+
+static int test_keep(Duplicates_Case *c, Json_Duplicates_List duplicates, const char *expect, bool insitu) {
+    int result = 0;
+    So out = SO, input = SO;
+    Json_Auto_Value json = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.duplicates = duplicates;
+    so_extend(&input, so_l(c->input));
+    int parsed = insitu ? json_auto_parse_insitu(input, &json, &settings) : json_auto_parse_lazy(input, &json, &settings);
+    if(parsed) result = -1;
+    json_auto_fmt(&out, json, &(Json_Auto_Fmt){0});
+    if(so_cmp(out, so_l(expect))) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " keep %s%s: %s -> %.*s, expect %s", duplicates == JSON_DUPLICATES_FIRST ? "first" : "last",
+                insitu ? " (in-situ)" : "", c->input, SO_F(out), expect);
+    }
+    json_auto_free(&json);
+    so_free(&out);
+    so_free(&input);
+    return result;
+}
+
+/* the same members as cbor, keys compared decoded */
+static int test_pack(Duplicates_Case *c) {
+    int result = 0;
+    Json_Auto_Value json = {0};
+    So pack = SO, out = SO;
+    if(json_auto_parse(so_l(c->input), &json)) ABORT("invalid input: %s", c->input);
+    json_auto_fmt_pack(&pack, &json, JSON_PACK_CBOR);
+    json_auto_free(&json);
+    Json_Parse_Error error = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.error = &error;
+    Json_Duplicates_List keep[] = { JSON_DUPLICATES_FIRST, JSON_DUPLICATES_LAST };
+    for(size_t i = 0; i < 2; ++i) {
+        settings.duplicates = keep[i];
+        so_clear(&out);
+        if(json_auto_from_pack_ext(pack, &json, JSON_PACK_CBOR, &settings)) result = -1;
+        json_auto_fmt(&out, json, &(Json_Auto_Fmt){0});
+        json_auto_free(&json);
+        if(so_cmp(out, so_l(i ? c->last : c->first))) result = -1;
+        /* and as events */
+        Json_Parser parser;
+        json_parser_init(&parser, &settings);
+        so_clear(&out);
+        json.id = c->input[0] == '{' ? JSON_AUTO_VALUE_OBJECT : JSON_AUTO_VALUE_ARRAY;
+        if(json_parser_parse_pack(&parser, pack, JSON_PACK_CBOR, json_auto_parse_value, &json)) result = -1;
+        json_auto_fmt(&out, json, &(Json_Auto_Fmt){0});
+        json_auto_free(&json);
+        json_parser_free(&parser);
+        if(so_cmp(out, so_l(i ? c->last : c->first))) result = -1;
+    }
+    settings.duplicates = JSON_DUPLICATES_REJECT;
+    int decoded = json_auto_from_pack_ext(pack, &json, JSON_PACK_CBOR, &settings);
+    json_auto_free(&json);
+    if(!decoded != !c->offset || (c->offset && error.code != JSON_ERROR_DUPLICATE_KEY)) result = -1;
+    Json_Parser parser;
+    json_parser_init(&parser, &settings);
+    int parsed = json_parser_parse_pack(&parser, pack, JSON_PACK_CBOR, 0, 0);
+    json_parser_free(&parser);
+    if(!parsed != !c->offset || (c->offset && error.code != JSON_ERROR_DUPLICATE_KEY)) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " as cbor: %s -> last kept %.*s, rejected %i %i", c->input, SO_F(out), decoded, parsed);
+    }
+    so_free(&pack);
+    so_free(&out);
+    return result;
+}
+
+/* the parser and the validator decide the same, and the error points at the key */
+static int test_reject(Duplicates_Case *c) {
+    int result = 0;
+    Json_Parse_Error error = {0}, error_valid = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.duplicates = JSON_DUPLICATES_REJECT;
+    settings.error = &error;
+    Json_Auto_Value json = {0};
+    int parsed = json_auto_parse_ext(so_l(c->input), &json, &settings);
+    json_auto_free(&json);
+    settings.error = &error_valid;
+    int valid = json_valid(so_l(c->input), &settings);
+    if(!parsed != !c->offset) result = -1;
+    if(!valid != !c->offset) result = -1;
+    if(c->offset) {
+        if(error.code != JSON_ERROR_DUPLICATE_KEY || error.offset != c->offset) result = -1;
+        if(error_valid.code != JSON_ERROR_DUPLICATE_KEY || error_valid.offset != c->offset) result = -1;
+    }
+    if(json_parse_valid(so_l(c->input))) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " reject: %s -> %i %s at %zu, valid %i %s at %zu, expect %zu", c->input,
+                parsed, json_parse_error_str(error.code), error.offset, valid, json_parse_error_str(error_valid.code), error_valid.offset, c->offset);
+    }
+    return result;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i, n += 6) {
+        if(test_keep(&cases[i], JSON_DUPLICATES_FIRST, cases[i].first, false)) status = 1;
+        if(test_keep(&cases[i], JSON_DUPLICATES_FIRST, cases[i].first, true)) status = 1;
+        if(test_keep(&cases[i], JSON_DUPLICATES_LAST, cases[i].last, false)) status = 1;
+        if(test_keep(&cases[i], JSON_DUPLICATES_LAST, cases[i].last, true)) status = 1;
+        if(test_reject(&cases[i])) status = 1;
+        if(test_pack(&cases[i])) status = 1;
+    }
+
+    /* one wide object, then many small ones through the same parser */
+    So wide = SO, many = SO;
+    so_push(&wide, '{');
+    for(size_t i = 0; i < 100000; ++i) so_fmt(&wide, "%s\"key %zu\":%zu", i ? "," : "", i * 7919 % 100003, i);
+    so_push(&wide, '}');
+    so_push(&many, '[');
+    for(size_t i = 0; i < 20000; ++i) so_fmt(&many, "%s{\"a\":%zu,\"b\":{\"a\":1},\"c\":[]}", i ? "," : "", i);
+    so_push(&many, ']');
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.duplicates = JSON_DUPLICATES_REJECT;
+    Json_Parser parser;
+    json_parser_init(&parser, &settings);
+    for(size_t round = 0; round < 2; ++round, n += 2) {
+        Json_Auto_Value json = {0};
+        if(json_auto_parse_parser(&parser, wide, &json) || json_auto_len(&json) != 100000) status = 1;
+        json_auto_free(&json);
+        if(json_auto_parse_parser(&parser, many, &json) || json_auto_len(&json) != 20000) status = 1;
+        json_auto_free(&json);
+        json_parser_reset(&parser);
+    }
+    /* the last key repeats the first */
+    so_resize(&wide, so_len(wide) - 1);
+    so_extend(&wide, so(",\"key 0\":7}"));
+    Json_Auto_Value json = {0};
+    if(!json_auto_parse_parser(&parser, wide, &json)) status = 1;
+    json_auto_free(&json);
+    if(!json_valid(wide, &settings)) status = 1;
+    settings.duplicates = JSON_DUPLICATES_LAST;
+    if(json_auto_parse_ext(wide, &json, &settings) || json_auto_len(&json) != 100000 || json_auto_at(&json, 0)->z != 7) status = 1;
+    json_auto_free(&json);
+    n += 3;
+    json_parser_free(&parser);
+    so_free(&wide);
+    so_free(&many);
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu duplicate key cases", n);
+    }
+    return status;
+}
+
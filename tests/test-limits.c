@@ -0,0 +1,212 @@
+#include "../rljson/rljson-auto.h"
+#include "../rljson/rljson-valid.h"
+#include "../rljson/rljson-reader.h"
+#include "../rljson/rljson-pack.h"
+
+typedef struct Limits_Case {
+    const char *input;
+    Json_Parse_Limits limits;
+    Json_Error_List code;   /* JSON_ERROR_NONE -> accepted */
+    size_t offset;
+} Limits_Case;
+
+static Limits_Case cases[] = {
+    { "[1,2,3]", { .bytes = 7 }, JSON_ERROR_NONE, 0 },
+    { "[1,2,3] ", { .bytes = 7 }, JSON_ERROR_LIMIT_BYTES, 7 },
+    { "[1,2,3]", { .nodes = 4 }, JSON_ERROR_NONE, 0 },
+    { "[1,2,3]", { .nodes = 3 }, JSON_ERROR_LIMIT_NODES, 5 },
+    { "{\"a\":[],\"b\":{},\"c\":null}", { .nodes = 4 }, JSON_ERROR_NONE, 0 },
+    { "{\"a\":[],\"b\":{},\"c\":null}", { .nodes = 3 }, JSON_ERROR_LIMIT_NODES, 19 },
+    { "[[[[1]]]]", { .nodes = 3 }, JSON_ERROR_LIMIT_NODES, 3 },
+    { "\"x\"", { .nodes = 1 }, JSON_ERROR_NONE, 0 },
+    { "[1,2,3]", { .width = 3 }, JSON_ERROR_NONE, 0 },
+    { "[1,2,3,4]", { .width = 3 }, JSON_ERROR_LIMIT_WIDTH, 7 },
+    { "[[1,2],[1,2,3], 1]", { .width = 2 }, JSON_ERROR_LIMIT_WIDTH, 12 },
+    { "[[1,2],[1,2], 1]", { .width = 2 }, JSON_ERROR_LIMIT_WIDTH, 14 },
+    { "{\"a\":1,\"b\":2, \"c\":3}", { .width = 2 }, JSON_ERROR_LIMIT_WIDTH, 14 },
+    { "{\"a\":{\"b\":2},\"c\":[3,4]}", { .width = 2 }, JSON_ERROR_NONE, 0 },
+    { "[\"abc\",\"abcd\"]", { .string = 3 }, JSON_ERROR_LIMIT_STRING, 7 },
+    { "[\"abc\",\"\\u00e4\"]", { .string = 3 }, JSON_ERROR_LIMIT_STRING, 7 },
+    { "{\"abc\":\"abc\"}", { .string = 3 }, JSON_ERROR_NONE, 0 },
+    { "{\"abc\":1,\"abcd\":2}", { .string = 3 }, JSON_ERROR_LIMIT_STRING, 9 },
+    { "[1,2,3,[4,5]]", { .nodes = 7, .width = 4, .string = 1, .bytes = 13 }, JSON_ERROR_NONE, 0 },
+};
+
+/* the same document as cbor decides the same, with the same error (at an
+ * offset of its own). .bytes counts other bytes, and .string the text json
+ * would hold, which is the input's only without escapes */
+static int test_pack(Limits_Case *c) {
+    if(c->limits.bytes || strchr(c->input, '\\')) return 0;
+    int result = 0;
+    Json_Parse_Error error = {0}, error_events = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    Json_Auto_Value json = {0};
+    So pack = SO;
+    if(json_auto_parse(so_l(c->input), &json)) ABORT("invalid input: %s", c->input);
+    json_auto_fmt_pack(&pack, &json, JSON_PACK_CBOR);
+    json_auto_free(&json);
+    settings.limits = c->limits;
+    settings.error = &error;
+    int decoded = json_auto_from_pack_ext(pack, &json, JSON_PACK_CBOR, &settings);
+    json_auto_free(&json);
+    settings.error = &error_events;
+    Json_Parser parser;
+    json_parser_init(&parser, &settings);
+    int parsed = json_parser_parse_pack(&parser, pack, JSON_PACK_CBOR, 0, 0);
+    json_parser_free(&parser);
+    bool accept = c->code == JSON_ERROR_NONE;
+    if(!decoded != accept || !parsed != accept) result = -1;
+    if(!accept && (error.code != c->code || error_events.code != c->code)) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " limits, as cbor: %s -> %i %s, events %i %s, expect %s", c->input,
+                decoded, json_parse_error_str(error.code), parsed, json_parse_error_str(error_events.code), json_parse_error_str(c->code));
+    }
+    so_free(&pack);
+    return result;
+}
+
+/* the parser, the validator and (but for .width) the reader decide the same,
+ * with the same error */
+static int test_case(Limits_Case *c) {
+    int result = 0;
+    Json_Parse_Error error = {0}, error_valid = {0}, error_reader = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.limits = c->limits;
+    settings.error = &error;
+    Json_Auto_Value json = {0};
+    int parsed = json_auto_parse_ext(so_l(c->input), &json, &settings);
+    json_auto_free(&json);
+    settings.error = &error_valid;
+    int valid = json_valid(so_l(c->input), &settings);
+    bool accept = c->code == JSON_ERROR_NONE;
+    if(!parsed != accept || !valid != accept) result = -1;
+    if(!accept && (error.code != c->code || error.offset != c->offset)) result = -1;
+    if(!accept && (error_valid.code != c->code || error_valid.offset != c->offset)) result = -1;
+    if(!c->limits.width) {
+        Json_Reader reader;
+        Json_Reader_Event event;
+        settings.error = &error_reader;
+        json_reader_init(&reader, so_l(c->input), &settings);
+        int read = 0;
+        while(!(read = json_reader_next(&reader, &event)) && event.id != JSON_READER_END) {}
+        if(!read != accept) result = -1;
+        if(!accept && (error_reader.code != c->code || error_reader.offset != c->offset)) result = -1;
+    }
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " limits: %s -> %i %s at %zu, valid %i %s at %zu, expect %s at %zu", c->input,
+                parsed, json_parse_error_str(error.code), error.offset, valid, json_parse_error_str(error_valid.code), error_valid.offset,
+                json_parse_error_str(c->code), c->offset);
+    }
+    return result;
+}
+
+/* many small values, the kind of input the limits are for */
+static int test_memory(So input, size_t values) {
+    int result = 0;
+    Json_Parse_Error error = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.error = &error;
+    Json_Auto_Value json = {0};
+    /* enough for all of them */
+    settings.limits.memory = values * JSON_AUTO_NODE_BYTES;
+    if(json_auto_parse_ext(input, &json, &settings)) result = -1;
+    json_auto_free(&json);
+    if(json_auto_parse_lazy(input, &json, &settings)) result = -1;
+    json_auto_free(&json);
+    /* one too few */
+    settings.limits.memory = (values - 1) * JSON_AUTO_NODE_BYTES;
+    if(!json_auto_parse_ext(input, &json, &settings) || error.code != JSON_ERROR_LIMIT_MEMORY) result = -1;
+    json_auto_free(&json);
+    if(!json_auto_parse_lazy(input, &json, &settings) || error.code != JSON_ERROR_LIMIT_MEMORY) result = -1;
+    json_auto_free(&json);
+    /* the tighter limit is the one reported */
+    settings.limits.nodes = values / 2;
+    if(!json_auto_parse_ext(input, &json, &settings) || error.code != JSON_ERROR_LIMIT_NODES) result = -1;
+    json_auto_free(&json);
+    /* the parser gets its own settings back */
+    settings.limits.nodes = 0;
+    Json_Parser parser;
+    json_parser_init(&parser, &settings);
+    if(!json_auto_parse_parser(&parser, input, &json) || error.code != JSON_ERROR_LIMIT_MEMORY) result = -1;
+    json_auto_free(&json);
+    if(parser.settings.limits.nodes || parser.settings.limits.memory != settings.limits.memory) result = -1;
+    json_parser_free(&parser);
+    /* the core alone has no tree to measure */
+    if(json_valid(input, &settings)) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " memory limit: %zu values, %s at %zu", values, json_parse_error_str(error.code), error.offset);
+    }
+    return result;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < sizeof(cases) / sizeof(*cases); ++i, n += 2) {
+        if(test_case(&cases[i])) status = 1;
+        if(test_pack(&cases[i])) status = 1;
+    }
+
+    /* binary input is held to the limits and duplicates of the settings too */
+    So dup = so("{\"a\":1,\"a\":2}");
+    So cbor = so("\xa2\x61\x61\x01\x61\x61\x02");
+    struct { Json_Parse_Limits limits; Json_Error_List code; size_t offset; } strict[] = {
+        { { .nodes = 3, .width = 2, .bytes = 4 }, JSON_ERROR_LIMIT_BYTES, 4 },
+        { { .nodes = 1 }, JSON_ERROR_LIMIT_NODES, 3 },
+        { { .width = 1 }, JSON_ERROR_LIMIT_WIDTH, 4 },
+        { { 0 }, JSON_ERROR_DUPLICATE_KEY, 4 },
+    };
+    for(size_t i = 0; i < sizeof(strict) / sizeof(*strict); ++i, ++n) {
+        Json_Parse_Error error = {0}, error_events = {0};
+        Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+        settings.limits = strict[i].limits;
+        settings.duplicates = JSON_DUPLICATES_REJECT;
+        settings.error = &error;
+        Json_Auto_Value json = {0};
+        if(!json_auto_parse_ext(dup, &json, &settings)) status = 1;
+        json_auto_free(&json);
+        if(!json_auto_from_pack_ext(cbor, &json, JSON_PACK_CBOR, &settings)) status = 1;
+        json_auto_free(&json);
+        settings.error = &error_events;
+        Json_Parser parser;
+        json_parser_init(&parser, &settings);
+        if(!json_parser_parse_pack(&parser, cbor, JSON_PACK_CBOR, 0, 0)) status = 1;
+        json_parser_free(&parser);
+        if(error.code != strict[i].code || error.offset != strict[i].offset
+                || error_events.code != strict[i].code || error_events.offset != strict[i].offset) {
+            printff(F("INVALID", FG_RD_B) " cbor with limits: %s at %zu, events %s at %zu, expect %s at %zu",
+                    json_parse_error_str(error.code), error.offset, json_parse_error_str(error_events.code), error_events.offset,
+                    json_parse_error_str(strict[i].code), strict[i].offset);
+            status = 1;
+        }
+    }
+
+    So input = SO;
+    so_push(&input, '[');
+    for(size_t i = 0; i < 100000; ++i) so_fmt(&input, "%s%zu", i ? "," : "", i % 10);
+    so_push(&input, ']');
+    if(test_memory(input, 100001)) status = 1;
+    so_clear(&input);
+    so_extend(&input, so("{\"a\":[{\"b\":null},{}],\"c\":\"d\"}"));
+    if(test_memory(input, 6)) status = 1;
+    n += 2;
+
+    /* the same parser, one document over and one within */
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.limits.nodes = 4;
+    Json_Parser parser;
+    json_parser_init(&parser, &settings);
+    Json_Auto_Value json = {0};
+    if(!json_auto_parse_parser(&parser, so("[1,2,3,4]"), &json)) status = 1;
+    json_auto_free(&json);
+    if(json_auto_parse_parser(&parser, so("[1,2,3]"), &json) || json_auto_len(&json) != 3) status = 1;
+    json_auto_free(&json);
+    json_parser_free(&parser);
+    ++n;
+    so_free(&input);
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu limit cases", n);
+    }
+    return status;
+}
@@ -0,0 +1,173 @@
+#include "../rljson/rljson-pack.h"
+
+typedef struct Pack_Case {
+    Json_Pack_List format;
+    const char *bytes;
+    size_t len;
+    const char *expect; /* 0 -> has to be rejected */
+} Pack_Case;
+
+#define PACK_CASE(format, bytes, expect)    { format, bytes, sizeof(bytes) - 1, expect }
+
+static Pack_Case pack_cases[] = {
+    /* RFC 8949, appendix A */
+    PACK_CASE(JSON_PACK_CBOR, "\x00", "0"),
+    PACK_CASE(JSON_PACK_CBOR, "\x18\x64", "100"),
+    PACK_CASE(JSON_PACK_CBOR, "\x1b\x00\x00\x00\xe8\xd4\xa5\x10\x00", "1000000000000"),
+    PACK_CASE(JSON_PACK_CBOR, "\x39\x03\xe7", "-1000"),
+    PACK_CASE(JSON_PACK_CBOR, "\xf9\x3c\x00", "1.0"),
+    PACK_CASE(JSON_PACK_CBOR, "\xf9\x7b\xff", "65504.0"),
+    PACK_CASE(JSON_PACK_CBOR, "\xf9\x00\x01", "5.960464477539063e-8"),
+    PACK_CASE(JSON_PACK_CBOR, "\xfa\x47\xc3\x50\x00", "100000.0"),
+    PACK_CASE(JSON_PACK_CBOR, "\xfb\x3f\xf1\x99\x99\x99\x99\x99\x9a", "1.1"),
+    PACK_CASE(JSON_PACK_CBOR, "\xf9\x7c\x00", 0),
+    PACK_CASE(JSON_PACK_CBOR, "\xf4", "false"),
+    PACK_CASE(JSON_PACK_CBOR, "\xf6", "null"),
+    PACK_CASE(JSON_PACK_CBOR, "\xf7", 0),
+    PACK_CASE(JSON_PACK_CBOR, "\xc1\x1a\x51\x4b\x67\xb0", "1363896240"),
+    PACK_CASE(JSON_PACK_CBOR, "\x44\x01\x02\x03\x04", 0),
+    PACK_CASE(JSON_PACK_CBOR, "\x62\x22\x5c", "\"\\\"\\\\\""),
+    PACK_CASE(JSON_PACK_CBOR, "\x62\xc3\xa4", "\"\xc3\xa4\""),
+    PACK_CASE(JSON_PACK_CBOR, "\x62\xc3\x28", 0),
+    PACK_CASE(JSON_PACK_CBOR, "\x83\x01\x82\x02\x03\x82\x04\x05", "[1,[2,3],[4,5]]"),
+    PACK_CASE(JSON_PACK_CBOR, "\xa2\x61\x61\x01\x61\x62\x82\x02\x03", "{\"a\":1,\"b\":[2,3]}"),
+    PACK_CASE(JSON_PACK_CBOR, "\xa1\x01\x02", 0),
+    PACK_CASE(JSON_PACK_CBOR, "\x9f\x01\x82\x02\x03\x9f\x04\x05\xff\xff", "[1,[2,3],[4,5]]"),
+    PACK_CASE(JSON_PACK_CBOR, "\xbf\x63\x46\x75\x6e\xf5\x63\x41\x6d\x74\x21\xff", "{\"Fun\":true,\"Amt\":-2}"),
+    PACK_CASE(JSON_PACK_CBOR, "\x7f\x61\x61\xff", 0),
+    PACK_CASE(JSON_PACK_CBOR, "\x9f\x01", 0),
+    PACK_CASE(JSON_PACK_CBOR, "\x9b\xff\xff\xff\xff\xff\xff\xff\xff\x01", 0),
+    PACK_CASE(JSON_PACK_CBOR, "\x01\x02", 0),
+    /* msgpack spec */
+    PACK_CASE(JSON_PACK_MSGPACK, "\x7f", "127"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xff", "-1"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xd0\x80", "-128"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xd3\xff\xff\xff\xff\xff\xff\xfc\x18", "-1000"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xcd\x01\x00", "256"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xcb\x3f\xf1\x99\x99\x99\x99\x99\x9a", "1.1"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xc3", "true"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xa3\x61\x62\x63", "\"abc\""),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xd9\x01\x78", "\"x\""),
+    PACK_CASE(JSON_PACK_MSGPACK, "\x92\x01\x91\xc0", "[1,[null]]"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xdc\x00\x01\x02", "[2]"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\x81\xa1\x6b\x80", "{\"k\":{}}"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\x81\x01\x02", 0),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xc4\x01\x00", 0),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xdd\xff\xff\xff\xff", 0),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xa5\x61", 0),
+    PACK_CASE(JSON_PACK_MSGPACK, "\x81\xa1\x80\xc0", 0),
+};
+
+/* the text the callbacks get for a number, as json would have written it */
+static Pack_Case number_cases[] = {
+    PACK_CASE(JSON_PACK_CBOR, "\x00", "0"),
+    PACK_CASE(JSON_PACK_CBOR, "\x17", "23"),
+    PACK_CASE(JSON_PACK_CBOR, "\x1b\xff\xff\xff\xff\xff\xff\xff\xff", "18446744073709551615"),
+    PACK_CASE(JSON_PACK_CBOR, "\x20", "-1"),
+    PACK_CASE(JSON_PACK_CBOR, "\x39\x03\xe7", "-1000"),
+    PACK_CASE(JSON_PACK_CBOR, "\x3b\x7f\xff\xff\xff\xff\xff\xff\xff", "-9223372036854775808"),
+    PACK_CASE(JSON_PACK_CBOR, "\x3b\xff\xff\xff\xff\xff\xff\xff\xff", "-18446744073709551616"),
+    PACK_CASE(JSON_PACK_CBOR, "\xfb\x3f\xf1\x99\x99\x99\x99\x99\x9a", "1.1000000000000001"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xd3\x80\x00\x00\x00\x00\x00\x00\x00", "-9223372036854775808"),
+    PACK_CASE(JSON_PACK_MSGPACK, "\xcf\x00\x00\x00\x00\x00\x01\x00\x00", "65536"),
+};
+
+/* a value at the root comes as the key */
+void *number_text(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    so_clear(*(So **)user);
+    so_extend(*(So **)user, val ? val->s : key.s);
+    return number_text;
+}
+
+static int test_number(Pack_Case *c) {
+    Json_Parser parser;
+    So text = SO;
+    json_parser_init(&parser, 0);
+    int result = json_parser_parse_pack(&parser, so_ll(c->bytes, c->len), c->format, number_text, &text);
+    if(result || so_cmp(text, so_l(c->expect))) {
+        printff(F("INVALID", FG_RD_B) " number text '%.*s', expect %s", SO_F(text), c->expect);
+        result = -1;
+    }
+    json_parser_free(&parser);
+    so_free(&text);
+    return result;
+}
+
+static int test_pack(Pack_Case *c) {
+    int result = 0;
+    Json_Auto_Value json = {0}, expect = {0};
+    So input = so_ll(c->bytes, c->len);
+    int decoded = json_auto_from_pack(input, &json, c->format);
+    if(!c->expect) {
+        if(!decoded) result = -1;
+    } else {
+        if(json_auto_parse(so_l(c->expect), &expect)) ABORT("invalid expectation: %s", c->expect);
+        if(decoded || !json_auto_eq(&json, &expect)) result = -1;
+        /* and back again */
+        So pack = SO;
+        Json_Auto_Value again = {0};
+        json_auto_fmt_pack(&pack, &expect, c->format);
+        if(json_auto_from_pack(pack, &again, c->format) || !json_auto_eq(&again, &expect)) result = -1;
+        json_auto_free(&again);
+        so_free(&pack);
+    }
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " %s case, expect %s", c->format == JSON_PACK_CBOR ? "cbor" : "msgpack", c->expect ? c->expect : "rejection");
+    }
+    json_auto_free(&json);
+    json_auto_free(&expect);
+    return result;
+}
+
+typedef struct Pack_Events {
+    size_t strings;
+    size_t numbers;
+    So kept;
+} Pack_Events;
+
+/* keeps a string around past the callback, like examples/readme.c does */
+void *pack_events(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    Pack_Events *events = *(Pack_Events **)user;
+    if(!val) return pack_events;
+    if(val->id == JSON_STRING) {
+        ++events->strings;
+        if(key.id == JSON_OBJECT && !so_cmp(key.s, so("keep"))) events->kept = val->s;
+    }
+    if(val->id == JSON_NUMBER) ++events->numbers;
+    return pack_events;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < sizeof(pack_cases) / sizeof(*pack_cases); ++i, ++n) {
+        if(test_pack(&pack_cases[i])) status = 1;
+    }
+    for(size_t i = 0; i < sizeof(number_cases) / sizeof(*number_cases); ++i, ++n) {
+        if(test_number(&number_cases[i])) status = 1;
+    }
+
+    /* strings that need escaping stay valid after the callback returns */
+    Json_Auto_Value json = {0};
+    if(json_auto_parse(so("{\"keep\":\"a\\\"b\",\"list\":[1,-2,0.5,\"c\\nd\",{\"other\":\"x\"}]}"), &json)) ABORT("invalid json");
+    So pack = SO;
+    json_auto_fmt_pack(&pack, &json, JSON_PACK_CBOR);
+    Json_Parser parser;
+    json_parser_init(&parser, 0);
+    Pack_Events events = {0};
+    if(json_parser_parse_pack(&parser, pack, JSON_PACK_CBOR, pack_events, &events)
+            || events.strings != 3 || events.numbers != 3 || so_cmp(events.kept, so("a\\\"b"))) {
+        printff(F("INVALID", FG_RD_B) " cbor events");
+        status = 1;
+    }
+    ++n;
+    json_parser_free(&parser);
+    json_auto_free(&json);
+    so_free(&pack);
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu cbor and msgpack cases", n);
+    }
+    return status;
+}
+
@@ -0,0 +1,183 @@
+#include <math.h>
+#include <stdlib.h>
+#include "../rljson/rljson-auto.h"
+#include "../rljson/rljson-bin.h"
+#include "../rljson/rljson-pack.h"
+
+typedef struct Packed_Case {
+    const char *input;
+    const char *kinds; /* per array in document order: 's'izes, 'd'oubles or 'a'rray */
+} Packed_Case;
+
+static Packed_Case packed_cases[] = {
+    { "[1,2,3]", "s" },
+    { "[0.5, -1, 2e3, -0.0]", "d" },
+    { "[1, 2.5]", "a" },
+    { "[2.5, 1]", "a" },
+    { "[1, \"x\"]", "a" },
+    { "[1, [2, 3]]", "as" },
+    { "[[1, 2], [3.5], [], [true], [4, {}]]", "asdaaa" },
+    { "{\"a\": [1, 2], \"b\": {\"c\": [0.25, 1e-9]}}", "sd" },
+    { "[18446744073709551615, 0]", "s" },
+    { "[18446744073709551616, 0.1]", "d" },
+    { "[1e400, 1]", "a" },
+};
+
+/* kinds of all arrays, depth first */
+static void packed_kinds(Json_Auto_Value *v, So *out) {
+    switch(v->id) {
+        case JSON_AUTO_VALUE_SIZES: so_push(out, 's'); break;
+        case JSON_AUTO_VALUE_DOUBLES: so_push(out, 'd'); break;
+        case JSON_AUTO_VALUE_ARRAY: {
+            so_push(out, 'a');
+            for(size_t i = 0; i < array_len(v->arr); ++i) packed_kinds(array_it(v->arr, i), out);
+        } break;
+        case JSON_AUTO_VALUE_OBJECT: {
+            for(size_t i = 0; i < array_len(v->dict); ++i) packed_kinds(&array_it(v->dict, i)->val, out);
+        } break;
+        default: break;
+    }
+}
+
+/* unpack everything, level by level */
+static void packed_unpack_all(Json_Auto_Value *v) {
+    json_auto_materialize(v);
+    for(size_t i = 0; i < json_auto_len(v); ++i) packed_unpack_all(json_auto_at(v, i));
+}
+
+/* packed or not, every way out of a tree has to look the same */
+static int test_packed(Packed_Case *c) {
+    int result = 0;
+    Json_Auto_Value packed = {0}, plain = {0}, unpacked = {0}, snapshot = {0};
+    So kinds = SO, a = SO, b = SO, bin = SO;
+    Json_Auto_Fmt compact = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    if(json_auto_parse_ext(so_l(c->input), &plain, &settings)) ABORT("invalid input: %s", c->input);
+    settings.pack = true;
+    if(json_auto_parse_ext(so_l(c->input), &packed, &settings)) ABORT("invalid input: %s", c->input);
+    if(json_auto_parse_ext(so_l(c->input), &unpacked, &settings)) ABORT("invalid input: %s", c->input);
+    packed_kinds(&packed, &kinds);
+    if(so_cmp(kinds, so_l(c->kinds))) result = -1;
+    /* not without .pack */
+    so_clear(&kinds);
+    packed_kinds(&plain, &kinds);
+    if(so_len(kinds) != strlen(c->kinds) || memchr(so_it0(kinds), 's', so_len(kinds)) || memchr(so_it0(kinds), 'd', so_len(kinds))) result = -1;
+    uint64_t hash = json_auto_hash(&packed);
+    if(json_auto_hash(&plain) != hash) result = -1;
+    packed_unpack_all(&unpacked);
+    if(json_auto_hash(&unpacked) != hash || !json_auto_eq(&unpacked, &plain)) result = -1;
+    if(!json_auto_eq(&packed, &plain) || !json_auto_eq(&plain, &packed)) result = -1;
+    json_auto_fmt(&a, packed, 0);
+    json_auto_fmt(&b, plain, 0);
+    if(so_cmp(a, b)) result = -1;
+    so_clear(&a); so_clear(&b);
+    json_auto_fmt(&a, packed, &compact);
+    json_auto_fmt(&b, plain, &compact);
+    if(so_cmp(a, b)) result = -1;
+    so_clear(&a); so_clear(&b);
+    json_auto_fmt_canonical(&a, &packed);
+    json_auto_fmt_canonical(&b, &plain);
+    if(so_cmp(a, b)) result = -1;
+    so_clear(&a); so_clear(&b);
+    json_auto_fmt_pack(&a, &packed, JSON_PACK_CBOR);
+    json_auto_fmt_pack(&b, &plain, JSON_PACK_CBOR);
+    if(so_cmp(a, b)) result = -1;
+    json_auto_fmt_bin(&bin, &packed);
+    if(json_auto_from_bin(bin, &snapshot) || !json_auto_eq(&snapshot, &plain)) result = -1;
+    /* formatting left the packed tree packed */
+    so_clear(&kinds);
+    packed_kinds(&packed, &kinds);
+    if(so_cmp(kinds, so_l(c->kinds))) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " packed: %s, arrays %.*s, expect %s", c->input, SO_F(kinds), c->kinds);
+    }
+    json_auto_free(&packed);
+    json_auto_free(&plain);
+    json_auto_free(&unpacked);
+    json_auto_free(&snapshot);
+    so_free(&kinds);
+    so_free(&a);
+    so_free(&b);
+    so_free(&bin);
+    return result;
+}
+
+/* numbers converted in auto have to come out as strtod has them */
+static int test_number(const char *text) {
+    int result = 0;
+    Json_Auto_Value json = {0};
+    So input = SO;
+    so_fmt(&input, "[%s]", text);
+    if(json_auto_parse(input, &json)) ABORT("invalid input: %s", text);
+    Json_Auto_Value *v = json_auto_at(&json, 0);
+    double expect = strtod(text, 0);
+    if(v->id == JSON_AUTO_VALUE_DOUBLE) {
+        if(memcmp(&v->f, &expect, sizeof(expect))) result = -1;
+    } else if(v->id == JSON_AUTO_VALUE_SIZE) {
+        if(strchr(text, '.') || strchr(text, 'e') || strchr(text, '-') || (double)v->z != expect) result = -1;
+    } else if(v->id != JSON_AUTO_VALUE_STRING || isfinite(expect)) {
+        result = -1;
+    }
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " number: %s, got kind %u", text, v->id);
+    }
+    json_auto_free(&json);
+    so_free(&input);
+    return result;
+}
+
+static const char *numbers[] = {
+    "0", "-0", "-0.0", "0.1", "0.3", "1e22", "1e23", "-1e-22", "123456789012345678",
+    "9007199254740993", "9007199254740993.0", "9007199254740992e-5", "4.35", "2.2250738585072014e-308",
+    "5e-324", "1.7976931348623157e308", "1e400", "-1e400", "18446744073709551615", "18446744073709551616",
+    "0.000000000000000000001", "1234567890123456789e-3", "12345678901234567890e-3", "1E+2", "3.0e-0",
+};
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < sizeof(packed_cases) / sizeof(*packed_cases); ++i, ++n) {
+        if(test_packed(&packed_cases[i])) status = 1;
+    }
+    for(size_t i = 0; i < sizeof(numbers) / sizeof(*numbers); ++i, ++n) {
+        if(test_number(numbers[i])) status = 1;
+    }
+
+    /* random digits, dots and exponents */
+    srand(1);
+    for(size_t i = 0; i < 20000; ++i, ++n) {
+        char text[64];
+        int len = 0;
+        if(rand() % 2) text[len++] = '-';
+        int digits = 1 + rand() % 20;
+        for(int j = 0; j < digits; ++j) text[len++] = (char)((j || digits == 1 ? '0' : '1') + rand() % (j || digits == 1 ? 10 : 9));
+        if(rand() % 2) {
+            text[len++] = '.';
+            for(int j = 1 + rand() % 8; j; --j) text[len++] = (char)('0' + rand() % 10);
+        }
+        if(rand() % 2) len += snprintf(text + len, sizeof(text) - len, "e%d", rand() % 60 - 30);
+        text[len] = 0;
+        if(test_number(text)) status = 1;
+    }
+
+    /* reading leaves it packed, editing unpacks first */
+    Json_Auto_Value json = {0}, tmp;
+    size_t len = 0;
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.pack = true;
+    if(json_auto_parse_ext(so("[1,2,3]"), &json, &settings)) ABORT("invalid input");
+    if(!json_auto_sizes(&json, &len) || len != 3 || json_auto_doubles(&json, 0)) status = 1;
+    if(json_auto_len(&json) != 3 || json.id != JSON_AUTO_VALUE_SIZES) status = 1;
+    if(json_auto_at(&json, 1) || json_auto_element(&json, 1, &tmp) != &tmp || tmp.z != 2 || json_auto_element(&json, 3, &tmp)) status = 1;
+    if(json.id != JSON_AUTO_VALUE_SIZES) status = 1;
+    if(json_auto_arr_insert(&json, 1, (Json_Auto_Value){ .id = JSON_AUTO_VALUE_NULL })) status = 1;
+    if(json.id != JSON_AUTO_VALUE_ARRAY || json_auto_len(&json) != 4 || json_auto_at(&json, 3)->z != 3) status = 1;
+    json_auto_free(&json);
+    ++n;
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu packed array cases", n);
+    }
+    return status;
+}
+
@@ -0,0 +1,242 @@
+#include "../rljson/rljson-patch.h"
+
+typedef struct Patch_Case {
+    const char *doc;
+    const char *patch;
+    const char *expect; /* 0 -> patch has to fail */
+} Patch_Case;
+
+/* RFC 6902, appendix A */
+static Patch_Case patch_cases[] = {
+    { "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\"}]", "{\"baz\":\"qux\",\"foo\":\"bar\"}" },
+    { "{\"foo\":[\"bar\",\"baz\"]}", "[{\"op\":\"add\",\"path\":\"/foo/1\",\"value\":\"qux\"}]", "{\"foo\":[\"bar\",\"qux\",\"baz\"]}" },
+    { "{\"baz\":\"qux\",\"foo\":\"bar\"}", "[{\"op\":\"remove\",\"path\":\"/baz\"}]", "{\"foo\":\"bar\"}" },
+    { "{\"foo\":[\"bar\",\"qux\",\"baz\"]}", "[{\"op\":\"remove\",\"path\":\"/foo/1\"}]", "{\"foo\":[\"bar\",\"baz\"]}" },
+    { "{\"baz\":\"qux\",\"foo\":\"bar\"}", "[{\"op\":\"replace\",\"path\":\"/baz\",\"value\":\"boo\"}]", "{\"baz\":\"boo\",\"foo\":\"bar\"}" },
+    { "{\"foo\":{\"bar\":\"baz\",\"waldo\":\"fred\"},\"qux\":{\"corge\":\"grault\"}}",
+      "[{\"op\":\"move\",\"from\":\"/foo/waldo\",\"path\":\"/qux/thud\"}]",
+      "{\"foo\":{\"bar\":\"baz\"},\"qux\":{\"corge\":\"grault\",\"thud\":\"fred\"}}" },
+    { "{\"foo\":[\"all\",\"grass\",\"cows\",\"eat\"]}", "[{\"op\":\"move\",\"from\":\"/foo/1\",\"path\":\"/foo/3\"}]", "{\"foo\":[\"all\",\"cows\",\"eat\",\"grass\"]}" },
+    { "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}",
+      "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"qux\"},{\"op\":\"test\",\"path\":\"/foo/1\",\"value\":2}]",
+      "{\"baz\":\"qux\",\"foo\":[\"a\",2,\"c\"]}" },
+    { "{\"baz\":\"qux\"}", "[{\"op\":\"test\",\"path\":\"/baz\",\"value\":\"bar\"}]", 0 },
+    { "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/child\",\"value\":{\"grandchild\":{}}}]", "{\"foo\":\"bar\",\"child\":{\"grandchild\":{}}}" },
+    { "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/baz\",\"value\":\"qux\",\"xyz\":123}]", "{\"foo\":\"bar\",\"baz\":\"qux\"}" },
+    { "{\"foo\":\"bar\"}", "[{\"op\":\"add\",\"path\":\"/baz/bat\",\"value\":\"qux\"}]", 0 },
+    { "{\"/\":9,\"~1\":10}", "[{\"op\":\"test\",\"path\":\"/~01\",\"value\":10}]", "{\"/\":9,\"~1\":10}" },
+    { "{\"/\":9,\"~1\":10}", "[{\"op\":\"test\",\"path\":\"/~01\",\"value\":\"10\"}]", 0 },
+    { "{\"foo\":[\"bar\"]}", "[{\"op\":\"add\",\"path\":\"/foo/-\",\"value\":[\"abc\",\"def\"]}]", "{\"foo\":[\"bar\",[\"abc\",\"def\"]]}" },
+    /* not from the rfc */
+    { "{\"foo\":1}", "[{\"op\":\"copy\",\"from\":\"/foo\",\"path\":\"/bar\"}]", "{\"foo\":1,\"bar\":1}" },
+    { "{\"foo\":{\"bar\":1}}", "[{\"op\":\"move\",\"from\":\"/foo\",\"path\":\"/foo/bar\"}]", 0 },
+    { "{\"foo\":[1]}", "[{\"op\":\"remove\",\"path\":\"/foo/01\"}]", 0 },
+    { "{\"foo\":[1]}", "[{\"op\":\"add\",\"path\":\"/foo/2\",\"value\":2}]", 0 },
+    { "{\"a\\nb\":1}", "[{\"op\":\"replace\",\"path\":\"/a\\nb\",\"value\":\"x\\ty\"}]", "{\"a\\nb\":\"x\\ty\"}" },
+    { "[1,2]", "[{\"op\":\"replace\",\"path\":\"\",\"value\":{}}]", "{}" },
+    { "{}", "{\"op\":\"remove\",\"path\":\"/x\"}", 0 },
+};
+
+/* RFC 7396, appendix A */
+static Patch_Case merge_cases[] = {
+    { "{\"a\":\"b\"}", "{\"a\":\"c\"}", "{\"a\":\"c\"}" },
+    { "{\"a\":\"b\"}", "{\"b\":\"c\"}", "{\"a\":\"b\",\"b\":\"c\"}" },
+    { "{\"a\":\"b\"}", "{\"a\":null}", "{}" },
+    { "{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}", "{\"b\":\"c\"}" },
+    { "{\"a\":[\"b\"]}", "{\"a\":\"c\"}", "{\"a\":\"c\"}" },
+    { "{\"a\":\"c\"}", "{\"a\":[\"b\"]}", "{\"a\":[\"b\"]}" },
+    { "{\"a\":{\"b\":\"c\"}}", "{\"a\":{\"b\":\"d\",\"c\":null}}", "{\"a\":{\"b\":\"d\"}}" },
+    { "{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}", "{\"a\":[1]}" },
+    { "[\"a\",\"b\"]", "[\"c\",\"d\"]", "[\"c\",\"d\"]" },
+    { "{\"a\":\"b\"}", "[\"c\"]", "[\"c\"]" },
+    { "{\"a\":\"foo\"}", "null", "null" },
+    { "{\"a\":\"foo\"}", "\"bar\"", "\"bar\"" },
+    { "{\"e\":null}", "{\"a\":1}", "{\"e\":null,\"a\":1}" },
+    { "[1,2]", "{\"a\":\"b\",\"c\":null}", "{\"a\":\"b\"}" },
+    { "{}", "{\"a\":{\"bb\":{\"ccc\":null}}}", "{\"a\":{\"bb\":{}}}" },
+};
+
+static int test_case(Patch_Case *c, bool merge, bool lazy) {
+    int result = -1;
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    Json_Auto_Value doc = {0}, patch = {0}, expect = {0};
+    if(lazy) {
+        if(json_auto_parse_lazy(so_l(c->doc), &doc, &settings)) ABORT("invalid document: %s", c->doc);
+    } else if(json_auto_parse(so_l(c->doc), &doc)) ABORT("invalid document: %s", c->doc);
+    if(json_auto_parse(so_l(c->patch), &patch)) ABORT("invalid patch: %s", c->patch);
+    if(c->expect && json_auto_parse(so_l(c->expect), &expect)) ABORT("invalid expectation: %s", c->expect);
+    int applied = merge ? json_auto_merge_patch(&doc, &patch) : json_auto_patch(&doc, &patch);
+    /* the patch is copied into the document */
+    json_auto_free(&patch);
+    if(!c->expect) {
+        result = applied ? 0 : -1;
+    } else if(!applied && json_auto_eq(&doc, &expect)) {
+        result = 0;
+    }
+    if(result) {
+        So out = SO;
+        json_auto_fmt(&out, doc, &(Json_Auto_Fmt){0});
+        printff(F("INVALID", FG_RD_B) " %s%s: %s + %s -> %.*s", merge ? "merge" : "patch", lazy ? " (lazy)" : "", c->doc, c->patch, SO_F(out));
+        so_free(&out);
+    }
+    json_auto_free(&doc);
+    json_auto_free(&expect);
+    return result;
+}
+
+/* diffing doc against the expectation has to give a patch that gets there */
+static int test_diff(Patch_Case *c, bool pack) {
+    int result = 0;
+    Json_Auto_Value doc = {0}, expect = {0}, diff = {0}, again = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.pack = pack;
+    if(json_auto_parse_ext(so_l(c->doc), &doc, &settings)) ABORT("invalid document: %s", c->doc);
+    if(json_auto_parse_ext(so_l(c->expect), &expect, &settings)) ABORT("invalid expectation: %s", c->expect);
+    json_auto_diff(&doc, &expect, &diff);
+    if(json_auto_patch(&doc, &diff) || !json_auto_eq(&doc, &expect)) result = -1;
+    /* no hash along the patched paths may go stale */
+    json_auto_diff(&doc, &expect, &again);
+    if(json_auto_len(&again)) result = -1;
+    if(result) {
+        So out = SO;
+        json_auto_fmt(&out, diff, &(Json_Auto_Fmt){0});
+        printff(F("INVALID", FG_RD_B) " diff: %s -> %s = %.*s", c->doc, c->expect, SO_F(out));
+        so_free(&out);
+    }
+    json_auto_free(&doc);
+    json_auto_free(&expect);
+    json_auto_free(&diff);
+    json_auto_free(&again);
+    return result;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    for(int lazy = 0; lazy < 2; ++lazy) {
+        for(size_t i = 0; i < sizeof(patch_cases) / sizeof(*patch_cases); ++i, ++n) {
+            if(test_case(&patch_cases[i], false, lazy)) status = 1;
+        }
+        for(size_t i = 0; i < sizeof(merge_cases) / sizeof(*merge_cases); ++i, ++n) {
+            if(test_case(&merge_cases[i], true, lazy)) status = 1;
+        }
+    }
+
+    for(size_t i = 0; i < sizeof(patch_cases) / sizeof(*patch_cases); ++i) {
+        if(!patch_cases[i].expect) continue;
+        if(test_diff(&patch_cases[i], false)) status = 1;
+        ++n;
+    }
+    for(size_t i = 0; i < sizeof(merge_cases) / sizeof(*merge_cases); ++i, ++n) {
+        if(test_diff(&merge_cases[i], false)) status = 1;
+    }
+    Patch_Case diff_cases[] = {
+        { "[1,2,3,4,5]", 0, "[1,2,9,4,5]" },
+        { "[1,2,3,4,5]", 0, "[1,5]" },
+        { "[1,5]", 0, "[1,2,3,4,5]" },
+        { "{\"a\":[{\"x\":1},{\"y\":2}],\"b/~\":true}", 0, "{\"b/~\":false,\"a\":[{\"x\":1},{\"y\":3}]}" },
+        { "{\"a\\u0041\":1}", 0, "{\"aA\":2}" },
+        { "{\"a\":1.0}", 0, "{\"a\":1}" },
+        { "{\"v\":[1,2,3,4,5,6,7,8]}", 0, "{\"v\":[1,2,3,4,5,6,7,9]}" },
+        { "{\"v\":[0.5,1.5]}", 0, "{\"v\":[0.5,1.5,2,\"x\"]}" },
+    };
+    for(size_t i = 0; i < sizeof(diff_cases) / sizeof(*diff_cases); ++i, ++n) {
+        if(test_diff(&diff_cases[i], false)) status = 1;
+        if(test_diff(&diff_cases[i], true)) status = 1;
+    }
+
+    /* packed arrays are diffed element by element too */
+    Json_Parse_Settings packed = JSON_PARSE_SETTINGS_DEFAULT;
+    packed.pack = true;
+    Json_Auto_Value a = {0}, b = {0}, diff = {0};
+    if(json_auto_parse_ext(so("{\"v\":[1,2,3,4,5,6,7,8]}"), &a, &packed)) ABORT("invalid document");
+    if(json_auto_parse_ext(so("{\"v\":[1,2,3,4,5,6,7,9]}"), &b, &packed)) ABORT("invalid document");
+    json_auto_diff(&a, &b, &diff);
+    Json_Auto_Value *path = json_auto_len(&diff) == 1 ? json_auto_get(json_auto_at(&diff, 0), so("path")) : 0;
+    if(!path || so_cmp(path->so, so("/v/7")) || !json_auto_sizes(json_auto_get(&a, so("v")), 0)) {
+        printff(F("INVALID", FG_RD_B) " packed diff");
+        status = 1;
+    }
+    json_auto_free(&a);
+    json_auto_free(&b);
+    json_auto_free(&diff);
+    ++n;
+
+    /* test and copy only read, packed elements included */
+    if(json_auto_parse_ext(so("{\"v\":[1,2,3]}"), &a, &packed)) ABORT("invalid document");
+    if(json_auto_parse(so("[{\"op\":\"test\",\"path\":\"/v/1\",\"value\":2},{\"op\":\"copy\",\"from\":\"/v/2\",\"path\":\"/w\"}]"), &b)) ABORT("invalid patch");
+    Json_Auto_Value *w = json_auto_patch(&a, &b) ? 0 : json_auto_get(&a, so("w"));
+    if(!w || w->z != 3 || !json_auto_sizes(json_auto_get(&a, so("v")), 0)) {
+        printff(F("INVALID", FG_RD_B) " packed test, copy");
+        status = 1;
+    }
+    json_auto_free(&a);
+    json_auto_free(&b);
+    ++n;
+
+    /* the hash of the top follows an edit further down, made through
+     * json_auto_materialize on the way or through a pointer */
+    if(json_auto_parse(so("{\"a\":{\"b\":[1]}}"), &a)) ABORT("invalid document");
+    if(json_auto_parse(so("{\"a\":{\"b\":[1,2]}}"), &b)) ABORT("invalid document");
+    uint64_t before = json_auto_hash(&a);
+    if(json_auto_arr_insert(json_auto_get(json_auto_materialize(json_auto_get(json_auto_materialize(&a), so("a"))), so("b")), 1, (Json_Auto_Value){ .z = 2, .id = JSON_AUTO_VALUE_SIZE })) status = 1;
+    if(json_auto_hash(&a) == before || json_auto_hash(&a) != json_auto_hash(&b)) {
+        printff(F("INVALID", FG_RD_B) " stale hash after a nested edit");
+        status = 1;
+    }
+    if(json_auto_arr_remove(json_auto_pointer(&a, so("/a/b")), 0, 0) || json_auto_hash(&a) == json_auto_hash(&b)) {
+        printff(F("INVALID", FG_RD_B) " stale hash after an edit through a pointer");
+        status = 1;
+    }
+    /* the levels that weren't edited keep theirs */
+    Json_Auto_Value *untouched = json_auto_get(&b, so("a"));
+    if(!(untouched->flags & JSON_AUTO_FLAG_HASHED)) {
+        printff(F("INVALID", FG_RD_B) " hash not cached");
+        status = 1;
+    }
+    json_auto_free(&a);
+    json_auto_free(&b);
+    ++n;
+
+    /* equal hashes alone don't make equal values */
+    if(json_auto_parse(so("{\"a\":[1,2]}"), &a)) ABORT("invalid document");
+    if(json_auto_parse(so("{\"a\":[1,3]}"), &b)) ABORT("invalid document");
+    (void)json_auto_hash(&a);
+    (void)json_auto_hash(&b);
+    b.hash = a.hash;
+    json_auto_get(&b, so("a"))->hash = json_auto_get(&a, so("a"))->hash;
+    json_auto_diff_ext(&a, &b, &diff, true);
+    path = json_auto_len(&diff) == 1 ? json_auto_get(json_auto_at(&diff, 0), so("path")) : 0;
+    if(!path || so_cmp(path->so, so("/a/1"))) {
+        printff(F("INVALID", FG_RD_B) " confirming diff trusted a hash collision");
+        status = 1;
+    }
+    json_auto_free(&a);
+    json_auto_free(&b);
+    json_auto_free(&diff);
+    ++n;
+
+    Json_Auto_Value doc = {0};
+    if(json_auto_parse(so("{\"a\":[{\"b~/c\":[7]}],\"a~2\":1,\"a~\":2}"), &doc)) ABORT("invalid document");
+    Json_Auto_Value *seven = json_auto_pointer(&doc, so("/a/0/b~0~1c/0"));
+    if(!seven || seven->id != JSON_AUTO_VALUE_SIZE || seven->z != 7) {
+        printff(F("INVALID", FG_RD_B) " json pointer");
+        status = 1;
+    }
+    if(json_auto_pointer(&doc, so("")) != &doc || json_auto_pointer(&doc, so("/a/1")) || json_auto_pointer(&doc, so("a"))) {
+        printff(F("INVALID", FG_RD_B) " json pointer");
+        status = 1;
+    }
+    /* ~ only escapes 0 and 1, even where a key would match */
+    if(json_auto_pointer(&doc, so("/a~2")) || json_auto_pointer(&doc, so("/a~")) || json_auto_pointer(&doc, so("/a~/0"))) {
+        printff(F("INVALID", FG_RD_B) " json pointer with an invalid escape");
+        status = 1;
+    }
+    json_auto_free(&doc);
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu patches", n);
+    }
+    return status;
+}
+
@@ -0,0 +1,112 @@
+#include "../rljson/rljson-reader.h"
+#include "../rljson/rljson-auto.h"
+
+/* writes json text back from reader events */
+static int test_rebuild(Json_Reader *reader, So *out, size_t *events) {
+    Json_Reader_Event event = {0};
+    bool first = true;
+    bool after_key = false;
+    for(;;) {
+        if(json_reader_next(reader, &event)) return -1;
+        if(event.id == JSON_READER_END) return 0;
+        ++*events;
+        switch(event.id) {
+            case JSON_READER_KEY: {
+                if(!first) so_push(out, ',');
+                so_fmt(out, "\"%.*s\":", SO_F(event.val.s));
+                first = false;
+                after_key = true;
+                continue;
+            }
+            case JSON_READER_OBJECT_END: so_push(out, '}'); first = false; continue;
+            case JSON_READER_ARRAY_END: so_push(out, ']'); first = false; continue;
+            default: break;
+        }
+        if(!first && !after_key) so_push(out, ',');
+        after_key = false;
+        first = false;
+        switch(event.id) {
+            case JSON_READER_OBJECT_BEGIN: so_push(out, '{'); first = true; break;
+            case JSON_READER_ARRAY_BEGIN: so_push(out, '['); first = true; break;
+            case JSON_READER_VALUE: {
+                switch(event.val.id) {
+                    case JSON_STRING: so_fmt(out, "\"%.*s\"", SO_F(event.val.s)); break;
+                    case JSON_NUMBER: so_extend(out, event.val.s); break;
+                    case JSON_BOOL: so_extend(out, event.val.b ? so("true") : so("false")); break;
+                    case JSON_NULL: so_extend(out, so("null")); break;
+                    default: return -1;
+                }
+            } break;
+            default: return -1;
+        }
+    }
+}
+
+static int test_reader(So content, bool strict, const char *filename) {
+    int status = 0;
+    Json_Parse_Error error = {0}, error_parse = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.strict = strict;
+    settings.error = &error;
+    Json_Reader reader;
+    json_reader_init(&reader, content, &settings);
+    So rebuilt = SO;
+    size_t events = 0;
+    int result = test_rebuild(&reader, &rebuilt, &events);
+
+    /* same decision and error as the callbacks */
+    settings.error = &error_parse;
+    int result_parse = json_parse_ext(content, 0, 0, &settings);
+    if(!result != !result_parse || error.code != error_parse.code || error.offset != error_parse.offset) status = -1;
+
+    /* and the same tree */
+    if(!result) {
+        Json_Auto_Value json = {0}, json_rebuilt = {0};
+        settings.error = 0;
+        if(json_auto_parse_ext(content, &json, &settings)) status = -1;
+        if(json_auto_parse_ext(rebuilt, &json_rebuilt, &settings)) status = -1;
+        if(!json_auto_eq(&json, &json_rebuilt)) status = -1;
+        json_auto_free(&json);
+        json_auto_free(&json_rebuilt);
+        /* it stays at the end */
+        Json_Reader_Event event = {0};
+        if(json_reader_next(&reader, &event) || event.id != JSON_READER_END) status = -1;
+    } else {
+        Json_Reader_Event event = {0};
+        if(!json_reader_next(&reader, &event)) status = -1;
+    }
+    if(status) {
+        printff(F("INVALID", FG_RD_B) " reader (%s): '%s'", strict ? "strict" : "non-strict", filename);
+    }
+    so_free(&rebuilt);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    int status = 0;
+    size_t n = 0;
+    for(int i = 1; i < argc; ++i) {
+        So content = SO;
+        if(so_file_read(so_l(argv[i]), &content)) ABORT("failed reading file: '%s'", argv[i]);
+        for(int strict = 0; strict < 2; ++strict, ++n) {
+            if(test_reader(content, strict, argv[i])) status = 1;
+        }
+        so_free(&content);
+    }
+
+    /* stopping early, here after the first key */
+    Json_Reader reader;
+    Json_Reader_Event event = {0};
+    json_reader_init(&reader, so("{\"a\": [1, 2], \"b\": {}} trailing"), 0);
+    Json_Reader_List expect[] = { JSON_READER_OBJECT_BEGIN, JSON_READER_KEY };
+    for(size_t i = 0; i < sizeof(expect) / sizeof(*expect); ++i) {
+        if(json_reader_next(&reader, &event) || event.id != expect[i] || event.depth != i) status = 1;
+    }
+    if(so_cmp(event.val.s, so("a"))) status = 1;
+    ++n;
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu documents read", n);
+    }
+    return status;
+}
@@ -0,0 +1,192 @@
+#include "../rljson/rljson-patch.h"
+#include "../rljson/rljson-bin.h"
+#include "../rljson/rljson-pack.h"
+
+static const char *document =
+    "{\"meta\":{\"version\":1,\"name\":\"n\\u00e4me\"},"
+    "\"users\":[{\"id\":1,\"tags\":[\"a\",\"b\"]},{\"id\":2,\"tags\":[]},{\"id\":3,\"scores\":[0.5,1.5]}],"
+    "\"ids\":[1,2,3],\"empty\":{},\"s\\\"q\":\"x\\ny\"}";
+
+/* applied one after the other, every version a reference to the one before */
+static const char *patches[] = {
+    "[{\"op\":\"replace\",\"path\":\"/meta/version\",\"value\":2}]",
+    "[{\"op\":\"add\",\"path\":\"/users/1/tags/-\",\"value\":\"c\"}]",
+    "[{\"op\":\"remove\",\"path\":\"/users/0\"}]",
+    "[{\"op\":\"add\",\"path\":\"/ids/1\",\"value\":-1}]",
+    "[{\"op\":\"move\",\"from\":\"/users/1/scores\",\"path\":\"/scores\"}]",
+    "[{\"op\":\"copy\",\"from\":\"/meta\",\"path\":\"/empty/meta\"}]",
+    "[{\"op\":\"replace\",\"path\":\"/s\\\"q\",\"value\":{\"deep\":[[1],[2.5]]}}]",
+    "[{\"op\":\"test\",\"path\":\"/meta/name\",\"value\":\"n\\u00e4me\"}]",
+};
+
+static void fmt_all(So *out, Json_Auto_Value *v) {
+    so_clear(out);
+    json_auto_fmt(out, *v, &(Json_Auto_Fmt){0});
+    so_push(out, '|');
+    json_auto_fmt_canonical(out, v);
+    so_push(out, '|');
+    json_auto_fmt_pack(out, v, JSON_PACK_CBOR);
+}
+
+/* every version has to look like the same edits on a plain tree, and no
+ * version may change by editing another */
+static int test_versions(bool lazy) {
+    int result = 0;
+    size_t n = sizeof(patches) / sizeof(*patches);
+    Json_Auto_Value versions[sizeof(patches) / sizeof(*patches) + 1] = {0};
+    So expect[sizeof(patches) / sizeof(*patches) + 1] = {0};
+    Json_Auto_Value plain = {0};
+    So got = SO, bin = SO;
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.pack = !lazy;
+    if(json_auto_parse(so_l(document), &plain)) ABORT("invalid document");
+    if(lazy) {
+        if(json_auto_parse_lazy(so_l(document), &versions[0], &settings)) ABORT("invalid document");
+    } else if(json_auto_parse_ext(so_l(document), &versions[0], &settings)) ABORT("invalid document");
+    fmt_all(&expect[0], &plain);
+    for(size_t i = 0; i < n; ++i) {
+        Json_Auto_Value patch = {0};
+        if(json_auto_parse(so_l(patches[i]), &patch)) ABORT("invalid patch: %s", patches[i]);
+        versions[i + 1] = json_auto_ref(&versions[i]);
+        if(json_auto_patch(&versions[i + 1], &patch)) result = -1;
+        if(json_auto_patch(&plain, &patch)) result = -1;
+        fmt_all(&expect[i + 1], &plain);
+        json_auto_free(&patch);
+    }
+    for(size_t i = 0; i <= n; ++i) {
+        fmt_all(&got, &versions[i]);
+        if(so_cmp(got, expect[i])) {
+            printff(F("INVALID", FG_RD_B) " share%s: version %zu is %.*s, expect %.*s", lazy ? " (lazy)" : "", i, SO_F(got), SO_F(expect[i]));
+            result = -1;
+        }
+    }
+    /* reading leaves the shared versions alone */
+    if(versions[0].id != JSON_AUTO_VALUE_SHARED) result = -1;
+    if(!json_auto_eq(&versions[n], &plain) || json_auto_hash(&versions[n]) != json_auto_hash(&plain)) result = -1;
+    so_clear(&bin);
+    json_auto_fmt_bin(&bin, &versions[n - 1]);
+    Json_Auto_Value snapshot = {0};
+    if(json_auto_from_bin(bin, &snapshot) || !json_auto_eq(&snapshot, &versions[n - 1])) result = -1;
+    json_auto_free(&snapshot);
+    /* one edit, one operation */
+    Json_Auto_Value diff = {0};
+    json_auto_diff(&versions[0], &versions[1], &diff);
+    if(json_auto_len(&diff) != 1) result = -1;
+    json_auto_free(&diff);
+    /* branches that no edit touched are the very same */
+    Json_Auto_Value *users_0 = json_auto_get(json_auto_borrow(&versions[0]), so("users"));
+    Json_Auto_Value *users_1 = json_auto_get(json_auto_borrow(&versions[1]), so("users"));
+    if(!users_0 || !users_1 || users_0->id != JSON_AUTO_VALUE_SHARED || users_0->shared != users_1->shared) result = -1;
+    /* any order of release */
+    for(size_t i = 0; i <= n; i += 2) json_auto_free(&versions[i]);
+    for(size_t i = 1; i <= n; i += 2) {
+        fmt_all(&got, &versions[i]);
+        if(so_cmp(got, expect[i])) result = -1;
+        json_auto_free(&versions[i]);
+    }
+    for(size_t i = 0; i <= n; ++i) so_free(&expect[i]);
+    json_auto_free(&plain);
+    so_free(&got);
+    so_free(&bin);
+    return result;
+}
+
+/* clones own everything, the input may go away */
+static int test_clone(void) {
+    int result = 0;
+    So input = SO, expect = SO, got = SO;
+    Json_Auto_Value json = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.pack = true;
+    so_extend(&input, so_l(document));
+    if(json_auto_parse_ext(input, &json, &settings)) ABORT("invalid document");
+    json_auto_fmt(&expect, json, 0);
+    Json_Auto_Value clone = json_auto_clone(&json);
+    Json_Auto_Value shared = json_auto_ref(&json);
+    Json_Auto_Value clone_shared = json_auto_clone(&shared);
+    json_auto_free(&json);
+    json_auto_free(&shared);
+    memset(so_it0(input), ' ', so_len(input));
+    so_free(&input);
+    json_auto_fmt(&got, clone, 0);
+    if(so_cmp(got, expect)) result = -1;
+    so_clear(&got);
+    json_auto_fmt(&got, clone_shared, 0);
+    if(so_cmp(got, expect)) result = -1;
+    if(clone.id != JSON_AUTO_VALUE_OBJECT || clone_shared.id != JSON_AUTO_VALUE_OBJECT) result = -1;
+    /* packed arrays stay packed */
+    if(!json_auto_sizes(json_auto_get(&clone, so("ids")), 0)) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " clone: %.*s, expect %.*s", SO_F(got), SO_F(expect));
+    }
+    json_auto_free(&clone);
+    json_auto_free(&clone_shared);
+    so_free(&expect);
+    so_free(&got);
+    return result;
+}
+
+/* moving out leaves null under the same key */
+static int test_move(void) {
+    int result = 0;
+    So got = SO, key = SO;
+    Json_Auto_Value json = {0}, arr = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.pack = true;
+    if(json_auto_parse(so("{\"c\":\"d\"}"), &json)) ABORT("invalid input");
+    if(json_auto_parse_ext(so("[1,2]"), &arr, &settings)) ABORT("invalid input");
+    so_extend(&key, so("a/b"));
+    arr.flags |= JSON_AUTO_FLAG_KEY_OWNED | JSON_AUTO_FLAG_KEY_DECODED;
+    if(json_auto_dict_set(&json, key, arr)) result = -1;
+    Json_Auto_Key_Value *kv = json_auto_dict_find(&json, so("a/b"));
+    if(!kv) ABORT("key went missing");
+    Json_Auto_Value moved = json_auto_move(&kv->val);
+    if(moved.flags & (JSON_AUTO_FLAG_KEY_OWNED | JSON_AUTO_FLAG_KEY_DECODED)) result = -1;
+    if(!(kv->val.flags & JSON_AUTO_FLAG_KEY_OWNED)) result = -1;
+    if(json_auto_len(&moved) != 2 || !json_auto_sizes(&moved, 0)) result = -1;
+    json_auto_fmt(&got, json, &(Json_Auto_Fmt){0});
+    if(so_cmp(got, so("{\"c\":\"d\",\"a/b\":null}"))) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " move: %.*s", SO_F(got));
+    }
+    json_auto_free(&json);
+    json_auto_free(&moved);
+    so_free(&got);
+    return result;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    if(test_versions(false)) status = 1;
+    if(test_versions(true)) status = 1;
+    if(test_clone()) status = 1;
+    if(test_move()) status = 1;
+    n += 4;
+
+    /* scalars have nothing to share */
+    Json_Auto_Value text = { .id = JSON_AUTO_VALUE_STRING, .so = so("t") };
+    Json_Auto_Value ref = json_auto_ref(&text);
+    if(text.id != JSON_AUTO_VALUE_STRING || ref.id != JSON_AUTO_VALUE_STRING || !(ref.flags & JSON_AUTO_FLAG_OWNED)) status = 1;
+    json_auto_free(&ref);
+    ++n;
+
+    /* editing a shared level copies it, its children stay shared */
+    Json_Auto_Value json = {0};
+    if(json_auto_parse(so("[[1],{\"a\":[]}]"), &json)) ABORT("invalid input");
+    json_auto_share(&json);
+    Json_Auto_Value keep = json_auto_ref(&json);
+    struct Json_Auto_Shared *first = json_auto_borrow(&json)->arr[0].shared;
+    if(json_auto_arr_insert(&json, 0, (Json_Auto_Value){ .id = JSON_AUTO_VALUE_NULL })) status = 1;
+    if(json.id != JSON_AUTO_VALUE_ARRAY || json_auto_len(&json) != 3 || json.arr[1].shared != first) status = 1;
+    if(keep.id != JSON_AUTO_VALUE_SHARED || json_auto_len(&keep) != 2) status = 1;
+    json_auto_free(&keep);
+    json_auto_free(&json);
+    ++n;
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu sharing cases", n);
+    }
+    return status;
+}
+
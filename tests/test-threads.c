@@ -0,0 +1,306 @@
+#include <pthread.h>
+#include "../rljson/rljson-auto.h"
+#include "../rljson/rljson-pack.h"
+
+#define THREADS     8
+#define ROUNDS      200
+
+/* allocations of each thread, counted by wrapping the ones of glibc. under a
+ * sanitizer, which brings its own, nothing gets counted */
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#define STRESS_NO_COUNT
+#endif
+#endif
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__) && !defined(STRESS_NO_COUNT)
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+static _Thread_local size_t stress_allocs;
+void *malloc(size_t size) { ++stress_allocs; return __libc_malloc(size); }
+void *calloc(size_t n, size_t size) { ++stress_allocs; return __libc_calloc(n, size); }
+void *realloc(void *ptr, size_t size) { ++stress_allocs; return __libc_realloc(ptr, size); }
+#define STRESS_COUNTED  true
+#else
+static _Thread_local size_t stress_allocs;
+#define STRESS_COUNTED  false
+#endif
+
+typedef struct Stress_Sum {
+    Json_Parser *parser;
+    uint64_t hash;
+    size_t events;
+    Json_Parse_Error error;
+} Stress_Sum;
+
+typedef struct Stress_File {
+    So content;
+    So pack;        /* content as cbor, if it parses */
+    Json_Parse_Settings settings;
+    int expect;
+    uint64_t hash;
+    size_t events;
+    Json_Parse_Error error;
+    int expect_pack;
+    uint64_t hash_pack;
+    size_t events_pack;
+} Stress_File;
+
+typedef struct Stress_Thread {
+    pthread_t thread;
+    Stress_File *files;
+    size_t n_files;
+    size_t errors;
+    size_t allocating; /* documents that allocated once warmed up */
+} Stress_Thread;
+
+static void stress_hash(Stress_Sum *sum, So s) {
+    for(size_t i = 0; i < s.len; ++i) {
+        sum->hash ^= (unsigned char)s.str[i];
+        sum->hash *= 0x100000001b3ULL;
+    }
+    ++sum->events;
+}
+
+void *stress_callback(void **user, Json_Parse_Value key, Json_Parse_Value *val) {
+    Stress_Sum *sum = *(Stress_Sum **)user;
+    if(key.id == JSON_OBJECT || key.id == JSON_STRING) {
+        stress_hash(sum, json_parser_unescape(sum->parser, key.s));
+    }
+    if(val && val->id == JSON_STRING) {
+        stress_hash(sum, json_parser_unescape(sum->parser, val->s));
+    } else if(val) {
+        stress_hash(sum, json_parse_value_str(*val));
+    }
+    return stress_callback;
+}
+
+static int stress_run(Json_Parser *parser, Stress_File *file, Stress_Sum *sum) {
+    *sum = (Stress_Sum){ .parser = parser, .hash = 0xcbf29ce484222325ULL };
+    json_parser_reset(parser);
+    parser->settings = file->settings;
+    /* failing documents find out where and why, through the validator */
+    parser->settings.error = &sum->error;
+    return json_parser_parse(parser, file->content, stress_callback, sum);
+}
+
+/* the text for the callbacks gets made up here, see json_parser_parse_pack */
+static int stress_run_pack(Json_Parser *parser, Stress_File *file, Stress_Sum *sum) {
+    *sum = (Stress_Sum){ .parser = parser, .hash = 0xcbf29ce484222325ULL };
+    json_parser_reset(parser);
+    parser->settings = file->settings;
+    return json_parser_parse_pack(parser, file->pack, JSON_PACK_CBOR, stress_callback, sum);
+}
+
+void *stress_thread(void *arg) {
+    Stress_Thread *t = arg;
+    Json_Parser parser;
+    json_parser_init(&parser, 0);
+    char *scratch = 0;
+    for(size_t round = 0; round < ROUNDS; ++round) {
+        for(size_t i = 0; i < t->n_files; ++i) {
+            Stress_File *file = &t->files[i];
+            Stress_Sum sum;
+            size_t allocs = stress_allocs;
+            int result = stress_run(&parser, file, &sum);
+            if(!!result != file->expect || sum.hash != file->hash || sum.events != file->events
+                    || sum.error.code != file->error.code || sum.error.offset != file->error.offset) {
+                ++t->errors;
+            }
+            if(!!json_parser_valid(&parser, file->content) != file->expect) ++t->errors;
+            result = stress_run_pack(&parser, file, &sum);
+            if(!!result != file->expect_pack || sum.hash != file->hash_pack || sum.events != file->events_pack) {
+                ++t->errors;
+            }
+            /* by now the parser's buffers fit every document */
+            if(round > 1 && stress_allocs != allocs) ++t->allocating;
+            Json_Auto_Value json = {0};
+            if(!!json_auto_parse_parser(&parser, file->content, &json) != file->expect) {
+                ++t->errors;
+            }
+            json_auto_free(&json);
+        }
+        /* after the first round the scratch buffer has its final size */
+        if(round == 1) scratch = so_len(parser.scratch) ? so_it(parser.scratch, 0) : 0;
+        if(round > 1 && scratch && scratch != so_it(parser.scratch, 0)) {
+            ++t->errors;
+        }
+    }
+    json_parser_free(&parser);
+    return 0;
+}
+
+/* one shared document, every thread reads its own reference of it */
+typedef struct Share_Thread {
+    pthread_t thread;
+    Json_Auto_Value ref;
+    Json_Auto_Value plain; /* the same document, parsed by this thread alone */
+    So expect;
+    size_t errors;
+} Share_Thread;
+
+static size_t share_walk(Json_Auto_Value *val, Json_Auto_Value *plain) {
+    size_t errors = 0;
+    if(json_auto_hash(val) != json_auto_hash(plain) || !json_auto_eq(val, plain)) ++errors;
+    if(json_auto_len(val) != json_auto_len(plain)) return errors + 1;
+    for(size_t i = 0; i < json_auto_len(val); ++i) {
+        So key = json_auto_key(val, i);
+        if(so_cmp(key, json_auto_key(plain, i))) ++errors;
+        Json_Auto_Value *sub = json_auto_at(val, i), *sub_plain = json_auto_at(plain, i);
+        /* by key, unless it would need decoding */
+        if(key.len && !memchr(key.str, '\\', key.len)) {
+            sub = json_auto_get(val, key);
+            sub_plain = json_auto_get(plain, key);
+        }
+        if(!sub || !sub_plain) return errors + 1;
+        errors += share_walk(sub, sub_plain);
+    }
+    return errors;
+}
+
+void *share_thread(void *arg) {
+    Share_Thread *t = arg;
+    So got = SO;
+    for(size_t round = 0; round < ROUNDS / 10; ++round) {
+        t->errors += share_walk(json_auto_borrow(&t->ref), &t->plain);
+        so_clear(&got);
+        json_auto_fmt(&got, t->ref, &(Json_Auto_Fmt){0});
+        if(so_cmp(got, t->expect)) ++t->errors;
+    }
+    /* the last one to let go frees the document */
+    json_auto_free(&t->ref);
+    so_free(&got);
+    return 0;
+}
+
+/* frozen levels hold nothing but frozen children */
+static bool share_frozen(Json_Auto_Value *val) {
+    if(val->id == JSON_AUTO_VALUE_ARRAY || val->id == JSON_AUTO_VALUE_OBJECT) return false;
+    if(val->id != JSON_AUTO_VALUE_SHARED) return true;
+    for(size_t i = 0; i < json_auto_len(val); ++i) {
+        if(!share_frozen(json_auto_at(val, i))) return false;
+    }
+    return true;
+}
+
+static int share_run(So content) {
+    int status = 0;
+    Json_Auto_Value json = {0};
+    if(json_auto_parse(content, &json)) {
+        json_auto_free(&json);
+        return 0;
+    }
+    json_auto_share(&json);
+    Share_Thread threads[THREADS] = {0};
+    for(size_t i = 0; i < THREADS; ++i) {
+        threads[i].ref = json_auto_ref(&json);
+        if(json_auto_parse(content, &threads[i].plain)) ABORT("document parsed once only");
+        json_auto_fmt(&threads[i].expect, threads[i].plain, &(Json_Auto_Fmt){0});
+    }
+    for(size_t i = 0; i < THREADS; ++i) {
+        if(pthread_create(&threads[i].thread, 0, share_thread, &threads[i])) ABORT("failed creating thread");
+    }
+    for(size_t i = 0; i < THREADS; ++i) {
+        pthread_join(threads[i].thread, 0);
+        if(threads[i].errors) {
+            printff(F("INVALID", FG_RD_B) " shared reads, thread %zu: %zu mismatching results", i, threads[i].errors);
+            status = 1;
+        }
+        json_auto_free(&threads[i].plain);
+        so_free(&threads[i].expect);
+    }
+    if(!share_frozen(&json)) {
+        printff(F("INVALID", FG_RD_B) " shared reads unshared the document");
+        status = 1;
+    }
+    json_auto_free(&json);
+    return status;
+}
+
+/* content is taken over by files, twice: non-strict and strict */
+static void stress_add(Stress_File **files, So content) {
+    So pack = SO;
+    Json_Auto_Value json = {0};
+    if(!json_auto_parse(content, &json)) json_auto_fmt_pack(&pack, &json, JSON_PACK_CBOR);
+    json_auto_free(&json);
+    for(int strict = 0; strict < 2; ++strict) {
+        Stress_File file = {
+            .content = content,
+            .pack = pack,
+            /* the strict ones also check keys and widths, in the parser's buffers */
+            .settings = {
+                .strict = strict,
+                .duplicates = strict ? JSON_DUPLICATES_REJECT : JSON_DUPLICATES_ALLOW,
+                .limits.width = strict ? 4096 : 0,
+            },
+        };
+        /* reference result, single threaded */
+        Json_Parser parser;
+        Stress_Sum sum;
+        json_parser_init(&parser, 0);
+        file.expect = !!stress_run(&parser, &file, &sum);
+        file.hash = sum.hash;
+        file.events = sum.events;
+        file.error = sum.error;
+        file.expect_pack = !!stress_run_pack(&parser, &file, &sum);
+        file.hash_pack = sum.hash;
+        file.events_pack = sum.events;
+        json_parser_free(&parser);
+        array_push(*files, file);
+    }
+}
+
+int main(int argc, char **argv) {
+    if(argc <= 1) ABORT("no files given to test");
+
+    int status = 0;
+    Stress_File *files = 0;
+    for(int i = 1; i < argc; ++i) {
+        So filename = so_l(argv[i]);
+        So content = SO;
+        if(so_file_read(filename, &content)) ABORT("failed reading file: '%.*s'", SO_F(filename));
+        stress_add(&files, content);
+    }
+    /* numbers and escapes enough for several chunks of made up text */
+    So generated = SO;
+    so_push(&generated, '[');
+    for(size_t i = 0; i < 400; ++i) so_fmt(&generated, "%s%zu,%.3f,\"q\\\"%zu\"", i ? "," : "", i * 7919, (double)i / 7.0, i);
+    so_push(&generated, ']');
+    stress_add(&files, generated);
+
+    Stress_Thread threads[THREADS] = {0};
+    for(size_t i = 0; i < THREADS; ++i) {
+        threads[i].files = files;
+        threads[i].n_files = array_len(files);
+        if(pthread_create(&threads[i].thread, 0, stress_thread, &threads[i])) ABORT("failed creating thread");
+    }
+    for(size_t i = 0; i < THREADS; ++i) {
+        pthread_join(threads[i].thread, 0);
+        if(threads[i].errors) {
+            printff(F("INVALID", FG_RD_B) " thread %zu: %zu mismatching results", i, threads[i].errors);
+            status = 1;
+        }
+        if(threads[i].allocating) {
+            printff(F("INVALID", FG_RD_B) " thread %zu: %zu documents allocated with a warmed up parser", i, threads[i].allocating);
+            status = 1;
+        }
+    }
+    for(size_t i = 0; i < array_len(files); i += 2) {
+        if(share_run(array_it(files, i)->content)) status = 1;
+    }
+    if(share_run(so("{\"x\":{\"y\":{\"z\":[1,2]}},\"k\\u0065y\":[{\"a\":null}]}"))) status = 1;
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %u threads x %u rounds x %zu documents, %zu shared, allocations %s", THREADS, ROUNDS,
+                array_len(files), array_len(files) / 2 + 1, STRESS_COUNTED ? "counted" : "not counted");
+    }
+
+    for(size_t i = 0; i < array_len(files); i += 2) {
+        so_free(&array_it(files, i)->content);
+        so_free(&array_it(files, i)->pack);
+    }
+    array_free(files);
+
+    return status;
+}
+
@@ -0,0 +1,132 @@
+#include "../rljson/rljson-auto.h"
+#include "../rljson/rljson-valid.h"
+
+typedef struct Unescape_Case {
+    const char *input;
+    const char *expect;
+    size_t expect_len;
+    int malformed;
+} Unescape_Case;
+
+#define UNESCAPE_CASE(input, expect, malformed)     { input, expect, sizeof(expect) - 1, malformed }
+
+static Unescape_Case unescape_cases[] = {
+    UNESCAPE_CASE("", "", 0),
+    UNESCAPE_CASE("plain text without escapes", "plain text without escapes", 0),
+    UNESCAPE_CASE("\\\"\\\\\\/\\b\\f\\n\\r\\t\\'", "\"\\/\b\f\n\r\t'", 0),
+    UNESCAPE_CASE("a\\u0041b\\u00e9c\\u20ACd", "aAb\xc3\xa9" "c\xe2\x82\xac" "d", 0),
+    UNESCAPE_CASE("\\u4F60\\u597d\\u4e16\\u754C", "\xe4\xbd\xa0\xe5\xa5\xbd\xe4\xb8\x96\xe7\x95\x8c", 0),
+    UNESCAPE_CASE("\\ud83d\\ude00\\uD83D\\uDE4F!", "\xf0\x9f\x98\x80\xf0\x9f\x99\x8f!", 0),
+    UNESCAPE_CASE("a\\u0000b", "a\0b", 0),
+    /* unpaired surrogates */
+    UNESCAPE_CASE("\\ud83dx", "\xef\xbf\xbdx", 1),
+    UNESCAPE_CASE("\\ud83d", "\xef\xbf\xbd", 1),
+    UNESCAPE_CASE("\\ud83d\\u0041", "\xef\xbf\xbd" "A", 1),
+    UNESCAPE_CASE("\\ud83d\\ud83d\\ude00", "\xef\xbf\xbd\xf0\x9f\x98\x80", 1),
+    UNESCAPE_CASE("\\ude00\\ud83d", "\xef\xbf\xbd\xef\xbf\xbd", 2),
+    UNESCAPE_CASE("\\ud83d\\n", "\xef\xbf\xbd\n", 1),
+    /* not json, still no crash and no growth */
+    UNESCAPE_CASE("\\u12", "12", 1),
+    UNESCAPE_CASE("\\u12g4", "12g4", 1),
+    UNESCAPE_CASE("\\q", "", 1),
+    UNESCAPE_CASE("end\\", "end", 1),
+    UNESCAPE_CASE("\\ud83d\\u12", "\xef\xbf\xbd" "12", 2),
+};
+
+typedef struct Surrogate_Case {
+    const char *input;
+    size_t offset; /* of the rejected escape, 0 -> accepted */
+} Surrogate_Case;
+
+static Surrogate_Case surrogate_cases[] = {
+    { "[\"\\ud83d\\ude00\"]", 0 },
+    { "[\"\\u00e4\\\\ud800\"]", 0 },
+    { "[\"\\ud800\"]", 2 },
+    { "[\"ab\\ude00\"]", 4 },
+    { "[\"\\ud83d\\u0041\"]", 2 },
+    { "[\"\\ud83d\\ud83d\\ude00\"]", 2 },
+    { "[\"\\ud83d\\ude00\\ude00\"]", 14 },
+    { "{\"\\uDBFF\":1}", 2 },
+    { "{\"a\":\"\\uDBFF\\uDFFF\"}", 0 },
+};
+
+/* with .reject_surrogates the parser and the validator refuse what
+ * json_fix_so would have to replace, at the same place */
+static int test_surrogates(Surrogate_Case *c) {
+    int result = 0;
+    Json_Parse_Error error = {0}, error_valid = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.reject_surrogates = true;
+    settings.error = &error;
+    So input = SO;
+    so_extend(&input, so_l(c->input));
+    Json_Auto_Value json = {0};
+    int parsed = json_auto_parse_insitu(input, &json, &settings);
+    json_auto_free(&json);
+    settings.error = &error_valid;
+    int valid = json_valid(so_l(c->input), &settings);
+    bool accept = !c->offset;
+    if(!parsed != accept || !valid != accept) result = -1;
+    if(!accept && (error.code != JSON_ERROR_SURROGATE || error.offset != c->offset)) result = -1;
+    if(!accept && (error_valid.code != JSON_ERROR_SURROGATE || error_valid.offset != c->offset)) result = -1;
+    /* off by default */
+    settings = (Json_Parse_Settings)JSON_PARSE_SETTINGS_DEFAULT;
+    if(json_valid(so_l(c->input), &settings)) result = -1;
+    if(result) {
+        printff(F("INVALID", FG_RD_B) " surrogates: %s -> %i %s at %zu, valid %i %s at %zu", c->input,
+                parsed, json_parse_error_str(error.code), error.offset, valid, json_parse_error_str(error_valid.code), error_valid.offset);
+    }
+    so_free(&input);
+    return result;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < sizeof(unescape_cases) / sizeof(*unescape_cases); ++i, ++n) {
+        Unescape_Case *c = &unescape_cases[i];
+        So fix = SO;
+        so_extend(&fix, so_l(c->input));
+        So expect = so_ll(c->expect, c->expect_len);
+        int malformed = json_fix_so(fix, &fix);
+        if(so_cmp(fix, expect) || malformed != c->malformed) {
+            printff(F("INVALID", FG_RD_B) " unescape: '%s', %i malformed (expect %i)", c->input, malformed, c->malformed);
+            status = 1;
+        }
+        /* piece by piece, the same text */
+        So raw = so_l(c->input), piece = SO, pieces = SO;
+        char buf[4];
+        while(json_fix_next(&raw, buf, &piece)) so_extend(&pieces, piece);
+        if(so_cmp(pieces, expect)) {
+            printff(F("INVALID", FG_RD_B) " unescape pieces: '%s'", c->input);
+            status = 1;
+        }
+        so_free(&pieces);
+        so_free(&fix);
+    }
+
+    /* escapes at every offset around long plain runs */
+    for(size_t run = 0; run < 70; ++run, ++n) {
+        So fix = SO, expect = SO;
+        for(size_t k = 0; k < 3; ++k) {
+            for(size_t r = 0; r < run; ++r) so_push(&fix, 'a' + (char)(r % 26)), so_push(&expect, 'a' + (char)(r % 26));
+            so_extend(&fix, so("\\u00e9\\n"));
+            so_extend(&expect, so("\xc3\xa9\n"));
+        }
+        if(json_fix_so(fix, &fix) || so_cmp(fix, expect)) {
+            printff(F("INVALID", FG_RD_B) " unescape run of %zu", run);
+            status = 1;
+        }
+        so_free(&fix);
+        so_free(&expect);
+    }
+
+    for(size_t i = 0; i < sizeof(surrogate_cases) / sizeof(*surrogate_cases); ++i, ++n) {
+        if(test_surrogates(&surrogate_cases[i])) status = 1;
+    }
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu unescape cases", n);
+    }
+    return status;
+}
@@ -0,0 +1,122 @@
+#include "../rljson/rljson-valid.h"
+#include "../rljson/rljson-auto.h"
+
+typedef struct Valid_Case {
+    const char *input;
+    bool strict;
+    long offset; /* -1 -> valid */
+    Json_Error_List code;
+} Valid_Case;
+
+static Valid_Case valid_cases[] = {
+    { "{}", true, -1, JSON_ERROR_NONE },
+    { " [ 1 , -0.5e+3 , \"x\" , true , false , null ] ", true, -1, JSON_ERROR_NONE },
+    { "\"top\"", false, -1, JSON_ERROR_NONE },
+    { "\"top\"", true, 0, JSON_ERROR_ROOT },
+    { "  12", true, 2, JSON_ERROR_ROOT },
+    { "", false, 0, JSON_ERROR_END },
+    { "   ", false, 3, JSON_ERROR_END },
+    { "[1,]", false, 3, JSON_ERROR_UNEXPECTED },
+    { "[1 2]", false, 3, JSON_ERROR_UNEXPECTED },
+    { "{\"a\" 1}", false, 5, JSON_ERROR_UNEXPECTED },
+    { "{\"a\":1,}", false, 7, JSON_ERROR_UNEXPECTED },
+    { "{1:2}", false, 1, JSON_ERROR_UNEXPECTED },
+    { "[01]", false, 2, JSON_ERROR_UNEXPECTED },
+    { "[1.]", false, 3, JSON_ERROR_NUMBER },
+    { "[1e]", false, 3, JSON_ERROR_NUMBER },
+    { "[-]", false, 2, JSON_ERROR_NUMBER },
+    { "[tru]", false, 1, JSON_ERROR_LITERAL },
+    { "[nul", false, 1, JSON_ERROR_LITERAL },
+    { "{} x", false, 3, JSON_ERROR_TRAILING },
+    { "[\"\\x\"]", false, 2, JSON_ERROR_ESCAPE },
+    { "[\"\\u12g4\"]", false, 2, JSON_ERROR_UNICODE_ESCAPE },
+    { "[\"abcdefghijklmno\\q\"]", false, 17, JSON_ERROR_ESCAPE },
+    { "[\"abcdefghijklmnopqrstuvwxyz", false, 28, JSON_ERROR_UNTERMINATED_STRING },
+    { "[\"a\tb\"]", false, -1, JSON_ERROR_NONE },
+    { "[\"a\tb\"]", true, 3, JSON_ERROR_CONTROL_CHARACTER },
+    { "[\"abcdefghij\nb\"]", false, 12, JSON_ERROR_CONTROL_CHARACTER },
+    { "[\"carriage\rreturn\"]", true, -1, JSON_ERROR_NONE },
+    { "[\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80 plain text after\"]", true, -1, JSON_ERROR_NONE },
+    { "[\"abcdefgh\xc3(\"]", false, 10, JSON_ERROR_UTF8 },
+    { "[\"\\ud83d\\ude00\",\"\\/\\b\\f\\n\\r\\t\\\"\\\\\"]", true, -1, JSON_ERROR_NONE },
+    { "\v[\r1\n]\t", true, -1, JSON_ERROR_NONE },
+    { "\f[]", false, 0, JSON_ERROR_UNEXPECTED },
+};
+
+static int test_valid(So input, bool strict, long offset, Json_Error_List code, const char *show) {
+    Json_Parse_Error error = {0}, error_parse = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.strict = strict;
+    settings.error = &error;
+    int result = json_valid(input, &settings) ? 0 : -1;
+    int status = 0;
+    /* same decision and error as the full parser */
+    settings.error = &error_parse;
+    if((result == -1) != !json_parse_ext(input, 0, 0, &settings)) status = -1;
+    if(error.code != error_parse.code || error.offset != error_parse.offset) status = -1;
+    if((offset < 0) != (result == -1)) status = -1;
+    if(offset >= 0 && ((size_t)offset != error.offset || code != error.code)) status = -1;
+    if(status) {
+        printff(F("INVALID", FG_RD_B) " %s %s: expect %ld, got %s at %zu", show, strict ? "strict" : "non-strict",
+                offset, result == -1 ? "valid" : json_parse_error_str(error.code), error.offset);
+    }
+    return status;
+}
+
+/* line and column only get counted when asked for */
+static int test_position(const char *input, size_t line, size_t column, const char *expected) {
+    Json_Auto_Value json = {0};
+    Json_Parse_Error error = {0};
+    Json_Parse_Settings settings = JSON_PARSE_SETTINGS_DEFAULT;
+    settings.error = &error;
+    int status = json_auto_parse_ext(so_l(input), &json, &settings) ? 0 : -1;
+    size_t l = 0, c = 0;
+    json_parse_error_position(&error, &l, &c);
+    if(l != line || c != column || !error.expected || strcmp(error.expected, expected)) status = -1;
+    if(status) {
+        printff(F("INVALID", FG_RD_B) " position: %s, got %zu:%zu expecting %s", input, l, c, error.expected);
+    }
+    json_auto_free(&json);
+    return status;
+}
+
+int main(void) {
+    int status = 0;
+    size_t n = 0;
+    for(size_t i = 0; i < sizeof(valid_cases) / sizeof(*valid_cases); ++i, ++n) {
+        Valid_Case *c = &valid_cases[i];
+        if(test_valid(so_l(c->input), c->strict, c->offset, c->code, c->input)) status = 1;
+    }
+
+    /* a special character at every position of the word wise scan */
+    for(size_t i = 0; i < 24; ++i, ++n) {
+        So input = SO;
+        so_extend(&input, so("[\""));
+        for(size_t j = 0; j < i; ++j) so_push(&input, 'a' + (char)j);
+        so_extend(&input, so("\\\"\n\"]"));
+        if(test_valid(input, false, (long)(i + 4), JSON_ERROR_CONTROL_CHARACTER, "special at")) status = 1;
+        so_free(&input);
+    }
+
+    /* JSON_DEPTH_MAX - 1 levels are fine, one more is not */
+    for(size_t extra = 0; extra < 2; ++extra, ++n) {
+        So input = SO;
+        size_t levels = JSON_DEPTH_MAX - 1 + extra;
+        for(size_t i = 0; i < levels; ++i) so_push(&input, '[');
+        for(size_t i = 0; i < levels; ++i) so_push(&input, ']');
+        if(test_valid(input, true, extra ? (long)levels - 1 : -1, extra ? JSON_ERROR_DEPTH : JSON_ERROR_NONE, "deep")) status = 1;
+        so_free(&input);
+    }
+
+    if(test_position("{\n  \"a\": [1, 2,\n        3 4]\n}", 3, 11, "',' or ']'")) status = 1;
+    if(test_position("[\"x\"\r\n", 2, 1, "',' or ']'")) status = 1;
+    if(test_position("{\"a\":1} {", 1, 9, "end of input")) status = 1;
+    if(test_position("\n\n[nul]", 3, 2, "null")) status = 1;
+    n += 4;
+
+    if(!status) {
+        printff(F("SUCCESS", FG_GN_B) " %zu validator cases", n);
+    }
+    return status;
+}
+
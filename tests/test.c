@@ -1,4 +1,52 @@
-#include "../rljson/rljson-auto.h"
+#include "../rljson/rljson-bin.h"
+#include "../rljson/rljson-pack.h"
+#include "../rljson/rljson-valid.h"
+
+/* compare strings by their decoded content */
+int test_compare_so(So a, bool a_decoded, So b, bool b_decoded) {
+    So fix_a = SO, fix_b = SO;
+    if(!a_decoded) {
+        so_extend(&fix_a, a);
+        json_fix_so(fix_a, &a);
+    }
+    if(!b_decoded) {
+        so_extend(&fix_b, b);
+        json_fix_so(fix_b, &b);
+    }
+    int cmp = so_cmp(a, b);
+    so_free(&fix_a);
+    so_free(&fix_b);
+    return cmp;
+}
+
+/* walk two trees through the accessors, so lazy values get parsed */
+int test_compare(Json_Auto_Value *a, Json_Auto_Value *b) {
+    json_auto_materialize(a);
+    json_auto_materialize(b);
+    if(a->id != b->id) return -1;
+    switch(a->id) {
+        case JSON_AUTO_VALUE_OBJECT: {
+            for(size_t i = 0; i < json_auto_len(a); ++i) {
+                if(test_compare_so(json_auto_key(a, i), json_auto_at(a, i)->flags & JSON_AUTO_FLAG_KEY_DECODED,
+                                   json_auto_key(b, i), json_auto_at(b, i)->flags & JSON_AUTO_FLAG_KEY_DECODED)) return -1;
+            }
+        } /* fall through */
+        case JSON_AUTO_VALUE_ARRAY: {
+            if(json_auto_len(a) != json_auto_len(b)) return -1;
+            for(size_t i = 0; i < json_auto_len(a); ++i) {
+                if(test_compare(json_auto_at(a, i), json_auto_at(b, i))) return -1;
+            }
+        } break;
+        case JSON_AUTO_VALUE_STRING: {
+            if(test_compare_so(a->so, a->flags & JSON_AUTO_FLAG_DECODED, b->so, b->flags & JSON_AUTO_FLAG_DECODED)) return -1;
+        } break;
+        case JSON_AUTO_VALUE_BOOL: return a->b != b->b;
+        case JSON_AUTO_VALUE_SIZE: return a->z != b->z;
+        case JSON_AUTO_VALUE_DOUBLE: return a->f != b->f;
+        default: break;
+    }
+    return 0;
+}
 
 int main(int argc, char **argv) {
     if(argc <= 1) ABORT("not given expected test result: 'fail' or 'pass'");
@@ -31,7 +79,7 @@ int main(int argc, char **argv) {
     So content = SO;
     if(so_file_read(filename, &content)) ABORT("failed reading file: '%.*s'", SO_F(filename));
 
-    Json_Auto_Value json;
+    Json_Auto_Value json = {0};
     //bool result = json_parse_valid(content);
     bool result = json_auto_parse_ext(content, &json, &settings);
     if(result != expected) {
@@ -41,6 +89,41 @@ int main(int argc, char **argv) {
         printff(F("SUCCESS %s!", FG_GN_B) " '%.*s'", result ? "FAIL" : "PASS", SO_F(filename));
     }
 
+    /* the validator decides like the full parser, in both modes */
+    for(int strict = 0; strict < 2; ++strict) {
+        Json_Parse_Settings both = settings;
+        both.strict = strict;
+        Json_Parse_Error error = {0};
+        both.error = &error;
+        bool result_valid = json_valid(content, &both);
+        Json_Parse_Error error_valid = error;
+        /* and the parser reports the same error */
+        bool result_parse = json_parse_ext(content, 0, 0, &both);
+        if(result_valid != result_parse || (result_valid && (!error.code || error.offset > so_len(content)
+                || error.code != error_valid.code || error.offset != error_valid.offset))) {
+            printff(F("INVALID validator!", FG_RD_B) " '%.*s' (%s)", SO_F(filename), strict ? "strict" : "non-strict");
+            status = 1;
+        }
+    }
+
+    /* in-situ parsing has to agree, on a copy, since it modifies its input */
+    So insitu = SO;
+    so_extend(&insitu, content);
+    Json_Auto_Value json_insitu = {0};
+    bool result_insitu = json_auto_parse_insitu(insitu, &json_insitu, &settings);
+    if(result_insitu != result || (!result && test_compare(&json, &json_insitu))) {
+        printff(F("INVALID in-situ!", FG_RD_B) " '%.*s'", SO_F(filename));
+        status = 1;
+    }
+
+    /* so does lazy parsing, once everything got accessed */
+    Json_Auto_Value json_lazy = {0};
+    bool result_lazy = json_auto_parse_lazy(content, &json_lazy, &settings);
+    if(result_lazy != result || (!result && test_compare(&json, &json_lazy))) {
+        printff(F("INVALID lazy!", FG_RD_B) " '%.*s'", SO_F(filename));
+        status = 1;
+    }
+
 #define DEBUG_OUTPUT 1
 #if DEBUG_OUTPUT
     printf("=vv-content-vv=============================================\n");
@@ -50,7 +133,45 @@ int main(int argc, char **argv) {
     printf("===========================================================\n");
 #endif
 
+    /* binary snapshots read back the same */
+    if(!result) {
+        So bin = SO;
+        Json_Auto_Value json_bin = {0};
+        json_auto_fmt_bin(&bin, &json);
+        if(json_auto_from_bin(bin, &json_bin) || test_compare(&json, &json_bin)) {
+            printff(F("INVALID binary!", FG_RD_B) " '%.*s'", SO_F(filename));
+            status = 1;
+        }
+        json_auto_free(&json_bin);
+        so_free(&bin);
+    }
+
+    /* so do cbor and msgpack, decoded directly or through the callbacks */
+    for(Json_Pack_List format = JSON_PACK_CBOR; !result && format <= JSON_PACK_MSGPACK; ++format) {
+        So pack = SO;
+        Json_Auto_Value json_pack = {0}, json_events = {0};
+        json_auto_fmt_pack(&pack, &json, format);
+        if(json_auto_from_pack(pack, &json_pack, format) || !json_auto_eq(&json, &json_pack)) {
+            printff(F("INVALID %s!", FG_RD_B) " '%.*s'", format == JSON_PACK_CBOR ? "cbor" : "msgpack", SO_F(filename));
+            status = 1;
+        }
+        Json_Parser parser;
+        json_parser_init(&parser, &settings);
+        if(json.id == JSON_AUTO_VALUE_ARRAY || json.id == JSON_AUTO_VALUE_OBJECT) json_events.id = json.id;
+        if(json_parser_parse_pack(&parser, pack, format, json_auto_parse_value, &json_events) || !json_auto_eq(&json, &json_events)) {
+            printff(F("INVALID %s events!", FG_RD_B) " '%.*s'", format == JSON_PACK_CBOR ? "cbor" : "msgpack", SO_F(filename));
+            status = 1;
+        }
+        json_parser_free(&parser);
+        json_auto_free(&json_pack);
+        json_auto_free(&json_events);
+        so_free(&pack);
+    }
+
     json_auto_free(&json);
+    json_auto_free(&json_insitu);
+    json_auto_free(&json_lazy);
+    so_free(&insitu);
     so_free(&content);
 
     return status;